@@ -0,0 +1,250 @@
+// Analysis path microbenchmark on synthetic signals.
+// Runs device-sized buffers through the same chain as the app's analyzer and reactive
+// state (InputStage -> SpscRing -> BandAnalysis hop by hop -> ReactiveState once per
+// buffer) and reports per configuration and signal:
+//   - ns per buffer (mean / p99) and the realtime factor
+//   - heap allocations per buffer from right after setup, a spectrum band count change in
+//     the warm up included (must be 0 on the audio and analysis path)
+//   - trigger timing on the kick pattern: impact hit rate, false triggers, detection delay
+//     from the kick to the end of the buffer that fired (p50 / max), beat phase error of
+//     the grid at the kick times
+//
+//   make bench        (see Makefile)
+//   ./build/analysisBench [seconds] [bufferFrames]
+
+#include "BandAnalysis.h"
+#include "InputStage.h"
+#include "ReactiveState.h"
+#include "SpscRing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// --- ALLOCATION COUNTER ---
+// Every operator new in the process, the benchmark reads the difference around its loop
+
+static std::atomic<long> allocations(0);
+
+void * operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void * p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+void * operator new[](size_t size) {
+	return operator new(size);
+}
+void operator delete(void * p) noexcept {
+	std::free(p);
+}
+void operator delete[](void * p) noexcept {
+	std::free(p);
+}
+void operator delete(void * p, size_t) noexcept {
+	std::free(p);
+}
+void operator delete[](void * p, size_t) noexcept {
+	std::free(p);
+}
+
+// --- SIGNALS ---
+
+static const double PI = 3.14159265358979323846;
+static const int RATE = 48000;
+static const double BPM = 120.0;
+
+enum Signal { SIGNAL_SINES, SIGNAL_NOISE, SIGNAL_KICKS, NUM_SIGNALS };
+static const char * SIGNAL_NAMES[NUM_SIGNALS] = { "sines", "noise", "kicks" };
+
+// Stereo, interleaved. Kicks: 150 -> 50Hz drop with an 80ms decay on every beat, plus
+// quiet hats on the off beats and a pad, so the detector has something to reject.
+static void render(Signal signal, int numFrames, vector<float> & out) {
+	out.resize((size_t)numFrames * 2);
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	int period = (int)(RATE * 60.0 / BPM);
+	for (int n = 0; n < numFrames; n++) {
+		double t = (double)n / RATE;
+		float left = 0.0f, right = 0.0f;
+		if (signal == SIGNAL_SINES) {
+			left = 0.3f * (float)(std::sin(2.0 * PI * 60.0 * t) + std::sin(2.0 * PI * 440.0 * t));
+			right = 0.3f * (float)(std::sin(2.0 * PI * 60.0 * t) + std::sin(2.0 * PI * 5000.0 * t));
+		} else if (signal == SIGNAL_NOISE) {
+			left = 0.5f * noise(rng);
+			right = 0.5f * noise(rng);
+		} else {
+			double k = (double)(n % period) / RATE;
+			float kick = (float)(0.8 * std::exp(-k / 0.08) * std::sin(2.0 * PI * (50.0 * k + 2.0 * (1.0 - std::exp(-k / 0.02)))));
+			double h = (double)((n + period / 2) % period) / RATE;
+			float hat = 0.1f * (float)std::exp(-h / 0.01) * noise(rng);
+			float pad = 0.05f * (float)std::sin(2.0 * PI * 330.0 * t);
+			left = kick + hat + pad;
+			right = kick - hat + pad;
+		}
+		out[n * 2] = left;
+		out[n * 2 + 1] = right;
+	}
+}
+
+// --- PIPELINE ---
+
+// The analyzer's path without its threads: the audio callback's part and the analysis
+// thread's part run back to back for every buffer
+struct Pipeline {
+	InputStage input;
+	BandAnalysis analysis;
+	vector<std::unique_ptr<SpscRing<float>>> rings;
+	ReactiveState reactive;
+	unsigned int onsets = 0;
+	float onsetStrength[NUM_BANDS] = {};
+	int numSpectrumBands = 32;
+
+	void setup(const AnalyzerSettings & settings) {
+		input.setup(settings.channelMode, settings.leftChannel, settings.rightChannel);
+		analysis.setup(settings, input.getNumStreams());
+		rings.clear();
+		for (int s = 0; s < input.getNumStreams(); s++) rings.push_back(std::make_unique<SpscRing<float>>(16384));
+		reactive = ReactiveState();
+		reactive.modulation.setDefaults();
+	}
+
+	void process(const float * interleaved, int numFrames, double endTime, float dt) {
+		input.process(interleaved, numFrames, 2);
+		for (int s = 0; s < (int)rings.size(); s++) rings[s]->push(input.getStream(s), numFrames);
+
+		int hop = analysis.getSettings().hopSize;
+		while (rings[0]->readAvailable() >= (size_t)hop) {
+			for (int s = 0; s < (int)rings.size(); s++) rings[s]->pop(analysis.beginHop(s), hop);
+			double windowEnd = endTime - (double)rings[0]->readAvailable() / RATE;
+			const BandFrame & frame = analysis.process(windowEnd, RATE, 1.0f, numSpectrumBands, 0.1f, 0.01f);
+			onsets |= frame.onsetMask;
+			for (int i = 0; i < NUM_BANDS; i++) onsetStrength[i] = std::max(onsetStrength[i], frame.onsetStrength[i]);
+		}
+
+		// Stepped once per buffer, like the offline analysis
+		reactive.update(analysis.getFrame(), endTime, onsets, onsetStrength, dt);
+		onsets = 0;
+		std::fill(onsetStrength, onsetStrength + NUM_BANDS, 0.0f);
+	}
+};
+
+struct Config {
+	const char * name;
+	ChannelMode mode;
+	bool multiResolution;
+};
+
+static double percentile(vector<double> values, double p) {
+	if (values.empty()) return 0.0;
+	size_t rank = std::min(values.size() - 1, (size_t)(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + rank, values.end());
+	return values[rank];
+}
+
+int main(int argc, char ** argv) {
+	double seconds = argc > 1 ? atof(argv[1]) : 30.0;
+	int bufferFrames = argc > 2 ? atoi(argv[2]) : 512;
+	int numFrames = (int)(seconds * RATE) / bufferFrames * bufferFrames;
+	int numBuffers = numFrames / bufferFrames;
+	float dt = (float)bufferFrames / RATE;
+	const double warmUp = 2.0; // Seconds excluded from timing and trigger stats
+
+	const Config configs[] = {
+		{ "mono", CHANNEL_MODE_MONO, false },
+		{ "stereo", CHANNEL_MODE_STEREO, false },
+		{ "mono multi-res", CHANNEL_MODE_MONO, true },
+	};
+
+	printf("%d frame buffers at %dHz (%.2fms), %.0fs per run, first %.0fs warm up\n\n", bufferFrames, RATE, dt * 1000.0f, seconds, warmUp);
+	printf("%-15s %-6s %9s %9s %9s %8s\n", "config", "signal", "mean ns", "p99 ns", "realtime", "allocs");
+
+	vector<float> audio[NUM_SIGNALS];
+	for (int s = 0; s < NUM_SIGNALS; s++) render((Signal)s, numFrames, audio[s]);
+
+	struct Triggers {
+		int kicks = 0, hits = 0, falseTriggers = 0;
+		vector<double> delays, phaseErrors;
+	} triggers[3];
+
+	Pipeline pipeline;
+	vector<double> times(numBuffers);
+	for (int c = 0; c < 3; c++) {
+		AnalyzerSettings settings;
+		settings.channelMode = configs[c].mode;
+		settings.multiResolution = configs[c].multiResolution;
+		settings.sampleRate = RATE;
+
+		for (int s = 0; s < NUM_SIGNALS; s++) {
+			pipeline.setup(settings);
+			Triggers & trig = triggers[c];
+			int kickPeriod = (int)(RATE * 60.0 / BPM); // Samples
+			int lastMatchedKick = -1;
+			long allocsBefore = 0;
+			int warmUpBuffers = (int)(warmUp / dt);
+			trig.delays.reserve(numBuffers); // Keep the stats out of the allocation count
+			trig.phaseErrors.reserve(numBuffers);
+
+			for (int b = 0; b < numBuffers; b++) {
+				if (b == 0) allocsBefore = allocations.load();
+				// Switching to another spectrum band count and back selects prebuilt layouts
+				if (b == warmUpBuffers / 2) pipeline.numSpectrumBands = 16;
+				if (b == warmUpBuffers) pipeline.numSpectrumBands = 32;
+				double endTime = (double)(b + 1) * bufferFrames / RATE;
+				auto start = std::chrono::steady_clock::now();
+				pipeline.process(audio[s].data() + (size_t)b * bufferFrames * 2, bufferFrames, endTime, dt);
+				times[b] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+				if (s != SIGNAL_KICKS || b < warmUpBuffers) continue;
+
+				// A trigger belongs to the newest kick if it comes within 100ms of it
+				int bufferStart = b * bufferFrames, bufferEnd = bufferStart + bufferFrames;
+				if (pipeline.reactive.impactTriggered) {
+					int kickIndex = (bufferEnd - 1) / kickPeriod;
+					double delay = (double)(bufferEnd - kickIndex * kickPeriod) / RATE;
+					if (delay < 0.1 && kickIndex != lastMatchedKick) {
+						trig.hits++;
+						trig.delays.push_back(delay * 1000.0);
+						lastMatchedKick = kickIndex;
+					} else {
+						trig.falseTriggers++;
+					}
+				}
+
+				// Beat phase error of the grid at each kick that fell in this buffer
+				for (int k = (bufferStart + kickPeriod - 1) / kickPeriod; k * kickPeriod < bufferEnd; k++) {
+					trig.kicks++;
+					const BandFrame & frame = pipeline.analysis.getFrame();
+					if (frame.beatConfidence <= 0.0f) continue;
+					double beats = frame.getBeats((double)k * kickPeriod / RATE);
+					trig.phaseErrors.push_back(std::fabs(beats - std::floor(beats + 0.5)) * 60.0 / BPM * 1000.0);
+				}
+			}
+			long allocs = allocations.load() - allocsBefore;
+
+			vector<double> measured(times.begin() + warmUpBuffers, times.end());
+			double mean = 0.0;
+			for (double t : measured) mean += t;
+			mean /= std::max<size_t>(measured.size(), 1);
+			printf("%-15s %-6s %9.0f %9.0f %8.0fx %8.3f\n", configs[c].name, SIGNAL_NAMES[s], mean, percentile(measured, 0.99), dt * 1e9 / mean,
+			       (double)allocs / std::max<size_t>(measured.size(), 1));
+		}
+	}
+
+	printf("\nkick pattern, %.0f BPM\n", BPM);
+	printf("%-15s %9s %7s %11s %11s %12s %12s\n", "config", "hit rate", "false", "delay p50", "delay max", "phase p50", "phase p99");
+	for (int c = 0; c < 3; c++) {
+		const Triggers & trig = triggers[c];
+		double maxDelay = trig.delays.empty() ? 0.0 : *std::max_element(trig.delays.begin(), trig.delays.end());
+		printf("%-15s %8.1f%% %7d %9.1fms %9.1fms %10.1fms %10.1fms\n", configs[c].name, 100.0 * trig.hits / std::max(trig.kicks, 1),
+		       trig.falseTriggers, percentile(trig.delays, 0.5), maxDelay, percentile(trig.phaseErrors, 0.5), percentile(trig.phaseErrors, 0.99));
+	}
+	return 0;
+}
@@ -0,0 +1,123 @@
+// Band reduction microbenchmark: the original per-bin branchy loop vs the precomputed
+// weight table + SIMD kernel in BandWeights.
+//
+// Standalone, no openFrameworks needed:
+//   g++ -O3 -march=native -std=c++17 -I../src bandReductionBench.cpp ../src/BandWeights.cpp -o bandReductionBench
+//   ./bandReductionBench
+
+#include "BandWeights.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// The loop audioIn used to run every callback, kept verbatim apart from the output
+static void referenceLoop(const float * analyzerBuffer, int numBins, int sampleRate, float gain, float * out) {
+	float s = 0, lm = 0, m = 0, hm = 0, t = 0;
+	float binSize = (float)sampleRate / (float)(numBins * 2);
+
+	int subCutoff = 150 / binSize;
+	int lowMidCut = 350 / binSize;
+	int midCut = 1000 / binSize;
+	int highMidCut = 4000 / binSize;
+
+	int counts[5] = { 0, 0, 0, 0, 0 };
+
+	for (int i = 0; i < numBins; i++) {
+		float tilt = 1.0f + ((float)i / (float)numBins) * 10.0f;
+		float sample = analyzerBuffer[i] * gain * 25.0f * tilt;
+
+		if (i <= subCutoff) {
+			s += sample;
+			counts[0]++;
+		} else if (i <= lowMidCut) {
+			lm += sample;
+			counts[1]++;
+		} else if (i <= midCut) {
+			m += sample;
+			counts[2]++;
+		} else if (i <= highMidCut) {
+			hm += sample;
+			counts[3]++;
+		} else {
+			t += sample;
+			counts[4]++;
+		}
+	}
+	out[0] = (s / max(1, counts[0])) * 1.0f;
+	out[1] = (lm / max(1, counts[1])) * 1.8f;
+	out[2] = (m / max(1, counts[2])) * 2.5f;
+	out[3] = (hm / max(1, counts[3])) * 4.0f;
+	out[4] = (t / max(1, counts[4])) * 6.0f;
+}
+
+template <typename F>
+static double nsPerCall(F && fn, int iterations) {
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) fn(i);
+	auto end = chrono::steady_clock::now();
+	return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+int main() {
+	const int sampleRate = 48000;
+	const float gain = 1.0f;
+	const int iterations = 200000;
+	volatile float sink = 0.0f;
+
+	printf("kernel: %s\n", BandWeights::getKernelName());
+
+	for (int fftSize : { 1024, 2048, 4096 }) {
+		int numBins = fftSize / 2 + 1;
+
+		// A handful of different spectra so the loop can't be hoisted
+		mt19937 rng(1234);
+		uniform_real_distribution<float> dist(0.0f, 0.1f);
+		vector<vector<float>> spectra(8, vector<float>(numBins));
+		for (auto & spectrum : spectra) {
+			for (auto & v : spectrum) v = dist(rng);
+		}
+
+		float ref[5];
+		double refNs = nsPerCall([&](int i) {
+			referenceLoop(spectra[i & 7].data(), numBins, sampleRate, gain, ref);
+			sink = sink + ref[0];
+		}, iterations);
+
+		BandWeights classic;
+		classic.update(sampleRate, fftSize, BandLayout::classic(), gain);
+		float out[5];
+		double tableNs = nsPerCall([&](int i) {
+			classic.reduce(spectra[i & 7].data(), out);
+			sink = sink + out[0];
+		}, iterations);
+
+		// Agreement with the original loop
+		referenceLoop(spectra[0].data(), numBins, sampleRate, gain, ref);
+		classic.reduce(spectra[0].data(), out);
+		float maxRel = 0.0f;
+		for (int b = 0; b < 5; b++) maxRel = max(maxRel, fabs(out[b] - ref[b]) / max(1e-6f, fabs(ref[b])));
+
+		printf("fft %4d  reference %8.1f ns  table %8.1f ns  speedup %5.2fx  max rel diff %.2e\n",
+			fftSize, refNs, tableNs, refNs / tableNs, maxRel);
+
+		// Cost of wider log-spaced layouts on top of the classic five
+		for (int numBands : { 16, 32, 64 }) {
+			BandLayout layout = BandLayout::classic();
+			layout.append(BandLayout::logSpaced(numBands));
+			BandWeights wide;
+			wide.update(sampleRate, fftSize, layout, gain);
+			vector<float> bands(wide.getNumBands());
+			double ns = nsPerCall([&](int i) {
+				wide.reduce(spectra[i & 7].data(), bands.data());
+				sink = sink + bands[0];
+			}, iterations);
+			printf("          5 + %2d log bands %8.1f ns\n", numBands, ns);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,493 @@
+// Tests for the OF-free core: FFT, band analysis, beat tracking, input stage, reactive
+// state, modulation, clip transport, quality governor, layer budget, frame history and the
+// lock-free ring.
+// Synthetic signals only, no files or devices. Exits non-zero if any check failed.
+//
+//   make test        (see Makefile, builds against build/libcognitoni-core.a)
+
+#include "BandAnalysis.h"
+#include "ClipTransport.h"
+#include "FrameHistory.h"
+#include "InputStage.h"
+#include "LayerBudget.h"
+#include "ModulationMatrix.h"
+#include "MovieProbe.h"
+#include "QualityGovernor.h"
+#include "ReactiveState.h"
+#include "RealFft.h"
+#include "SpscRing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static const double PI = 3.14159265358979323846;
+static const int RATE = 48000;
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, tolerance) checkNear((a), (b), (tolerance), #a, __FILE__, __LINE__)
+
+static void check(bool ok, const char * text, const char * file, int line) {
+	checks++;
+	if (ok) return;
+	failures++;
+	printf("  FAIL %s:%d: %s\n", file, line, text);
+}
+
+static void checkNear(double a, double b, double tolerance, const char * text, const char * file, int line) {
+	checks++;
+	if (std::fabs(a - b) <= tolerance) return;
+	failures++;
+	printf("  FAIL %s:%d: %s = %g, expected %g +- %g\n", file, line, text, a, b, tolerance);
+}
+
+// --- SIGNALS ---
+
+static float sine(double hz, int n, float amplitude = 1.0f) {
+	return amplitude * (float)std::sin(2.0 * PI * hz * n / RATE);
+}
+
+// An electronic kick on every beat: 150Hz dropping to 50Hz in ~20ms, 80ms decay
+static float kick(int n, double bpm) {
+	int period = (int)(RATE * 60.0 / bpm);
+	double t = (double)(n % period) / RATE;
+	double phase = 2.0 * PI * (50.0 * t + 100.0 * 0.02 * (1.0 - std::exp(-t / 0.02)));
+	return (float)(0.9 * std::exp(-t / 0.08) * std::sin(phase));
+}
+
+// Feeds numSamples of a mono signal through the analysis hop by hop, returns the last frame
+static const BandFrame & run(BandAnalysis & analysis, int numSamples, const std::function<float(int)> & signal, int & n,
+                             std::function<void(const BandFrame &)> perFrame = nullptr) {
+	int hop = analysis.getSettings().hopSize;
+	for (int end = n + numSamples; n + hop <= end;) {
+		for (int s = 0; s < analysis.getNumStreams(); s++) {
+			float * dst = analysis.beginHop(s);
+			for (int i = 0; i < hop; i++) dst[i] = signal(n + i);
+		}
+		n += hop;
+		const BandFrame & frame = analysis.process((double)n / RATE, RATE, 1.0f, 0, 0.0f, 0.0f);
+		if (perFrame) perFrame(frame);
+	}
+	return analysis.getFrame();
+}
+
+// --- TESTS ---
+
+static void testRealFft() {
+	const int size = 256;
+	RealFft fft(size);
+	CHECK(fft.getSize() == size);
+
+	// Against a plain DFT of the same Hamming windowed signal
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	vector<float> signal(size);
+	for (float & v : signal) v = noise(rng);
+	const float * amplitude = fft.transform(signal.data());
+
+	double windowSum = 0.0;
+	vector<double> window(size);
+	for (int i = 0; i < size; i++) {
+		window[i] = 0.54 - 0.46 * std::cos(2.0 * PI * i / (size - 1));
+		windowSum += window[i];
+	}
+	double maxError = 0.0;
+	for (int k = 0; k <= size / 2; k++) {
+		double re = 0.0, im = 0.0;
+		for (int i = 0; i < size; i++) {
+			re += signal[i] * window[i] * std::cos(2.0 * PI * k * i / size);
+			im -= signal[i] * window[i] * std::sin(2.0 * PI * k * i / size);
+		}
+		maxError = std::max(maxError, std::fabs(std::sqrt(re * re + im * im) * 2.0 / windowSum - amplitude[k]));
+	}
+	CHECK(maxError < 1e-4);
+
+	// A full scale sine centred on a bin reads about 1 there
+	for (int i = 0; i < size; i++) signal[i] = (float)std::sin(2.0 * PI * 16 * i / size);
+	amplitude = fft.transform(signal.data());
+	CHECK_NEAR(amplitude[16], 1.0, 0.01);
+	CHECK(amplitude[40] < 0.01f);
+}
+
+static void testBandAnalysis() {
+	AnalyzerSettings settings;
+	settings.spectrumRowBins = 32;
+	BandAnalysis analysis;
+	analysis.setup(settings, 1);
+	CHECK(analysis.getNumStreams() == 1);
+	CHECK(analysis.getSpectrumRowSize() == 32);
+
+	// Silence stays at zero and never fires
+	int n = 0;
+	unsigned int onsets = 0;
+	run(analysis, RATE / 2, [](int) { return 0.0f; }, n, [&](const BandFrame & f) { onsets |= f.onsetMask; });
+	for (int b = 0; b < NUM_BANDS; b++) CHECK(analysis.getFrame().bands[b] == 0.0f);
+	CHECK(onsets == 0);
+
+	// Each band picks up a sine in its own range
+	const double tones[NUM_BANDS] = { 60.0, 250.0, 600.0, 2000.0, 8000.0 };
+	for (int band = 0; band < NUM_BANDS; band++) {
+		analysis.setup(settings, 1);
+		n = 0;
+		const BandFrame & frame = run(analysis, RATE, [&](int i) { return sine(tones[band], i, 0.5f); }, n);
+		int loudest = (int)(std::max_element(frame.bands, frame.bands + NUM_BANDS) - frame.bands);
+		CHECK(loudest == band);
+		CHECK(frame.bands[band] > 0.0f);
+	}
+	CHECK(analysis.getFrame().sequence == (uint64_t)(RATE / settings.hopSize));
+
+	// The multi-resolution split keeps the classic bands where they were
+	settings.multiResolution = true;
+	analysis.setup(settings, 1);
+	n = 0;
+	const BandFrame & low = run(analysis, RATE, [](int i) { return sine(60.0, i, 0.5f); }, n);
+	CHECK(std::max_element(low.bands, low.bands + NUM_BANDS) - low.bands == BAND_SUB_BASS);
+}
+
+static void testBeatTracking() {
+	// 120 BPM kicks: onsets on the sub bass and a locked grid with a 0.5s period
+	AnalyzerSettings settings;
+	BandAnalysis analysis;
+	analysis.setup(settings, 1);
+	int n = 0;
+	int onsets = 0, hits = 0;
+	run(analysis, RATE * 12, [](int i) { return kick(i, 120.0); }, n, [&](const BandFrame & f) {
+		if (!(f.onsetMask & (1 << BAND_SUB_BASS))) return;
+		onsets++;
+		// Within 30ms after a kick (frame time is the end of the window)
+		double sinceKick = f.time - std::floor(f.time / 0.5) * 0.5;
+		if (sinceKick < 0.03) hits++;
+	});
+	const BandFrame & frame = analysis.getFrame();
+	CHECK(hits >= 22); // 24 kicks, the first one or two go into the threshold warm up
+	CHECK(onsets < hits * 2); // Decay tails may retrigger weakly, never on every beat
+	CHECK_NEAR(frame.beatPeriod, 0.5, 0.02);
+	CHECK(frame.beatConfidence > 0.5f);
+
+	// The grid lands on the kicks: beat phase near 0 at a kick time
+	double lastKick = std::floor((double)n / RATE / 0.5) * 0.5;
+	double beats = frame.getBeats(lastKick);
+	double phase = beats - std::floor(beats + 0.5);
+	CHECK(std::fabs(phase) < 0.1);
+}
+
+static void testChannels() {
+	// Stereo: left-only tone shows up in the left band set, the width follows the side
+	InputStage input;
+	input.setup(CHANNEL_MODE_STEREO, 0, 1);
+	CHECK(input.getNumStreams() == 3);
+	const int frames = 512;
+	vector<float> interleaved(frames * 2);
+	for (int i = 0; i < frames; i++) {
+		interleaved[i * 2] = sine(1000.0, i);
+		interleaved[i * 2 + 1] = 0.0f;
+	}
+	input.process(interleaved.data(), frames, 2);
+	CHECK_NEAR(input.getStream(1)[100], interleaved[200], 1e-6);
+	CHECK(input.getStream(2)[100] == 0.0f);
+	CHECK(input.getSideEnergy() > 0.0f);
+
+	// Identical channels have no side
+	InputStage midSide;
+	midSide.setup(CHANNEL_MODE_MID_SIDE, 0, 1);
+	for (int i = 0; i < frames; i++) interleaved[i * 2 + 1] = interleaved[i * 2];
+	midSide.process(interleaved.data(), frames, 2);
+	CHECK(midSide.getSideEnergy() < 1e-9f);
+	CHECK(midSide.getMidEnergy() > 0.0f);
+
+	AnalyzerSettings settings;
+	settings.channelMode = CHANNEL_MODE_STEREO;
+	BandAnalysis analysis;
+	analysis.setup(settings, 3);
+	int hop = settings.hopSize;
+	const BandFrame * frame = nullptr;
+	for (int n = 0; n < RATE; n += hop) {
+		float * mid = analysis.beginHop(0);
+		float * left = analysis.beginHop(1);
+		float * right = analysis.beginHop(2);
+		for (int i = 0; i < hop; i++) {
+			left[i] = sine(1000.0, n + i);
+			right[i] = 0.0f;
+			mid[i] = 0.5f * left[i];
+		}
+		frame = &analysis.process((double)(n + hop) / RATE, RATE, 1.0f, 8, 0.25f, 0.25f);
+	}
+	CHECK(frame->numChannelBandSets == 2);
+	CHECK(frame->numSpectrumBands == 8);
+	CHECK(frame->channelBands[0][BAND_MIDS] > 0.0f);
+	CHECK(frame->channelBands[1][BAND_MIDS] == 0.0f);
+	CHECK_NEAR(frame->stereoWidth, 1.0, 1e-6);
+}
+
+static void testReactiveState() {
+	ReactiveState state;
+	BandFrame frame;
+	float strength[NUM_BANDS] = { 2.5f, 0.0f, 0.0f, 0.0f, 0.0f };
+	state.update(frame, 0.0, 1 << BAND_SUB_BASS, strength, 1.0f / 60.0f);
+	CHECK(state.impactTriggered);
+	CHECK(state.strobeTriggered);
+	CHECK_NEAR(state.impactDelta, 0.7, 1e-6);
+
+	// A soft hit moves the envelope but does not flash
+	strength[BAND_SUB_BASS] = 0.5f;
+	state.update(frame, 0.0, 1 << BAND_SUB_BASS, strength, 1.0f / 60.0f);
+	CHECK(state.impactTriggered);
+	CHECK(!state.strobeTriggered);
+
+	// Releases in time, not per step: one second at 30 or at 144 fps ends up the same
+	ReactiveState slow = state, fast = state;
+	float none[NUM_BANDS] = {};
+	for (int i = 0; i < 30; i++) slow.update(frame, 0.0, 0, none, 1.0f / 30.0f);
+	for (int i = 0; i < 144; i++) fast.update(frame, 0.0, 0, none, 1.0f / 144.0f);
+	CHECK(!slow.impactTriggered);
+	CHECK_NEAR(slow.impactDelta, fast.impactDelta, 1e-5);
+	CHECK(slow.impactDelta < 0.01f);
+
+	// Beat clock from the frame's grid
+	frame.beatTime = 10.0;
+	frame.beatIndex = 20;
+	frame.beatPeriod = 0.5f;
+	state.update(frame, 10.25, 0, none, 1.0f / 60.0f);
+	CHECK_NEAR(state.beatClock, 20.5, 1e-9);
+	CHECK_NEAR(state.beatPhase, 0.5, 1e-6);
+}
+
+static void testModulation() {
+	for (int s = 0; s < NUM_MOD_SOURCES; s++) {
+		ModSource found;
+		CHECK(ModulationMatrix::findSource(ModulationMatrix::getSourceName((ModSource)s), found) && found == s);
+	}
+	for (int t = 0; t < NUM_MOD_TARGETS; t++) {
+		ModTarget found;
+		CHECK(ModulationMatrix::findTarget(ModulationMatrix::getTargetName((ModTarget)t), found) && found == t);
+	}
+	ModSource unknown;
+	CHECK(!ModulationMatrix::findSource("no such source", unknown));
+
+	// A route with a release: same value after a second at any step size
+	ModRoute route;
+	route.source = MOD_SRC_SUB_BASS;
+	route.target = MOD_DST_ZOOM;
+	route.outMax = 2.0f;
+	route.release = 0.3f;
+	ModulationMatrix a, b;
+	a.setRoutes({ route });
+	b.setRoutes({ route });
+	a.setSource(MOD_SRC_SUB_BASS, 1.0f);
+	b.setSource(MOD_SRC_SUB_BASS, 1.0f);
+	a.update(0.01f);
+	b.update(0.01f);
+	CHECK_NEAR(a.get(MOD_DST_ZOOM), ModulationMatrix::getDefaultBase(MOD_DST_ZOOM) + 2.0f, 1e-5);
+	a.setSource(MOD_SRC_SUB_BASS, 0.0f);
+	b.setSource(MOD_SRC_SUB_BASS, 0.0f);
+	for (int i = 0; i < 30; i++) a.update(1.0f / 30.0f);
+	for (int i = 0; i < 144; i++) b.update(1.0f / 144.0f);
+	CHECK_NEAR(a.get(MOD_DST_ZOOM), b.get(MOD_DST_ZOOM), 1e-4);
+	CHECK(a.get(MOD_DST_ZOOM) < ModulationMatrix::getDefaultBase(MOD_DST_ZOOM) + 0.2f);
+}
+
+static void testClipTransport() {
+	MovieInfo movie;
+	movie.fps = 30.0f;
+	movie.frameCount = 900;
+	movie.duration = 30.0f;
+	for (uint32_t k = 0; k < 900; k += 30) movie.keyframes.push_back(k);
+	CHECK(movie.isKeyframe(60));
+	CHECK(!movie.isKeyframe(61));
+	CHECK(movie.keyframeAtOrBefore(75) == 60);
+	CHECK(movie.nearestKeyframe(80) == 90);
+
+	ClipTransport transport;
+	transport.settings.jumpEveryBeats = 0;
+	transport.reset(movie, 1);
+	ClipTransport::Controls controls;
+	for (int i = 0; i < 60; i++) transport.update(1.0f / 60.0f, controls);
+	CHECK(std::abs(transport.getFrame() - 30) <= 1);
+
+	controls.rate = 2.0f;
+	for (int i = 0; i < 60; i++) transport.update(1.0f / 60.0f, controls);
+	CHECK(std::abs(transport.getFrame() - 90) <= 1);
+
+	// Reverse runs back, the plan starts at the frame on screen and never repeats
+	controls.rate = 1.0f;
+	controls.reverse = true;
+	for (int i = 0; i < 30; i++) transport.update(1.0f / 60.0f, controls);
+	CHECK(std::abs(transport.getFrame() - 75) <= 1);
+	vector<int> plan;
+	transport.predict(1.0f / 60.0f, 8, plan);
+	CHECK(!plan.empty() && plan[0] == transport.getFrame());
+	CHECK(plan.size() <= 8);
+	vector<int> sorted = plan;
+	std::sort(sorted.begin(), sorted.end());
+	CHECK(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+
+	// Locked to a beat grid, jumps land on keyframes
+	transport.settings.jumpEveryBeats = 4;
+	transport.reset(movie, 3);
+	controls = ClipTransport::Controls();
+	controls.beatLocked = true;
+	double beats = 0.0;
+	for (int i = 0; i < 60 * 10; i++) {
+		beats += 2.0 / 60.0;
+		controls.beats = beats;
+		transport.update(1.0f / 60.0f, controls);
+	}
+	CHECK(transport.getJumps() >= 3);
+}
+
+static void testQualityGovernor() {
+	QualityGovernor governor;
+	governor.reset();
+	CHECK(governor.getLevelIndex() == 0);
+
+	// 30fps against a 60fps target steps down once a window is full, and keeps stepping
+	int changes = 0;
+	for (int i = 0; i < governor.settings.window; i++) changes += governor.update(33.0f, 30.0f, 25.0f);
+	CHECK(changes == 1);
+	CHECK(governor.getLevelIndex() == 1);
+	CHECK(!governor.getReason().empty());
+	for (int i = 0; i < governor.settings.window * 10; i++) governor.update(33.0f, 30.0f, 25.0f);
+	CHECK(governor.getLevelIndex() == QualityGovernor::NUM_LEVELS - 1);
+
+	// Headroom steps back up after the hold, one level at a time
+	float seconds = 0.0f;
+	while (governor.getLevelIndex() == QualityGovernor::NUM_LEVELS - 1 && seconds < 30.0f) {
+		governor.update(16.7f, 4.0f, 3.0f);
+		seconds += 0.0167f;
+	}
+	CHECK(governor.getLevelIndex() == QualityGovernor::NUM_LEVELS - 2);
+	CHECK(seconds >= governor.settings.upHold);
+}
+
+static void testLayerBudget() {
+	const size_t MB = 1 << 20;
+	// 1080p NV12 with 8 frames decoded ahead: 3.1MB * 2 * (4 + 9) frames, about 81MB a layer
+	size_t layer1080 = LayerBudget::getLayerBytes(1080, 8, true);
+	CHECK(layer1080 > 75 * MB && layer1080 < 85 * MB);
+	CHECK(LayerBudget::getLayerBytes(1080, 8, false) == layer1080 * 2);
+	CHECK(LayerBudget::getLayerBytes(1080, 0, true) < layer1080);
+
+	// Four layers at 1080p fit 512MB, but 4K only for one
+	LayerBudget::Plan plan = LayerBudget::plan(512 * MB, 4, 8, true);
+	CHECK(plan.layers == 4);
+	CHECK(plan.maxClipHeight == 1080);
+	CHECK(plan.bytes <= 512 * MB);
+	plan = LayerBudget::plan(512 * MB, 1, 8, true);
+	CHECK(plan.layers == 1);
+	CHECK(plan.maxClipHeight == 0);
+
+	// Smaller budgets give smaller clips first, then fewer layers
+	plan = LayerBudget::plan(120 * MB, 4, 8, true);
+	CHECK(plan.layers == 4);
+	CHECK(plan.maxClipHeight == 540);
+	plan = LayerBudget::plan(50 * MB, 4, 8, true);
+	CHECK(plan.layers == 2);
+	CHECK(plan.bytes <= 50 * MB);
+
+	// An outside cap only lowers the height, nothing fitting still plans the base clip
+	plan = LayerBudget::plan(512 * MB, 2, 8, true, 720);
+	CHECK(plan.layers == 2);
+	CHECK(plan.maxClipHeight == 720);
+	plan = LayerBudget::plan(1 * MB, 4, 8, true);
+	CHECK(plan.layers == 1);
+	CHECK(plan.maxClipHeight == LayerBudget::HEIGHTS[LayerBudget::NUM_HEIGHTS - 1]);
+}
+
+static void testFrameHistory() {
+	// Live timeline: 512-sample device buffers, two hops each, reach the render thread up to
+	// 3ms after the buffer ends; 60 fps render. Band 0 counts hops, so a blend reads the time.
+	const int hop = 256;
+	const int buffer = 512;
+	const double dt = 1.0 / 60.0;
+	FrameHistory history;
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> jitter(0.0, 0.003);
+
+	int next = 1; // Next frame to publish
+	double arrival = (double)buffer / RATE + jitter(rng);
+	int renders = 0, blended = 0, blendedAtHop = 0, accurate = 0;
+	for (double now = 0.0; now < 10.0; now += dt) {
+		while (arrival <= now) {
+			for (int i = 0; i < buffer / hop; i++, next++) {
+				BandFrame frame;
+				frame.time = (double)next * hop / RATE;
+				frame.bands[0] = (float)next;
+				history.push(frame);
+			}
+			arrival = (double)next * hop / RATE + (double)(buffer - hop) / RATE + jitter(rng);
+		}
+		history.observe(now);
+		if (now < 1.0) continue; // Age settled
+
+		bool ok = false;
+		double time = (now + dt) - (dt + history.getDelay());
+		BandFrame frame = history.sample(time, &ok);
+		renders++;
+		blended += ok ? 1 : 0;
+		if (ok && std::fabs(frame.bands[0] - time * RATE / hop) < 1e-3) accurate++;
+
+		// One hop before the present time is always past the newest frame
+		history.sample((now + dt) - (double)hop / RATE, &ok);
+		blendedAtHop += ok ? 1 : 0;
+	}
+	CHECK(blended == renders);
+	CHECK(accurate == blended);
+	CHECK(blendedAtHop == 0);
+	CHECK(history.getAge() > (double)buffer / RATE && history.getAge() < (double)buffer / RATE + 0.004);
+	CHECK_NEAR(history.getDelay(), history.getAge() + (double)hop / RATE, 1e-9);
+}
+
+static void testSpscRing() {
+	SpscRing<float> ring(100);
+	CHECK(ring.capacity() >= 100);
+	vector<float> in(ring.capacity()), out(ring.capacity());
+	for (size_t i = 0; i < in.size(); i++) in[i] = (float)i;
+
+	// Wraps around many times without losing or reordering
+	size_t pushed = 0, popped = 0;
+	bool ordered = true;
+	for (int round = 0; round < 1000; round++) {
+		size_t count = ring.push(in.data(), std::min<size_t>(37, ring.writeAvailable()));
+		for (size_t i = 0; i < count; i++) in[i] = (float)(pushed + count + i);
+		pushed += count;
+		size_t got = ring.pop(out.data(), 29);
+		for (size_t i = 0; i < got; i++) ordered = ordered && out[i] == (float)(popped + i);
+		popped += got;
+	}
+	CHECK(ordered);
+	CHECK(pushed - popped == ring.readAvailable());
+}
+
+int main() {
+	struct Test {
+		const char * name;
+		void (*run)();
+	};
+	const Test tests[] = {
+		{ "RealFft", testRealFft },
+		{ "BandAnalysis", testBandAnalysis },
+		{ "BeatTracking", testBeatTracking },
+		{ "Channels", testChannels },
+		{ "ReactiveState", testReactiveState },
+		{ "Modulation", testModulation },
+		{ "ClipTransport", testClipTransport },
+		{ "QualityGovernor", testQualityGovernor },
+		{ "LayerBudget", testLayerBudget },
+		{ "FrameHistory", testFrameHistory },
+		{ "SpscRing", testSpscRing },
+	};
+	for (const Test & test : tests) {
+		int before = failures;
+		test.run();
+		printf("%-16s %s\n", test.name, failures == before ? "ok" : "FAILED");
+	}
+	printf("%d checks, %d failed\n", checks, failures);
+	return failures == 0 ? 0 : 1;
+}
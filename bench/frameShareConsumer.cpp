@@ -0,0 +1,162 @@
+// Test consumer for the shared memory frame output (Share frames toggle, FrameShare).
+// Follows the ring as a second process would, reading frames in place, and reports:
+//   - sequence continuity: frames skipped because this reader fell behind, torn reads
+//   - latency: frame drawn -> published, and drawn -> seen here (p50 / p99 / max)
+// --selftest runs a writer thread in the same process that stamps every pixel with its
+// frame number, which also proves no reader ever sees a half written frame.
+//
+// Standalone, no openFrameworks needed:
+//   g++ -O2 -std=c++17 -pthread -I../src frameShareConsumer.cpp ../src/SharedFrameRing.cpp -o frameShareConsumer -lrt
+//   ./frameShareConsumer [--name /cognitoni-frames] [--seconds 10] [--selftest]
+
+#include "SharedFrameRing.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static double percentile(vector<double> values, double p) {
+	if (values.empty()) return 0.0;
+	sort(values.begin(), values.end());
+	return values[min(values.size() - 1, (size_t)(p * (values.size() - 1) + 0.5))];
+}
+
+// --- SELF TEST WRITER ---
+// 60 fps of 640x360 frames, every byte = frame sequence & 255
+
+static void selfTestWriter(const string & name, atomic<bool> & stop, atomic<bool> & ready) {
+	const int width = 640, height = 360;
+	SharedFrameWriter writer;
+	if (!writer.open(name, 4, (size_t)width * height * 4)) {
+		printf("writer: %s\n", writer.getError().c_str());
+		ready = true;
+		return;
+	}
+	ready = true;
+	while (!stop) {
+		uint64_t drawn = SharedFrameRing::nowMicros();
+		uint8_t * pixels = writer.beginFrame();
+		memset(pixels, (int)((writer.getSequence() + 1) & 255), (size_t)width * height * 4);
+		SharedFrameRing::Frame frame;
+		frame.renderMicros = drawn;
+		frame.width = width;
+		frame.height = height;
+		frame.stride = width * 4;
+		frame.format = SharedFrameRing::FORMAT_RGBA8;
+		frame.flags = SharedFrameRing::FLAG_BOTTOM_UP;
+		writer.publish(frame);
+		this_thread::sleep_for(chrono::microseconds(16667));
+	}
+}
+
+// --- CONSUMER ---
+
+int main(int argc, char ** argv) {
+	string name = "/cognitoni-frames";
+	double seconds = 10.0;
+	bool selfTest = false;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--name" && i + 1 < argc) name = argv[++i];
+		else if (arg == "--seconds" && i + 1 < argc) seconds = atof(argv[++i]);
+		else if (arg == "--selftest") selfTest = true;
+	}
+	if (selfTest) name += "-selftest";
+
+	atomic<bool> stop { false }, ready { false };
+	thread writerThread;
+	if (selfTest) {
+		writerThread = thread(selfTestWriter, name, ref(stop), ref(ready));
+		while (!ready) this_thread::yield();
+	}
+
+	SharedFrameReader reader;
+	uint64_t deadline = SharedFrameRing::nowMicros() + (uint64_t)(seconds * 1e6);
+	while (!reader.open(name)) {
+		if (SharedFrameRing::nowMicros() > deadline) {
+			printf("%s\n", reader.getError().c_str());
+			stop = true;
+			if (writerThread.joinable()) writerThread.join();
+			return 1;
+		}
+		this_thread::sleep_for(chrono::milliseconds(100)); // Waiting for the app to share
+	}
+	printf("reading %s for %.0fs\n", name.c_str(), seconds);
+
+	uint64_t expected = 0; // Next sequence wanted, 0 = start at the newest
+	uint64_t frames = 0, skipped = 0, torn = 0, badPixels = 0, reopened = 0;
+	vector<double> publishLatency, readLatency;
+	int width = 0, height = 0;
+
+	while (SharedFrameRing::nowMicros() < deadline) {
+		if (reader.isWriterClosed()) {
+			// The app stopped sharing or changed resolution, follow it to the new segment
+			reader.close();
+			while (!reader.open(name) && SharedFrameRing::nowMicros() < deadline) this_thread::sleep_for(chrono::milliseconds(50));
+			expected = 0;
+			reopened++;
+			continue;
+		}
+		uint64_t latest = reader.getLatest();
+		if (latest == 0 || (expected != 0 && latest < expected)) {
+			this_thread::sleep_for(chrono::microseconds(500));
+			continue;
+		}
+		if (expected == 0) expected = latest;
+
+		SharedFrameRing::Frame frame;
+		if (!reader.get(expected, frame)) {
+			skipped += latest - expected; // Overwritten before we got to it, carry on from the newest
+			expected = latest;
+			continue;
+		}
+
+		// Consume in place: checksum every row, like an encoder reading the planes
+		uint64_t sum = 0;
+		for (int y = 0; y < frame.height; y++) {
+			const uint8_t * row = frame.pixels + (size_t)y * frame.stride;
+			for (int x = 0; x < frame.width * 4; x += 64) sum += row[x];
+		}
+		uint64_t mismatches = 0;
+		if (selfTest) {
+			uint8_t want = (uint8_t)(frame.sequence & 255);
+			for (int y = 0; y < frame.height; y += 7) {
+				if (frame.pixels[(size_t)y * frame.stride] != want) mismatches++;
+			}
+		}
+		uint64_t seen = SharedFrameRing::nowMicros();
+		if (!reader.isValid(frame)) {
+			torn++; // The writer lapped us while reading, the frame cannot be trusted
+			expected = frame.sequence + 1;
+			continue;
+		}
+
+		frames++;
+		badPixels += mismatches;
+		width = frame.width;
+		height = frame.height;
+		publishLatency.push_back((frame.publishMicros - frame.renderMicros) / 1000.0);
+		readLatency.push_back((seen - frame.renderMicros) / 1000.0);
+		expected = frame.sequence + 1;
+		(void)sum;
+	}
+
+	stop = true;
+	if (writerThread.joinable()) writerThread.join();
+
+	printf("%llu frames %dx%d, %llu skipped (reader behind), %llu torn, %llu reopens\n", (unsigned long long)frames, width, height,
+		   (unsigned long long)skipped, (unsigned long long)torn, (unsigned long long)reopened);
+	printf("drawn -> published  p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n", percentile(publishLatency, 0.5), percentile(publishLatency, 0.99),
+		   percentile(publishLatency, 1.0));
+	printf("drawn -> read       p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n", percentile(readLatency, 0.5), percentile(readLatency, 0.99),
+		   percentile(readLatency, 1.0));
+	if (selfTest) printf("content check: %s\n", badPixels == 0 ? "ok" : "MISMATCH");
+
+	bool ok = frames > 0 && skipped == 0 && (!selfTest || badPixels == 0);
+	return ok ? 0 : 1;
+}
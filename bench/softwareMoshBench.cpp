@@ -0,0 +1,260 @@
+// SoftwareMosh benchmark and self-check.
+// 1. Renders every style with the vector kernel and with a straight scalar transcription of
+//    shader.frag (libm math, one pixel at a time) and reports the image difference, alone
+//    and with three overlay layers, one per blend mode.
+// 2. Checks that two renders of the same frame are identical.
+// 3. Reports megapixels per second on one thread and on all of them, and per core.
+//
+// Standalone, no openFrameworks needed:
+//   g++ -O3 -march=native -std=c++17 -pthread -I../src softwareMoshBench.cpp ../src/SoftwareMosh.cpp -o softwareMoshBench
+//   ./softwareMoshBench [width height]
+
+#include "SoftwareMosh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// --- SCALAR REFERENCE ---
+// shader.frag line by line with libm, for the default view (no zoom or jitter) and RGB clips
+
+static float fract(float x) { return x - floorf(x); }
+static float mixf(float a, float b, float t) { return a + (b - a) * t; }
+static float smoothstepf(float e0, float e1, float x) {
+	float t = min(max((x - e0) / (e1 - e0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+static float randomf(float x, float y) { return fract(sinf(x * 12.9898f + y * 78.233f) * 43758.5453123f); }
+
+static float pattern(int style, float px, float py, float r, float a, float freq, float time) {
+	switch (style) {
+		case 0: return fabsf(sinf(py * freq + time) * sinf(px * freq - time));
+		case 1: return fabsf(sinf(a * 6.0f + r * 12.0f - time * 2.5f));
+		case 2: return fabsf(sinf(px * freq + time) + sinf(py * freq + time) + sinf((px + py) * freq));
+		case 3: return fabsf(cosf(a * 12.0f) * sinf(r * 15.0f - time));
+		case 4: return fabsf(sinf(logf(max(r, 0.001f)) * 8.0f - time * 3.0f));
+		case 5: return fract(sinf(px * freq + py * freq) * 10.0f + time);
+		case 6: return fabsf(sinf(r * 25.0f - time * 4.0f));
+		default: return fabsf(sinf(max(fabsf(px) - 0.2f, fabsf(py) - 0.2f) * 20.0f + time));
+	}
+}
+
+static float texel(const SoftwareMosh::Plane & plane, float u, float v, int c) {
+	float tx = u - 0.5f, ty = v - 0.5f;
+	int x0 = (int)floorf(tx), y0 = (int)floorf(ty);
+	float fx = tx - x0, fy = ty - y0;
+	auto at = [&](int x, int y) {
+		x = min(max(x, 0), plane.width - 1);
+		y = min(max(y, 0), plane.height - 1);
+		return (float)plane.data[(y * plane.width + x) * plane.channels + c];
+	};
+	float top = mixf(at(x0, y0), at(x0 + 1, y0), fx);
+	float bottom = mixf(at(x0, y0 + 1), at(x0 + 1, y0 + 1), fx);
+	return mixf(top, bottom, fy) / 255.0f;
+}
+
+static void referenceRender(const SoftwareMosh::Frame & frame, uint8_t * out, int w, int h) {
+	const ReactiveUniforms & u = frame.uniforms;
+	float resX = u.res[0], resY = u.res[1], time = u.time;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			uint8_t * pixel = out + (y * w + x) * 4;
+			float sx = (x + 0.5f) * resX / w, sy = (y + 0.5f) * resY / h;
+			if (u.numSlices > 0) {
+				int slice = min(max((int)(sy / resY * u.numSlices), 0), u.numSlices - 1);
+				sx -= u.sliceOffsets[slice];
+				if (sx < 0.0f || sx > resX) {
+					pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+					continue;
+				}
+			}
+			float uvx = sx, uvy = sy;
+			float shiverFactor = smoothstepf(u.lowThresh, u.lowThresh + 0.1f, u.mids);
+			uvx += (randomf(floorf(uvy / (resY / 12.0f)), floorf(time * 20.0f)) - 0.5f) * u.mids * 2.8f * shiverFactor;
+			float shiftFactor = smoothstepf(u.highThresh, u.highThresh + 0.1f, u.mids);
+			float shiftSeed = randomf(floorf(sy / (resY / 6.0f)), floorf(time * 15.0f));
+			if (shiftSeed > 0.7f) uvx += (shiftSeed - 0.5f) * u.mids * 15.0f * shiftFactor;
+
+			float burst = smoothstepf(0.05f, 0.4f, u.impactDelta);
+			float midActive = smoothstepf(u.lowThresh, u.lowThresh + 0.1f, u.mids) * (0.5f + burst * 0.5f);
+			float px = (sx - resX * 0.5f) / resY, py = (sy - resY * 0.5f) / resY;
+			float warp = 0.05f + u.subBass * 0.15f;
+			px += sinf(py * 2.2f + time * 0.3f) * warp;
+			py += cosf(px * 2.8f + time * 0.3f) * warp;
+			float rot = time * 0.1f + u.mids * 2.2f + u.impactDelta * 5.0f;
+			float rx = cosf(rot) * px + sinf(rot) * py;
+			float ry = -sinf(rot) * px + cosf(rot) * py;
+			px = rx;
+			py = ry;
+			float moshTime = floorf(time * 8.0f) / 8.0f;
+			float freq = 3.0f + u.mids * 7.0f;
+			float r = sqrtf(px * px + py * py), a = atan2f(py, px);
+			float d = pattern(frame.styleA, px, py, r, a, freq, time);
+			if (frame.styleB >= 0) d = mixf(d, pattern(frame.styleB, px, py, r, a, freq, time), frame.styleMix);
+			d += randomf(px * moshTime, py * moshTime) * u.treble * 0.2f;
+			float mask = smoothstepf(2.2f, 0.3f, r);
+			float intensity = smoothstepf(u.lowThresh, u.highThresh, u.mids);
+			float thickness = mixf(0.12f, 0.5f, intensity * (0.5f + burst * 0.5f)) + u.subBass * 0.1f;
+			float shape = smoothstepf(thickness, thickness - 0.08f, d) * mask * midActive;
+			float dist = 100.0f + burst * 150.0f;
+			float tx = uvx + cosf(a + d) * dist * intensity, ty = uvy + sinf(a + d) * dist * intensity;
+			float block = mixf(1.0f, 20.0f, intensity * (1.1f - u.treble));
+			tx = floorf(tx / block) * block;
+			ty = floorf(ty / block) * block;
+			float mx = mixf(uvx, tx, shape), my = mixf(uvy, ty, shape);
+			uvx += sinf(uvy * 0.005f + time) * u.subBass * 4.0f;
+			mx = min(max(mx, 0.1f), resX - 0.1f);
+			my = min(max(my, 0.1f), resY - 0.1f);
+			float fx = mixf(uvx, mx, shape), fy = mixf(uvy, my, shape);
+			float shift = u.rgbShift + u.impactDelta * 80.0f + u.subBass * 4.0f;
+			float rgb[3] = { texel(frame.tex0.image, fx + shift, fy, 0), texel(frame.tex0.image, fx, fy, 1), texel(frame.tex0.image, fx - shift, fy, 2) };
+			for (int l = 0; l < ReactiveUniforms::MAX_OVERLAYS; l++) {
+				if (u.layerOpacity[l] <= 0.0f) continue;
+				const SoftwareMosh::Plane & plane = frame.layers[l].image;
+				float su = u.layerRes[l][0] / resX, sv = u.layerRes[l][1] / resY, m = u.layerMosh[l];
+				float lx = mixf(uvx, fx, m) * su, ly = mixf(uvy, fy, m) * sv, ls = shift * m * su;
+				float layer[3] = { texel(plane, lx + ls, ly, 0), texel(plane, lx, ly, 1), texel(plane, lx - ls, ly, 2) };
+				float opacity = u.layerOpacity[l];
+				float key = smoothstepf(0.25f, 0.6f, layer[0] * 0.2126f + layer[1] * 0.7152f + layer[2] * 0.0722f) * opacity;
+				for (int c = 0; c < 3; c++) {
+					if (u.layerBlend[l] == ReactiveUniforms::BLEND_DIFFERENCE) rgb[c] = mixf(rgb[c], fabsf(rgb[c] - layer[c]), opacity);
+					else if (u.layerBlend[l] == ReactiveUniforms::BLEND_ADD) rgb[c] = min(rgb[c] + layer[c] * opacity, 1.0f);
+					else rgb[c] = mixf(rgb[c], layer[c], key);
+				}
+			}
+			for (int c = 0; c < 3; c++) {
+				if (u.invertToggle) {
+					rgb[c] = 1.0f - rgb[c];
+					rgb[c] = mixf(rgb[c], fabsf(0.2f - rgb[c]), shape * 0.4f);
+				}
+				rgb[c] -= sinf(sy * 2.0f) * 0.05f;
+				pixel[c] = (uint8_t)(min(max(rgb[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+			pixel[3] = 255;
+		}
+	}
+}
+
+// --- HARNESS ---
+
+int main(int argc, char ** argv) {
+	int width = argc > 2 ? atoi(argv[1]) : 1920;
+	int height = argc > 2 ? atoi(argv[2]) : 1080;
+	const int srcW = 1280, srcH = 720;
+
+	// Gradient with hashed noise, so blocks and shifts are visible in the diff
+	vector<uint8_t> source(srcW * srcH * 3);
+	for (int y = 0; y < srcH; y++) {
+		for (int x = 0; x < srcW; x++) {
+			uint8_t * p = &source[(y * srcW + x) * 3];
+			uint32_t n = (x * 73856093u) ^ (y * 19349663u);
+			p[0] = (uint8_t)(x * 255 / srcW);
+			p[1] = (uint8_t)(y * 255 / srcH);
+			p[2] = (uint8_t)((n >> 8) & 255);
+		}
+	}
+
+	// Overlay: smaller, so the layer's texcoords are scaled, with diagonal bands of dark and light
+	const int layerW = 640, layerH = 360;
+	vector<uint8_t> layerSource(layerW * layerH * 3);
+	for (int y = 0; y < layerH; y++) {
+		for (int x = 0; x < layerW; x++) {
+			uint8_t * p = &layerSource[(y * layerW + x) * 3];
+			bool light = ((x + y) / 40) % 2 == 0;
+			p[0] = (uint8_t)(light ? 230 : 20 + y * 100 / layerH);
+			p[1] = (uint8_t)(light ? 200 : 30);
+			p[2] = (uint8_t)(light ? 90 + x * 160 / layerW : 60);
+		}
+	}
+
+	SoftwareMosh::Frame frame;
+	frame.tex0.image = { source.data(), srcW, srcH, 3, 0 };
+	for (auto & layer : frame.layers) layer.image = { layerSource.data(), layerW, layerH, 3, 0 };
+	ReactiveUniforms & u = frame.uniforms;
+	u.time = 12.34f;
+	u.subBass = 1.2f;
+	u.mids = 0.7f;
+	u.treble = 0.4f;
+	u.impactDelta = 0.3f;
+	u.rgbShift = 3.0f;
+	u.res[0] = u.res1[0] = (float)srcW;
+	u.res[1] = u.res1[1] = (float)srcH;
+	u.numSlices = 24;
+	for (int i = 0; i < u.numSlices; i++) u.sliceOffsets[i] = (float)((i * 37) % 11) - 5.0f;
+
+	SoftwareMosh mosh;
+	printf("SoftwareMosh %dx%d from %dx%d, kernel: %s, %d threads\n\n", width, height, srcW, srcH, SoftwareMosh::getKernelName(), mosh.getNumThreads());
+
+	// --- ACCURACY ---
+	// The grain term, random(p * moshTime) * treble, hashes the warped position: a difference
+	// in the last bit of p gives a different grain pixel, between any two implementations
+	// (GPU drivers included). The strict checks run without it, the second pass shows it.
+	// The third adds one overlay per blend mode, each with a different share of the mosh.
+	vector<uint8_t> fast(width * height * 4), reference(width * height * 4), again(width * height * 4);
+	bool ok = true;
+	const char * passNames[3] = { "without grain:", "\nwith grain (informational):", "\nwith layers:" };
+	for (int pass = 0; pass < 3; pass++) {
+		bool grain = pass == 1;
+		bool layers = pass == 2;
+		u.treble = grain ? 0.4f : 0.0f;
+		for (int l = 0; l < ReactiveUniforms::MAX_OVERLAYS; l++) {
+			u.layerOpacity[l] = layers ? 0.8f - l * 0.2f : 0.0f;
+			u.layerMosh[l] = 1.0f - l * 0.5f;
+			u.layerBlend[l] = l; // Luma, difference, add
+			u.layerRes[l][0] = (float)layerW;
+			u.layerRes[l][1] = (float)layerH;
+		}
+		printf("%s\nstyle   mean err   max err   >4 levels\n", passNames[pass]);
+		for (int style = 0; style < 8; style++) {
+			frame.styleA = style;
+			mosh.render(frame, fast.data(), width, height);
+			referenceRender(frame, reference.data(), width, height);
+			SoftwareMosh::Diff diff = SoftwareMosh::compare(fast.data(), reference.data(), width, height, 4);
+			printf("%5d   %8.3f   %7d   %8.2f%%\n", style, diff.meanError, diff.maxError, diff.overTolerance * 100.0);
+			if (!grain && (diff.meanError > 0.5 || diff.overTolerance > 0.005)) ok = false;
+		}
+	}
+
+	for (float & opacity : u.layerOpacity) opacity = 0.0f;
+
+	// --- DETERMINISM ---
+	frame.styleA = 3;
+	frame.styleB = 4;
+	frame.styleMix = 0.5f;
+	mosh.render(frame, fast.data(), width, height);
+	mosh.render(frame, again.data(), width, height);
+	bool identical = fast == again;
+	printf("\nrepeat render identical: %s\n", identical ? "yes" : "NO");
+	ok = ok && identical;
+
+	// --- THROUGHPUT ---
+	auto measure = [&](int threads) {
+		mosh.setNumThreads(threads);
+		frame.styleB = -1;
+		const int frames = 8;
+		double best = 1e9;
+		for (int style = 0; style < 8; style++) {
+			frame.styleA = style;
+			auto start = chrono::steady_clock::now();
+			for (int i = 0; i < frames; i++) mosh.render(frame, fast.data(), width, height);
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / frames;
+			best = min(best, seconds);
+			printf("  style %d: %7.2f ms  %8.1f MP/s\n", style, seconds * 1000.0, width * height / seconds / 1e6);
+		}
+		return width * height / best / 1e6;
+	};
+
+	int cores = max(1, (int)thread::hardware_concurrency());
+	printf("\n1 thread:\n");
+	double single = measure(1);
+	printf("%d threads:\n", cores);
+	double all = measure(cores);
+	printf("\nbest: %.1f MP/s on 1 thread, %.1f MP/s on %d (%.1f MP/s per core, %.2fx scaling)\n", single, all, cores, all / cores, all / single);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#version 150
+
+// CRT scanlines as one full-screen pass: a dark line on every fourth row
+uniform float lineAlpha;
+uniform float lineSpacing;
+
+out vec4 fragColor;
+
+void main(){
+	float onLine = step(mod(floor(gl_FragCoord.y), lineSpacing), 0.5);
+	fragColor = vec4(0.0, 0.0, 0.0, lineAlpha * onLine);
+}
@@ -1,12 +1,53 @@
 #version 150
 
+// ShaderCache builds one program per mosh style: STYLE_A picks the pattern, and transition
+// variants also define STYLE_B and blend the two by styleMix. Both are compile-time
+// constants, so each program only carries the pattern code it uses.
+#ifndef STYLE_A
+#define STYLE_A 0
+#endif
+
 uniform sampler2DRect tex0;
-uniform float time;
-uniform float subBass, lowMids, mids, highMids, treble;
-uniform float pixelSize, rgbShift, impactDelta;
-uniform float lowThresh, highThresh;
-uniform vec2 res;
-uniform bool invertToggle;
+uniform sampler2DRect tex1; // Incoming clip during a crossfade
+uniform sampler2DRect tex0uv, tex1uv; // Half size chroma planes for NV12 clips
+// Overlay clips (ClipLayers), each with its chroma plane. One clip per overlay: they dip
+// out and back in over the base when they change clips instead of crossfading here.
+uniform sampler2DRect layer1, layer2, layer3;
+uniform sampler2DRect layer1uv, layer2uv, layer3uv;
+
+// All reactive parameters in one block, uploaded once per frame (ReactiveUniforms.h)
+layout(std140) uniform ReactiveParams {
+	float time;
+	float beatClock, beatConfidence;
+	float subBass, lowMids, mids, highMids, treble;
+	float pixelSize, rgbShift, impactDelta;
+	float lowThresh, highThresh;
+	int invertToggle;
+	vec2 res;
+	vec2 res1;
+	float crossfade;
+	int yuv0, yuv1;
+	int numSlices; // 0 = no slicing
+	vec4 sliceOffsets[16]; // 64 per-slice x offsets in texels, packed four per vec4
+	int spectrumBins; // 0 = no spectrogram
+	int spectrogramRows, spectrogramHead;
+	vec4 layerOpacity; // Overlays 1-3 in xyz, 0 = not drawn
+	vec4 layerMosh; // Share of the mosh displacement and RGB split each overlay takes
+	ivec4 layerBlend; // BLEND_* below
+	ivec4 layerYuv;
+	vec4 layerRes[3]; // xy = texture size
+};
+
+// Overlay blend modes, the values of ReactiveUniforms::BlendMode
+const int BLEND_LUMA = 0;
+const int BLEND_DIFFERENCE = 1;
+const int BLEND_ADD = 2;
+
+// Spectrum history, one row per analysis hop written as a ring (SpectrogramTexture).
+// Columns are log-spaced 30Hz - 16kHz by default, levels are on the same scale as the bands.
+uniform sampler2D spectrogram;
+
+uniform float styleMix; // Transition variants: 0 = STYLE_A, 1 = STYLE_B
 
 in vec2 texCoordVarying;
 out vec4 fragColor;
@@ -15,8 +56,92 @@ float random(vec2 st) {
 	return fract(sin(dot(st.xy, vec2(12.9898,78.233))) * 43758.5453123);
 }
 
+// RGB from either a packed texture or NV12 planes (BT.709, video range)
+vec4 fetchClip(sampler2DRect rgbOrY, sampler2DRect chroma, int yuv, vec2 uv) {
+	if (yuv == 0) return texture(rgbOrY, uv);
+	float y = (texture(rgbOrY, uv).r - 16.0 / 255.0) * (255.0 / 219.0);
+	vec2 c = (texture(chroma, uv * 0.5).rg - 128.0 / 255.0) * (255.0 / 224.0);
+	return vec4(y + 1.5748 * c.y, y - 0.1873 * c.x - 0.4681 * c.y, y + 1.8556 * c.x, 1.0);
+}
+
+// Current clip, blended with the incoming one during a transition
+vec4 sampleClip(vec2 uv) {
+	vec4 current = fetchClip(tex0, tex0uv, yuv0, uv);
+	if (crossfade <= 0.0) return current;
+	return mix(current, fetchClip(tex1, tex1uv, yuv1, uv / res * res1), crossfade);
+}
+
+// Overlay i (0-2) at the base clip's texcoords: uv is where the frame lands before the mosh,
+// finalUv after it, the layer takes its layerMosh share of the displacement and RGB split
+vec3 sampleLayer(sampler2DRect rgbOrY, sampler2DRect chroma, int i, vec2 uv, vec2 finalUv, float shift) {
+	vec2 scale = layerRes[i].xy / res;
+	vec2 p = mix(uv, finalUv, layerMosh[i]) * scale;
+	float s = shift * layerMosh[i] * scale.x;
+	return vec3(
+		fetchClip(rgbOrY, chroma, layerYuv[i], p + vec2(s, 0.0)).r,
+		fetchClip(rgbOrY, chroma, layerYuv[i], p).g,
+		fetchClip(rgbOrY, chroma, layerYuv[i], p - vec2(s, 0.0)).b
+	);
+}
+
+vec3 blendLayer(vec3 base, vec3 layer, int i) {
+	float opacity = layerOpacity[i];
+	if (layerBlend[i] == BLEND_DIFFERENCE) return mix(base, abs(base - layer), opacity);
+	if (layerBlend[i] == BLEND_ADD) return min(base + layer * opacity, vec3(1.0));
+	// Luma key: the layer's highlights cover the base, its shadows let the base through
+	float key = smoothstep(0.25, 0.6, dot(layer, vec3(0.2126, 0.7152, 0.0722)));
+	return mix(base, layer, key * opacity);
+}
+
+// Spectrum level at x (0 = lowest column, 1 = highest) as it was age hops ago, fractional
+// ages blend neighbouring rows. The texture repeats vertically, so the ring wraps by itself.
+float spectrumAt(float x, float age) {
+	if (spectrumBins == 0) return 0.0;
+	float row = float(spectrogramHead) - age + 0.5;
+	return texture(spectrogram, vec2(x, row / float(spectrogramRows))).r;
+}
+
+// --- MOSH STYLES ---
+// style is always a #define, the compiler keeps only the matching branch
+float stylePattern(const int style, vec2 p, float r, float a, float freq) {
+	if(style == 0) {
+		// STYLE 1: LIQUID SILK - Organic, wavy interference lines
+		return abs(sin(p.y * freq + time) * sin(p.x * freq - time));
+	} else if(style == 1) {
+		// STYLE 2: THE VORTEX - A spiraling swirl that pulls pixels inward
+		return abs(sin(a * 6.0 + r * 12.0 - time * 2.5));
+	} else if(style == 2) {
+		// STYLE 3: PLASMA BLOBS - Fluid, cloud-like organic blobs
+		return abs(sin(p.x * freq + time) + sin(p.y * freq + time) + sin((p.x + p.y) * freq));
+	} else if(style == 3) {
+		// STYLE 4: KALEIDOSCOPE - 12-point rotational starburst symmetry
+		return abs(cos(a * 12.0) * sin(r * 15.0 - time));
+	} else if(style == 4) {
+		// STYLE 5: THE TUNNEL - Concentric rings pulsing with a "zoom" feel
+		return abs(sin(log(max(r, 0.001)) * 8.0 - time * 3.0));
+	} else if(style == 5) {
+		// STYLE 6: WAVES OF GRAIN - Sharp, high-frequency digital interference
+		return fract(sin(p.x * freq + p.y * freq) * 10.0 + time);
+	} else if(style == 6) {
+		// STYLE 7: RINGS OF SATURN - Clean, steady concentric circular ripples
+		return abs(sin(r * 25.0 - time * 4.0));
+	}
+	// STYLE 8: GEOMETRIC FRACTAL - Boxy, folded space with sharp angles
+	vec2 q = abs(p) - 0.2;
+	return abs(sin(max(q.x, q.y) * 20.0 + time));
+}
+
 void main(){
-	vec2 uv = texCoordVarying;
+	// --- SLICING ---
+	// Horizontal bands shifted by per-slice offsets, all slices in a single quad
+	vec2 srcCoord = texCoordVarying;
+	if (numSlices > 0) {
+		int slice = clamp(int(srcCoord.y / res.y * float(numSlices)), 0, numSlices - 1);
+		srcCoord.x -= sliceOffsets[slice / 4][slice % 4];
+		if (srcCoord.x < 0.0 || srcCoord.x > res.x) discard; // Gap at the shifted edge
+	}
+
+	vec2 uv = srcCoord;
 
 	// --- SUBTLE SHIVER (Smoothed) ---
 	float shiverFactor = smoothstep(lowThresh, lowThresh + 0.1, mids);
@@ -28,7 +153,7 @@ void main(){
 	// --- DYNAMIC BLOCK SHIFT (Smoothed) ---
 	float shiftFactor = smoothstep(highThresh, highThresh + 0.1, mids);
 	float blockCount = 6.0;
-	float blockY = floor(texCoordVarying.y / (res.y / blockCount));
+	float blockY = floor(srcCoord.y / (res.y / blockCount));
 	float shiftSeed = random(vec2(blockY, floor(time * 15.0)));
 	if (shiftSeed > 0.7) {
 		// Multiplied by shiftFactor to prevent the sudden jump
@@ -45,7 +170,7 @@ void main(){
 	float midActive = smoothstep(lowThresh, lowThresh + 0.1, mids) * (0.5 + burst * 0.5);
 	
 	vec2 center = res * 0.5;
-	vec2 p = (texCoordVarying - center) / res.y;
+	vec2 p = (srcCoord - center) / res.y;
 	
 	// Domain Warp: Bends more on sub-bass hits so it doesn't look like a static grid
 	float warpIntensity = 0.05 + (subBass * 0.15);
@@ -58,40 +183,15 @@ void main(){
 	p = rot * p;
 	
 	float moshTime = floor(time * 8.0) / 8.0;
-	float mode = mod(time * 0.06, 8.0);
-
-	float d = 0.0;
+	// Style is chosen on the CPU (every 32 beats once the tempo is locked) and baked into this program
 	float freq = 3.0 + (mids * 7.0);
 	float r = length(p);
 	float a = atan(p.y, p.x);
-	
-	// --- MODE CHANGE LOGIC ---
-	if(mode < 1.0) {
-		// STYLE 1: LIQUID SILK - Organic, wavy interference lines
-		d = abs(sin(p.y * freq + time) * sin(p.x * freq - time));
-	} else if(mode < 2.0) {
-		// STYLE 2: THE VORTEX - A spiraling swirl that pulls pixels inward
-		d = abs(sin(a * 6.0 + r * 12.0 - time * 2.5));
-	} else if(mode < 3.0) {
-		// STYLE 3: PLASMA BLOBS - Fluid, cloud-like organic blobs
-		d = abs(sin(p.x * freq + time) + sin(p.y * freq + time) + sin((p.x + p.y) * freq));
-	} else if(mode < 4.0) {
-		// STYLE 4: KALEIDOSCOPE - 12-point rotational starburst symmetry
-		d = abs(cos(a * 12.0) * sin(r * 15.0 - time));
-	} else if(mode < 5.0) {
-		// STYLE 5: THE TUNNEL - Concentric rings pulsing with a "zoom" feel
-		d = abs(sin(log(max(r, 0.001)) * 8.0 - time * 3.0));
-	} else if(mode < 6.0) {
-		// STYLE 6: WAVES OF GRAIN - Sharp, high-frequency digital interference
-		d = fract(sin(p.x * freq + p.y * freq) * 10.0 + time);
-	} else if(mode < 7.0) {
-		// STYLE 7: RINGS OF SATURN - Clean, steady concentric circular ripples
-		d = abs(sin(r * 25.0 - time * 4.0));
-	} else {
-		// STYLE 8: GEOMETRIC FRACTAL - Boxy, folded space with sharp angles
-		vec2 q = abs(p) - 0.2;
-		d = abs(sin(max(q.x, q.y) * 20.0 + time));
-	}
+#ifdef STYLE_B
+	float d = mix(stylePattern(STYLE_A, p, r, a, freq), stylePattern(STYLE_B, p, r, a, freq), styleMix);
+#else
+	float d = stylePattern(STYLE_A, p, r, a, freq);
+#endif
 
 	d += random(p * moshTime) * treble * 0.2;
 	
@@ -125,17 +225,24 @@ void main(){
 	float totalShift = rgbShift + (impactDelta * 80.0) + (subBass * 4.0);
 
 	vec4 color = vec4(
-		texture(tex0, finalUv + vec2(totalShift, 0.0)).r,
-		texture(tex0, finalUv).g,
-		texture(tex0, finalUv + vec2(-totalShift, 0.0)).b,
+		sampleClip(finalUv + vec2(totalShift, 0.0)).r,
+		sampleClip(finalUv).g,
+		sampleClip(finalUv + vec2(-totalShift, 0.0)).b,
 		1.0
 	);
 
+	// --- LAYERS ---
+	// Every overlay in this same pass, bottom to top. The opacity is uniform, so a layer that
+	// is off costs one branch and no fetches.
+	if (layerOpacity.x > 0.0) color.rgb = blendLayer(color.rgb, sampleLayer(layer1, layer1uv, 0, uv, finalUv, totalShift), 0);
+	if (layerOpacity.y > 0.0) color.rgb = blendLayer(color.rgb, sampleLayer(layer2, layer2uv, 1, uv, finalUv, totalShift), 1);
+	if (layerOpacity.z > 0.0) color.rgb = blendLayer(color.rgb, sampleLayer(layer3, layer3uv, 2, uv, finalUv, totalShift), 2);
+
 	// Initial Global Inversion
-	if(invertToggle) color.rgb = 1.0 - color.rgb;
+	if(invertToggle != 0) color.rgb = 1.0 - color.rgb;
 	
 	// --- CONDITIONAL PATTERN INVERSION ---
-	if(invertToggle) {
+	if(invertToggle != 0) {
 		// Global Invert is ON: Background is negative.
 		// We create a "Ghost Highlight" to make the geometric pattern pop
 		// without turning into a gray mush.
@@ -151,7 +258,7 @@ void main(){
 	}
 
 	// --- INTERNAL SCANLINES ---
-	float s = sin(texCoordVarying.y * 2.0) * 0.05;
+	float s = sin(srcCoord.y * 2.0) * 0.05;
 	color.rgb -= s;
 
 	fragColor = color;
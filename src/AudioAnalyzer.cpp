@@ -0,0 +1,217 @@
+#include "AudioAnalyzer.h"
+#include "RealtimeAudit.h"
+#include "ofxFft.h"
+#include <chrono>
+#include <cstring>
+
+AudioAnalyzer::~AudioAnalyzer() {
+    stop();
+}
+
+double AudioAnalyzer::now() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ofxFft behind the core's transform interface, the app keeps its FFT backend
+class OfxFftTransform : public SpectrumTransform {
+public:
+    explicit OfxFftTransform(int size) : fft(ofxFft::create(size, OF_FFT_WINDOW_HAMMING)), size(size) {}
+    const float * transform(const float * samples) override {
+        fft->setSignal(samples);
+        return fft->getAmplitude();
+    }
+    int getSize() const override { return size; }
+
+private:
+    std::unique_ptr<ofxFft> fft;
+    int size;
+};
+
+void AudioAnalyzer::setup(const AnalyzerSettings & newSettings) {
+    stop();
+
+    // One ring per planar stream the input stage produces
+    input.setup(newSettings.channelMode, newSettings.leftChannel, newSettings.rightChannel);
+    analysis.setup(newSettings, input.getNumStreams(), [](int windowSize) { return std::unique_ptr<SpectrumTransform>(new OfxFftTransform(windowSize)); });
+    settings = analysis.getSettings();
+
+    int historySize = settings.multiResolution ? std::max(settings.windowSize, settings.lowWindowSize) : settings.windowSize;
+    streams.clear();
+    for (int s = 0; s < input.getNumStreams(); s++) {
+        auto ring = std::make_unique<SpscRing<float>>();
+        // Roughly half a second of input at 48k before the analysis thread falls behind
+        ring->allocate(std::max(historySize, 1024) * 16);
+        streams.push_back(std::move(ring));
+    }
+
+    stamps.allocate(256);
+    frames.allocate(256);
+    spectrumRowSize = analysis.getSpectrumRowSize();
+    spectrumRing.allocate((size_t)std::max(spectrumRowSize, 1) * SPECTRUM_RING_ROWS);
+    samplesWritten = 0;
+    samplesConsumed = 0;
+    lastStamp = BlockStamp();
+    smoothedMidEnergy = 0.0f;
+    smoothedSideEnergy = 0.0f;
+    history.clear();
+    heldSamples = 0;
+    pendingOnsetMask = 0;
+}
+
+void AudioAnalyzer::start() {
+    if (streams.empty() || running) return;
+    running = true;
+    thread = std::thread(&AudioAnalyzer::threadedFunction, this);
+}
+
+void AudioAnalyzer::stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+void AudioAnalyzer::setInputLatency(double seconds) {
+    bool wasRunning = running;
+    stop();
+    analysis.setInputLatency(seconds);
+    settings.inputLatency = seconds;
+    if (wasRunning) start();
+}
+
+void AudioAnalyzer::pushSamples(const float * data, size_t numFrames, int numChannels, int rate, double time) {
+    if (streams.empty() || numChannels <= 0) return;
+    sampleRate.store(rate, std::memory_order_relaxed);
+
+    BlockStamp stamp;
+    size_t done = 0;
+    while (done < numFrames) {
+        int chunk = (int)std::min(numFrames - done, (size_t)InputStage::MAX_BLOCK);
+        input.process(data + done * numChannels, chunk, numChannels);
+
+        // Keep the streams in lockstep: only push what fits in every ring
+        size_t space = chunk;
+        for (auto & stream : streams) space = std::min(space, stream->writeAvailable());
+        for (int s = 0; s < (int)streams.size(); s++) {
+            streams[s]->push(input.getStream(s), space);
+        }
+        if (space < (size_t)chunk) droppedSamples.fetch_add(chunk - space, std::memory_order_relaxed);
+
+        samplesWritten += space;
+        stamp.midEnergy += input.getMidEnergy();
+        stamp.sideEnergy += input.getSideEnergy();
+        done += chunk;
+    }
+
+    stamp.sampleIndex = samplesWritten;
+    stamp.time = (time < 0.0) ? now() : time;
+    stamp.numFrames = (uint32_t)numFrames;
+    stamps.push(stamp); // A missed stamp only costs timestamp precision
+}
+
+void AudioAnalyzer::threadedFunction() {
+    while (running) {
+        if (!analyzeNextHop()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+size_t AudioAnalyzer::processPending() {
+    if (streams.empty() || running) return 0;
+    size_t count = 0;
+    while (analyzeNextHop()) count++;
+    return count;
+}
+
+bool AudioAnalyzer::analyzeNextHop() {
+    const int hop = settings.hopSize;
+
+    BlockStamp stamp;
+    while (stamps.pop(stamp)) {
+        lastStamp = stamp;
+
+        // Mean-square mid and side, smoothed with the same time constant as the bands
+        if (stamp.numFrames > 0) {
+            float alpha = 1.0f - std::pow(0.9f, (float)stamp.numFrames / 1024.0f);
+            smoothedMidEnergy = ofLerp(smoothedMidEnergy, stamp.midEnergy / stamp.numFrames, alpha);
+            smoothedSideEnergy = ofLerp(smoothedSideEnergy, stamp.sideEnergy / stamp.numFrames, alpha);
+        }
+    }
+
+    // Streams are pushed in lockstep, so the downmix ring speaks for all of them
+    if (streams[0]->readAvailable() < (size_t)hop) return false;
+
+    // Everything from here to the published frame must not allocate or lock (RealtimeAudit)
+    RealtimeSection auditSection(RealtimeAudit::SECTION_ANALYSIS);
+
+    // Slide every window by one hop
+    for (int s = 0; s < (int)streams.size(); s++) {
+        streams[s]->pop(analysis.beginHop(s), hop);
+    }
+    samplesConsumed += hop;
+
+    // Extrapolate from the latest delivered block to the end of this window
+    int rate = sampleRate.load(std::memory_order_relaxed);
+    double windowEnd = lastStamp.time + ((double)samplesConsumed - (double)lastStamp.sampleIndex) / rate;
+    const BandFrame & frame = analysis.process(windowEnd, rate, audioGain.load(std::memory_order_relaxed), spectrumBands.load(std::memory_order_relaxed),
+                                               smoothedMidEnergy, smoothedSideEnergy);
+    publishSpectrumRow();
+    if (!frames.push(frame)) droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AudioAnalyzer::setSpectrumBands(int count) {
+    spectrumBands.store(std::max(0, std::min(count, MAX_SPECTRUM_BANDS)), std::memory_order_relaxed);
+}
+
+void AudioAnalyzer::publishSpectrumRow() {
+    if (spectrumRowSize == 0) return;
+    if (spectrumRing.writeAvailable() < (size_t)spectrumRowSize) {
+        droppedSpectrumRows.fetch_add(1, std::memory_order_relaxed); // Nobody drains them
+        return;
+    }
+    spectrumRing.push(analysis.getSpectrumRow(), spectrumRowSize);
+}
+
+size_t AudioAnalyzer::popSpectrumRows(float * rows, size_t maxRows) {
+    if (spectrumRowSize == 0) return 0;
+    size_t count = std::min(maxRows, spectrumRing.readAvailable() / spectrumRowSize);
+    spectrumRing.pop(rows, count * spectrumRowSize);
+    return count;
+}
+
+size_t AudioAnalyzer::pollFrames() {
+    size_t count = 0;
+    BandFrame frame;
+    while (frames.pop(frame)) {
+        history.push(frame);
+        count++;
+
+        // Onsets are per frame, collect them so none are lost between render frames
+        pendingOnsetMask |= frame.onsetMask;
+        for (int i = 0; i < NUM_BANDS; i++) {
+            pendingOnsetStrength[i] = std::max(pendingOnsetStrength[i], frame.onsetStrength[i]);
+        }
+    }
+    if (running) history.observe(now());
+    return count;
+}
+
+unsigned int AudioAnalyzer::consumeOnsets(float * strengths) {
+    unsigned int mask = pendingOnsetMask;
+    for (int i = 0; i < NUM_BANDS; i++) {
+        strengths[i] = pendingOnsetStrength[i];
+        pendingOnsetStrength[i] = 0.0f;
+    }
+    pendingOnsetMask = 0;
+    return mask;
+}
+
+BandFrame AudioAnalyzer::sampleAt(double time) {
+    bool blended = false;
+    BandFrame frame = history.sample(time, &blended);
+    if (!blended) heldSamples++;
+    return frame;
+}
+
+double AudioAnalyzer::getFrameInterval() const {
+    return (double)settings.hopSize / (double)sampleRate.load(std::memory_order_relaxed);
+}
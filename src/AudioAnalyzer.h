@@ -0,0 +1,111 @@
+#pragma once
+#include "ofMain.h"
+#include "BandAnalysis.h"
+#include "FrameHistory.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Runs the FFT band analysis on its own thread.
+// The audio callback only splits the selected channels into planar streams and copies
+// them into lock-free rings (pushSamples), the analysis thread feeds them hop by hop into
+// BandAnalysis (sliding windows, overlapping STFT through ofxFft, bands, beat grid) and
+// publishes the timestamped BandFrames.
+// The render thread drains those frames each update() and reads a consistent,
+// interpolated set of bands.
+class AudioAnalyzer {
+public:
+	~AudioAnalyzer();
+
+	// Allocates the FFTs and rings. Call from the main thread while the analyzer is stopped.
+	void setup(const AnalyzerSettings & settings = AnalyzerSettings());
+	void start();
+	void stop();
+	// Main thread: new device latency without a setup(), the analysis thread pauses for one hop
+	// at most and the rings, FFTs and beat grid are kept
+	void setInputLatency(double seconds);
+
+	// Audio thread: wait-free, never allocates. samples is interleaved with numChannels channels.
+	// time is when the block was captured on the now() clock; offline callers pass their own
+	// timeline (seconds into the file) and leave the analyzer stopped.
+	void pushSamples(const float * samples, size_t numFrames, int numChannels, int sampleRate, double time = -1.0);
+	// Offline use while stopped: runs every hop that is buffered on the calling thread,
+	// returns the number of analysis frames produced
+	size_t processPending();
+
+	// Any thread
+	void setGain(float gain) { audioGain.store(gain, std::memory_order_relaxed); }
+	// Adds count log-spaced bands (40Hz - 16kHz) to every frame, 0 disables them
+	void setSpectrumBands(int count);
+	uint64_t getDroppedSamples() const { return droppedSamples.load(std::memory_order_relaxed); }
+	uint64_t getDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+	uint64_t getDroppedSpectrumRows() const { return droppedSpectrumRows.load(std::memory_order_relaxed); }
+	const AnalyzerSettings & getSettings() const { return settings; }
+	static double now(); // Shared clock for frame timestamps and render time
+
+	// Render thread: drain published frames, then sample them at the render time. Live, the
+	// newest frame can be up to a device buffer older than now(): sample getFrameDelay() back
+	// from now() (FrameHistory) so two frames lie around the time and the bands blend.
+	size_t pollFrames();
+	BandFrame sampleAt(double time);
+	const BandFrame & getLatestFrame() const { return history.getNewest(); }
+	double getFrameDelay() const { return history.getDelay(); } // Running only, a hop offline
+	uint64_t getHeldSamples() const { return heldSamples; } // sampleAt() calls no two frames bracketed
+	// Onsets from every frame drained since the last call; returns the band mask, fills NUM_BANDS strengths
+	unsigned int consumeOnsets(float * strengths);
+	double getFrameInterval() const; // Seconds between analysis frames (one hop)
+	// Spectrum rows published since the last call, oldest first, getSpectrumRowSize() floats
+	// each. Returns the number of rows copied, at most maxRows; the rest stay queued.
+	size_t popSpectrumRows(float * rows, size_t maxRows);
+	int getSpectrumRowSize() const { return spectrumRowSize; } // 0 = not published
+	int getSpectrumRowCapacity() const { return spectrumRowSize > 0 ? (int)(spectrumRing.capacity() / spectrumRowSize) : 0; } // Rows queued before new ones drop
+
+private:
+	static const int SPECTRUM_RING_ROWS = 64; // ~0.3s of hops at 256 / 48k, drained every render frame
+
+	struct BlockStamp {
+		uint64_t sampleIndex = 0; // Total frames written after this block
+		double time = 0.0; // Clock time when the block was delivered
+		uint32_t numFrames = 0;
+		float midEnergy = 0.0f; // For the stereo width estimate
+		float sideEnergy = 0.0f;
+	};
+
+	void threadedFunction();
+	bool analyzeNextHop(); // False when less than a hop is buffered
+	void publishSpectrumRow();
+
+	AnalyzerSettings settings;
+	BandAnalysis analysis; // Analysis thread only
+	vector<std::unique_ptr<SpscRing<float>>> streams; // Audio -> analysis, [0] is the downmix that drives BandFrame::bands
+
+	InputStage input; // Audio thread only
+	SpscRing<BlockStamp> stamps;
+	SpscRing<BandFrame> frames;
+	SpscRing<float> spectrumRing; // Whole rows of spectrumRowSize floats
+	int spectrumRowSize = 0;
+
+	std::thread thread;
+	std::atomic<bool> running { false };
+	std::atomic<float> audioGain { 1.0f };
+	std::atomic<int> sampleRate { 44100 };
+	std::atomic<uint64_t> droppedSamples { 0 };
+	std::atomic<uint64_t> droppedFrames { 0 };
+	std::atomic<uint64_t> droppedSpectrumRows { 0 };
+	uint64_t samplesWritten = 0; // Audio thread only
+
+	std::atomic<int> spectrumBands { 0 };
+
+	// Analysis thread only
+	float smoothedMidEnergy = 0.0f;
+	float smoothedSideEnergy = 0.0f;
+	BlockStamp lastStamp;
+	uint64_t samplesConsumed = 0;
+
+	// Render thread only
+	FrameHistory history;
+	uint64_t heldSamples = 0;
+	unsigned int pendingOnsetMask = 0;
+	float pendingOnsetStrength[NUM_BANDS] = {};
+};
@@ -0,0 +1,50 @@
+#include "AudioInputMonitor.h"
+#include <algorithm>
+
+void AudioInputMonitor::reset(int newBufferSize, int newSampleRate) {
+    bufferSize = std::max(newBufferSize, 1);
+    sampleRate = std::max(newSampleRate, 1);
+    started = false;
+    frames = 0;
+    baseline = 0.0;
+    xruns.store(0, std::memory_order_relaxed);
+    callbacks.store(0, std::memory_order_relaxed);
+    periodMs.store(0.0f, std::memory_order_relaxed);
+}
+
+void AudioInputMonitor::onCallback(size_t numFrames, double now) {
+    callbacks.fetch_add(1, std::memory_order_relaxed);
+
+    if (!started) {
+        // The first buffer was being recorded for its own length before the callback
+        started = true;
+        startTime = now - (double)numFrames / sampleRate;
+        lastTime = now;
+        windowStart = now;
+        frames = numFrames;
+        windowMin = 0.0;
+        return;
+    }
+
+    float interval = (float)((now - lastTime) * 1000.0);
+    float period = periodMs.load(std::memory_order_relaxed);
+    periodMs.store(period > 0.0f ? period + (interval - period) * 0.05f : interval, std::memory_order_relaxed);
+    lastTime = now;
+
+    frames += numFrames;
+    double shortfall = (now - startTime) * sampleRate - (double)frames;
+    windowMin = std::min(windowMin, shortfall);
+
+    if (now - windowStart < CHECK_WINDOW) return;
+
+    // Still short after a whole window: those frames are gone, not just late
+    double lost = windowMin - baseline;
+    if (lost > bufferSize) {
+        xruns.fetch_add(1, std::memory_order_relaxed);
+        baseline = windowMin;
+    } else {
+        baseline += (windowMin - baseline) * 0.1;
+    }
+    windowStart = now;
+    windowMin = shortfall;
+}
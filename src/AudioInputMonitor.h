@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Watches the input callback for lost audio.
+// Compares the frames delivered against the time that has passed: a late callback followed
+// by a catch-up burst loses nothing, so only a shortfall that persists for a whole check
+// window counts as an xrun. The baseline follows slowly so the drift between the device
+// and system clocks is not mistaken for dropouts.
+class AudioInputMonitor {
+public:
+	void reset(int bufferSize, int sampleRate); // Before the stream starts
+
+	// Audio thread, wait-free. now is in seconds on a steady clock.
+	void onCallback(size_t numFrames, double now);
+
+	// Any thread
+	uint64_t getXruns() const { return xruns.load(std::memory_order_relaxed); }
+	uint64_t getCallbacks() const { return callbacks.load(std::memory_order_relaxed); }
+	float getPeriodMs() const { return periodMs.load(std::memory_order_relaxed); } // Smoothed callback interval
+	int getBufferSize() const { return bufferSize; }
+	int getSampleRate() const { return sampleRate; }
+	float getBufferLatencyMs() const { return sampleRate > 0 ? 1000.0f * bufferSize / sampleRate : 0.0f; }
+
+private:
+	static constexpr double CHECK_WINDOW = 0.25; // Seconds
+
+	int bufferSize = 256;
+	int sampleRate = 48000;
+
+	// Audio thread only
+	double startTime = 0.0;
+	double lastTime = 0.0;
+	double windowStart = 0.0;
+	uint64_t frames = 0;
+	double baseline = 0.0; // Expected shortfall in frames (jitter and clock drift)
+	double windowMin = 0.0; // Smallest shortfall seen in the current window
+	bool started = false;
+
+	std::atomic<uint64_t> xruns { 0 };
+	std::atomic<uint64_t> callbacks { 0 };
+	std::atomic<float> periodMs { 0.0f };
+};
@@ -0,0 +1,195 @@
+#include "BandAnalysis.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+void BandAnalysis::setup(const AnalyzerSettings & newSettings, int numStreams, TransformFactory factory) {
+    settings = newSettings;
+    settings.hopSize = std::max(1, std::min(settings.hopSize, settings.windowSize));
+    if (!factory) factory = [](int windowSize) { return std::unique_ptr<SpectrumTransform>(new RealFft(windowSize)); };
+
+    int historySize = settings.multiResolution ? std::max(settings.windowSize, settings.lowWindowSize) : settings.windowSize;
+
+    streams.clear();
+    for (int s = 0; s < numStreams; s++) {
+        auto stream = std::make_unique<Stream>();
+        auto addPass = [&](int windowSize) {
+            auto pass = std::make_unique<AnalysisPass>();
+            pass->fft = factory(windowSize);
+            pass->windowSize = windowSize;
+            stream->passes.push_back(std::move(pass));
+        };
+        addPass(settings.windowSize);
+        if (settings.multiResolution) addPass(settings.lowWindowSize);
+        stream->history.assign(historySize, 0.0f);
+        streams.push_back(std::move(stream));
+    }
+
+    // The band smoothing was tuned as a 0.1 lerp per 1024-sample buffer, keep that time constant at any hop
+    smoothingAlpha = 1.0f - std::pow(0.9f, (float)settings.hopSize / 1024.0f);
+
+    // Spectrum rows: log-spaced columns of the main window, or every one of its bins
+    int rowSize = 0;
+    if (settings.spectrumRows) rowSize = settings.spectrumRowBins > 0 ? settings.spectrumRowBins : settings.windowSize / 2 + 1;
+    spectrumLayout = BandLayout::logSpaced(settings.spectrumRowBins, 30.0f, 16000.0f);
+    spectrumRow.assign(rowSize, 0.0f);
+    spectrumWeights.reserve(settings.windowSize, (int)spectrumLayout.bands.size());
+
+    // Every layout process() can switch to, so a spectrum band count change is only an index
+    for (int s = 0; s < numStreams; s++) buildLayouts(*streams[s], s == 0);
+
+    smoothed = BandFrame();
+    layoutBuilt = false;
+    beatTrackerRate = 0;
+    setupBeatTracker(settings.sampleRate);
+}
+
+float * BandAnalysis::beginHop(int index) {
+    std::vector<float> & history = streams[index]->history;
+    int hop = settings.hopSize;
+    std::memmove(history.data(), history.data() + hop, sizeof(float) * (history.size() - hop));
+    return history.data() + history.size() - hop;
+}
+
+void BandAnalysis::buildLayouts(Stream & stream, bool withSpectrum) {
+    // Only the downmix carries the log-spaced set, extra streams get the classic five
+    int numLayouts = withSpectrum ? MAX_SPECTRUM_BANDS + 1 : 1;
+    for (auto & pass : stream.passes) {
+        pass->layouts.assign(numLayouts, BandLayout());
+        pass->bandIndices.assign(numLayouts, std::vector<int>());
+    }
+
+    for (int n = 0; n < numLayouts; n++) {
+        BandLayout full = BandLayout::classic();
+        full.append(BandLayout::logSpaced(n));
+
+        // passes[0] is the main window; with multi-resolution, bass bands move to passes[1]
+        for (int i = 0; i < (int)full.bands.size(); i++) {
+            const BandSpec & band = full.bands[i];
+            bool low = settings.multiResolution && band.highHz > 0.0f && band.highHz <= settings.crossoverHz;
+            AnalysisPass & pass = *stream.passes[low ? 1 : 0];
+            pass.layouts[n].bands.push_back(band);
+            pass.bandIndices[n].push_back(i);
+        }
+    }
+
+    stream.rawBands.assign(NUM_BANDS + numLayouts - 1, 0.0f);
+    for (auto & pass : stream.passes) {
+        int most = 0;
+        for (const BandLayout & layout : pass->layouts) most = std::max(most, (int)layout.bands.size());
+        pass->output.assign(most, 0.0f);
+        pass->weights.reserve(pass->windowSize, most);
+        pass->active = 0;
+    }
+}
+
+void BandAnalysis::selectLayout(int numSpectrum) {
+    for (auto & stream : streams) {
+        for (auto & pass : stream->passes) pass->active = std::min(numSpectrum, (int)pass->layouts.size() - 1);
+    }
+
+    smoothed.numSpectrumBands = numSpectrum;
+    smoothed.numChannelBandSets = std::min((int)streams.size() - 1, MAX_CHANNEL_BAND_SETS);
+    layoutBuilt = true;
+}
+
+void BandAnalysis::setupBeatTracker(int rate) {
+    beatTracker.setup(rate, settings.windowSize, settings.hopSize);
+    // Flux rises once the attack is about a quarter into the tapered window
+    beatTracker.setLatencyCompensation(settings.inputLatency + settings.windowSize * 0.25 / rate);
+    beatTrackerRate = rate;
+}
+
+void BandAnalysis::analyzeStream(Stream & stream, int rate, float gain) {
+    for (auto & pass : stream.passes) {
+        // The main window always has bands (everything above the crossover), so the beat
+        // tracker and the spectrum row always find its amplitudes
+        const BandLayout & layout = pass->layouts[pass->active];
+        if (layout.bands.empty() || !pass->fft) continue;
+
+        // Each pass reads the newest windowSize samples of the shared history
+        pass->amplitude = pass->fft->transform(stream.history.data() + stream.history.size() - pass->windowSize);
+
+        // Band levels were calibrated on 1024-point frames; keep broadband levels there at other sizes
+        float sizeCompensation = std::sqrt((float)pass->windowSize / 1024.0f);
+
+        // Rebuilds the weight table only when rate, size, layout or gain changed
+        pass->weights.update(rate, pass->windowSize, layout, gain * sizeCompensation);
+        pass->weights.reduce(pass->amplitude, pass->output.data());
+        const std::vector<int> & bandIndex = pass->bandIndices[pass->active];
+        for (size_t b = 0; b < bandIndex.size(); b++) {
+            stream.rawBands[bandIndex[b]] = pass->output[b];
+        }
+    }
+}
+
+void BandAnalysis::computeSpectrumRow(int rate, float gain) {
+    if (spectrumRow.empty()) return;
+    const AnalysisPass & pass = *streams[0]->passes[0];
+    float sizeCompensation = std::sqrt((float)pass.windowSize / 1024.0f);
+    if (settings.spectrumRowBins > 0) {
+        spectrumWeights.update(rate, pass.windowSize, spectrumLayout, gain * sizeCompensation);
+        spectrumWeights.reduce(pass.amplitude, spectrumRow.data());
+        return;
+    }
+
+    // Per bin, the weight a band of its own would get
+    int count = (int)spectrumRow.size();
+    float scale = gain * sizeCompensation * BandWeights::INPUT_SCALE;
+    for (int i = 0; i < count; i++) {
+        float tilt = 1.0f + ((float)i / (float)count) * BandWeights::TILT_AMOUNT;
+        spectrumRow[i] = pass.amplitude[i] * scale * tilt;
+    }
+}
+
+void BandAnalysis::setInputLatency(double seconds) {
+    settings.inputLatency = seconds;
+    if (beatTrackerRate > 0) beatTracker.setLatencyCompensation(seconds + settings.windowSize * 0.25 / beatTrackerRate);
+}
+
+const BandFrame & BandAnalysis::process(double time, int rate, float gain, int numSpectrum, float midEnergy, float sideEnergy) {
+    // Pick up layout changes
+    numSpectrum = std::max(0, std::min(numSpectrum, MAX_SPECTRUM_BANDS));
+    if (!layoutBuilt || smoothed.numSpectrumBands != numSpectrum) selectLayout(numSpectrum);
+
+    for (auto & stream : streams) analyzeStream(*stream, rate, gain);
+    computeSpectrumRow(rate, gain);
+
+    const std::vector<float> & mix = streams[0]->rawBands;
+    for (int i = 0; i < NUM_BANDS; i++) {
+        smoothed.bands[i] = lerp(smoothed.bands[i], mix[i], smoothingAlpha);
+    }
+    for (int i = 0; i < numSpectrum; i++) {
+        smoothed.spectrum[i] = lerp(smoothed.spectrum[i], mix[NUM_BANDS + i], smoothingAlpha);
+    }
+    for (int c = 0; c < smoothed.numChannelBandSets; c++) {
+        const std::vector<float> & raw = streams[c + 1]->rawBands;
+        for (int i = 0; i < NUM_BANDS; i++) {
+            smoothed.channelBands[c][i] = lerp(smoothed.channelBands[c][i], raw[i], smoothingAlpha);
+        }
+    }
+
+    // Onsets and beat grid from the downmix' main window (the short one in multi-resolution mode)
+    if (beatTrackerRate != rate) setupBeatTracker(rate); // Allocates, setup() built it for settings.sampleRate
+    smoothed.onsetMask = beatTracker.process(streams[0]->passes[0]->amplitude, time);
+    for (int i = 0; i < NUM_BANDS; i++) {
+        smoothed.onsetStrength[i] = beatTracker.getOnsetStrength(i);
+        smoothed.flux[i] = beatTracker.getFlux(i);
+    }
+    smoothed.beatTime = beatTracker.getBeatTime();
+    smoothed.beatIndex = beatTracker.getBeatIndex();
+    smoothed.beatPeriod = beatTracker.getBeatPeriod();
+    smoothed.beatConfidence = beatTracker.getConfidence();
+
+    // Side relative to mid: 0 for mono, 1 once the side is as loud as the mid
+    float width = std::sqrt(sideEnergy / std::max(midEnergy, 1e-9f));
+    smoothed.stereoWidth = std::min(width, 1.0f);
+
+    smoothed.time = time;
+    smoothed.sequence++;
+    return smoothed;
+}
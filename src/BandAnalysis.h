@@ -0,0 +1,106 @@
+#pragma once
+#include "BandFrame.h"
+#include "BandWeights.h"
+#include "BeatTracker.h"
+#include "InputStage.h"
+#include "RealFft.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct AnalyzerSettings {
+	int windowSize = 1024; // FFT size, independent of the device buffer size
+	int hopSize = 256; // Samples between analysis frames (~5ms at 48k)
+
+	// Multi-resolution: bands that end at or below crossoverHz are taken from a longer
+	// window for bass resolution, everything above from windowSize for fast transients.
+	bool multiResolution = false;
+	int lowWindowSize = 4096;
+	float crossoverHz = 350.0f;
+
+	// Input channels (zero-based device channels, rightChannel < 0 for a mono source)
+	ChannelMode channelMode = CHANNEL_MODE_MONO;
+	int leftChannel = 0;
+	int rightChannel = 1;
+
+	// Device input latency in seconds, subtracted from onset and beat times
+	double inputLatency = 0.0;
+
+	// Expected input rate: setup() builds the beat tracker for it, process() at another rate
+	// rebuilds it on that hop (allocates)
+	int sampleRate = 48000;
+
+	// Magnitude spectrum of the downmix, one row per hop (popSpectrumRows). spectrumRowBins > 0
+	// averages the main window's bins into that many log-spaced columns (30Hz - 16kHz),
+	// 0 publishes every bin (windowSize / 2 + 1). Same gain, tilt and scale as the bands.
+	bool spectrumRows = true;
+	int spectrumRowBins = 256;
+};
+
+// The analysis of one hop, without threads, clocks or devices: a sliding window per planar
+// stream, the STFT (one transform per window size), band reduction, smoothing, onsets and
+// beat grid, stereo width and the spectrum row. AudioAnalyzer runs it on its thread, the
+// benchmarks and tests run it directly. setup() builds the layouts for every spectrum band
+// count and sizes the weight tables for them, so process() doesn't allocate, unless its rate
+// differs from settings.sampleRate. No openFrameworks or GL dependency.
+class BandAnalysis {
+public:
+	// Creates the transform for one window size. Empty = RealFft.
+	using TransformFactory = std::function<std::unique_ptr<SpectrumTransform>(int windowSize)>;
+
+	// numStreams planar streams (InputStage::getNumStreams), [0] is the downmix
+	void setup(const AnalyzerSettings & settings, int numStreams, TransformFactory factory = TransformFactory());
+
+	// Slides the stream's window by one hop, returns where its hopSize new samples go
+	float * beginHop(int stream);
+	// Analyses the current windows. time: end of the window on the analyzer clock;
+	// midEnergy / sideEnergy: smoothed mean squares of mid and side for the stereo width.
+	const BandFrame & process(double time, int sampleRate, float gain, int numSpectrumBands, float midEnergy, float sideEnergy);
+
+	const BandFrame & getFrame() const { return smoothed; } // Last process() result
+	const float * getSpectrumRow() const { return spectrumRow.data(); } // Last process(), getSpectrumRowSize() values
+	int getSpectrumRowSize() const { return (int)spectrumRow.size(); } // 0 = not computed
+	int getNumStreams() const { return (int)streams.size(); }
+	void setInputLatency(double seconds); // Between hops, keeps the windows and the beat grid
+	const AnalyzerSettings & getSettings() const { return settings; }
+
+private:
+	// One FFT size and the bands it is responsible for
+	struct AnalysisPass {
+		std::unique_ptr<SpectrumTransform> fft;
+		int windowSize = 0;
+		const float * amplitude = nullptr; // Last transform
+		// One per spectrum band count (0..MAX_SPECTRUM_BANDS, the downmix only; 0 elsewhere)
+		std::vector<BandLayout> layouts;
+		std::vector<std::vector<int>> bandIndices; // Where each of this pass's bands goes in the full layout
+		int active = 0; // Layout in use
+		BandWeights weights;
+		std::vector<float> output; // Sized for the largest layout
+	};
+
+	// One planar input stream (downmix, left, right or side)
+	struct Stream {
+		std::vector<float> history; // Newest sample last
+		std::vector<std::unique_ptr<AnalysisPass>> passes;
+		std::vector<float> rawBands; // Sized for the largest layout
+	};
+
+	void buildLayouts(Stream & stream, bool withSpectrum);
+	void selectLayout(int numSpectrum);
+	void setupBeatTracker(int rate);
+	void analyzeStream(Stream & stream, int rate, float gain);
+	void computeSpectrumRow(int rate, float gain);
+
+	AnalyzerSettings settings;
+	std::vector<std::unique_ptr<Stream>> streams;
+	float smoothingAlpha = 0.1f;
+	bool layoutBuilt = false;
+
+	BeatTracker beatTracker;
+	int beatTrackerRate = 0;
+	BandFrame smoothed;
+
+	BandLayout spectrumLayout;
+	BandWeights spectrumWeights;
+	std::vector<float> spectrumRow;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+// Indices into BandFrame::bands
+enum BandIndex {
+	BAND_SUB_BASS = 0, // 0 - 150Hz
+	BAND_LOW_MIDS, // 150 - 350Hz
+	BAND_MIDS, // 350 - 1kHz
+	BAND_HIGH_MIDS, // 1kHz - 4kHz
+	BAND_TREBLE, // 4kHz+
+	NUM_BANDS
+};
+
+// Upper bound for the configurable log-spaced band set
+static const int MAX_SPECTRUM_BANDS = 64;
+// Extra per-channel band sets next to the downmix (left + right, or side)
+static const int MAX_CHANNEL_BAND_SETS = 2;
+
+// One complete analysis result. Frames are published as a whole so the renderer
+// never sees bands from two different analysis passes.
+struct BandFrame {
+	double time = 0.0; // Seconds on the analyzer clock at the end of the analysis window
+	uint64_t sequence = 0; // Increments per published frame
+	float bands[NUM_BANDS] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Optional log-spaced bands (AudioAnalyzer::setSpectrumBands)
+	int numSpectrumBands = 0;
+	float spectrum[MAX_SPECTRUM_BANDS] = {};
+
+	// Per-channel bands: [0] left, [1] right in stereo mode, [0] side in mid/side mode
+	int numChannelBandSets = 0;
+	float channelBands[MAX_CHANNEL_BAND_SETS][NUM_BANDS] = {};
+	float stereoWidth = 0.0f; // 0 = mono, 1 = side as loud as mid (or wider)
+
+	// Onsets detected in this frame (bit per BandIndex) and their strength above threshold
+	unsigned int onsetMask = 0;
+	float onsetStrength[NUM_BANDS] = {};
+	float flux[NUM_BANDS] = {};
+
+	// Beat grid, latency compensated: beat number beatIndex fell on beatTime
+	double beatTime = 0.0;
+	uint64_t beatIndex = 0;
+	float beatPeriod = 0.5f;
+	float beatConfidence = 0.0f;
+
+	// Continuous beat count at any time on the analyzer clock (fractional part = beat phase)
+	double getBeats(double t) const {
+		if (beatTime <= 0.0 || beatPeriod <= 0.0f) return 0.0;
+		return (double)beatIndex + (t - beatTime) / beatPeriod;
+	}
+};
@@ -0,0 +1,177 @@
+#include "BandWeights.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define BAND_WEIGHTS_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+#endif
+
+BandLayout BandLayout::classic() {
+    BandLayout layout;
+    layout.bands = {
+        { 0.0f, 150.0f, 1.0f }, // Sub Bass
+        { 150.0f, 350.0f, 1.8f }, // Low Mids
+        { 350.0f, 1000.0f, 2.5f }, // Mids
+        { 1000.0f, 4000.0f, 4.0f }, // High Mids
+        { 4000.0f, 0.0f, 6.0f } // Treble
+    };
+    return layout;
+}
+
+BandLayout BandLayout::logSpaced(int count, float minHz, float maxHz, float scale) {
+    BandLayout layout;
+    if (count <= 0 || minHz <= 0.0f || maxHz <= minHz) return layout;
+
+    float ratio = std::pow(maxHz / minHz, 1.0f / (float)count);
+    float low = minHz;
+    for (int i = 0; i < count; i++) {
+        float high = low * ratio;
+        layout.bands.push_back({ low, high, scale });
+        low = high;
+    }
+    return layout;
+}
+
+void BandLayout::append(const BandLayout & other) {
+    bands.insert(bands.end(), other.bands.begin(), other.bands.end());
+}
+
+bool BandLayout::operator==(const BandLayout & other) const {
+    if (bands.size() != other.bands.size()) return false;
+    for (size_t i = 0; i < bands.size(); i++) {
+        const BandSpec & a = bands[i];
+        const BandSpec & b = other.bands[i];
+        if (a.lowHz != b.lowHz || a.highHz != b.highHz || a.scale != b.scale) return false;
+    }
+    return true;
+}
+
+bool BandWeights::update(int sampleRate, int fftSize, const BandLayout & layout, float gain, float tiltAmount) {
+    if (sampleRate == cachedSampleRate && fftSize == cachedFftSize && gain == cachedGain && tiltAmount == cachedTilt && layout == cachedLayout) {
+        return false;
+    }
+
+    numBins = fftSize / 2 + 1;
+    float binHz = (float)sampleRate / (float)fftSize;
+
+    ranges.resize(layout.bands.size());
+    int total = 0;
+    for (size_t b = 0; b < layout.bands.size(); b++) {
+        const BandSpec & spec = layout.bands[b];
+
+        // Same edge rule as the original cutoffs: a band owns (floor(low), floor(high)]
+        int first = (spec.lowHz <= 0.0f) ? 0 : (int)(spec.lowHz / binHz) + 1;
+        int last = (spec.highHz <= 0.0f) ? numBins - 1 : (int)(spec.highHz / binHz);
+        first = std::min(first, numBins - 1);
+        last = std::min(std::max(last, first), numBins - 1); // Narrow low bands still get their nearest bin
+
+        ranges[b].firstBin = first;
+        ranges[b].count = last - first + 1;
+        ranges[b].offset = total;
+        total += ranges[b].count;
+    }
+
+    weights.resize(total);
+    for (size_t b = 0; b < layout.bands.size(); b++) {
+        const Range & r = ranges[b];
+        // Average over the band, then apply the calibrated multiplier
+        float bandGain = gain * INPUT_SCALE * layout.bands[b].scale / (float)r.count;
+        for (int k = 0; k < r.count; k++) {
+            int bin = r.firstBin + k;
+            float tilt = 1.0f + ((float)bin / (float)numBins) * tiltAmount;
+            weights[r.offset + k] = bandGain * tilt;
+        }
+    }
+
+    cachedSampleRate = sampleRate;
+    cachedFftSize = fftSize;
+    cachedGain = gain;
+    cachedTilt = tiltAmount;
+    if (cachedLayout != layout) cachedLayout = layout;
+    return true;
+}
+
+void BandWeights::reserve(int fftSize, int numBands) {
+    // Adjacent bands share no bins, a band narrower than a bin or above Nyquist still takes one
+    ranges.reserve(numBands);
+    weights.reserve(2 * (fftSize / 2 + 1) + numBands);
+    cachedLayout.bands.reserve(numBands);
+}
+
+void BandWeights::reduce(const float * magnitudes, float * out) const {
+    const float * table = weights.data();
+    for (const Range & r : ranges) {
+        *out++ = weightedSum(magnitudes + r.firstBin, table + r.offset, r.count);
+    }
+}
+
+const char * BandWeights::getKernelName() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(BAND_WEIGHTS_SSE)
+    return "SSE";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+float BandWeights::weightedSum(const float * values, const float * w, int count) {
+    int i = 0;
+    float sum = 0.0f;
+
+#if defined(__AVX2__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= count; i += 16) {
+        #if defined(__FMA__)
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), _mm256_loadu_ps(w + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i + 8), _mm256_loadu_ps(w + i + 8), acc1);
+        #else
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(values + i), _mm256_loadu_ps(w + i)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(values + i + 8), _mm256_loadu_ps(w + i + 8)));
+        #endif
+    }
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(values + i), _mm256_loadu_ps(w + i)));
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    sum = _mm_cvtss_f32(lo);
+#elif defined(BAND_WEIGHTS_SSE)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(w + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(values + i + 4), _mm_loadu_ps(w + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(values + i), vld1q_f32(w + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(values + i + 4), vld1q_f32(w + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+
+    // Scalar tail (and the whole sum on targets without SIMD)
+    for (; i < count; i++) {
+        sum += values[i] * w[i];
+    }
+    return sum;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+// Frequency range of one analysis band and its output multiplier.
+// highHz <= 0 means "up to Nyquist".
+struct BandSpec {
+	float lowHz = 0.0f;
+	float highHz = 0.0f;
+	float scale = 1.0f;
+};
+
+struct BandLayout {
+	std::vector<BandSpec> bands;
+
+	// The five calibrated bands the renderer is tuned to (see BandIndex)
+	static BandLayout classic();
+	// count bands with logarithmically spaced edges between minHz and maxHz
+	static BandLayout logSpaced(int count, float minHz = 40.0f, float maxHz = 16000.0f, float scale = 1.0f);
+
+	void append(const BandLayout & other);
+	bool operator==(const BandLayout & other) const;
+	bool operator!=(const BandLayout & other) const { return !(*this == other); }
+};
+
+// Precomputed bin -> band weight table.
+// Tilt, input gain, band scale and the per-band averaging are folded into one weight
+// per bin, so reducing a spectrum is a single weighted sum per band. The table is only
+// rebuilt when the sample rate, FFT size, layout or gain change.
+class BandWeights {
+public:
+	// Returns true if the table was rebuilt. Doesn't allocate unless the layout or FFT size grew
+	// past what reserve() made room for. tilt = 0 gives a flat average per band (spectral flux).
+	bool update(int sampleRate, int fftSize, const BandLayout & layout, float gain, float tilt = TILT_AMOUNT);
+	// Room for any layout of up to numBands bands made of at most two runs of adjacent bands
+	// (classic plus log-spaced), at fftSize or less
+	void reserve(int fftSize, int numBands);
+
+	// magnitudes must hold getNumBins() values, out receives getNumBands() values
+	void reduce(const float * magnitudes, float * out) const;
+
+	int getNumBands() const { return (int)ranges.size(); }
+	int getNumBins() const { return numBins; }
+
+	// Name of the SIMD path compiled in ("AVX2", "SSE", "NEON" or "scalar")
+	static const char * getKernelName();
+
+	// Unweighted dot product, exposed for the benchmark
+	static float weightedSum(const float * values, const float * weights, int count);
+
+	static constexpr float INPUT_SCALE = 25.0f; // Brings ofxFft amplitudes into a 0..~5 range
+	static constexpr float TILT_AMOUNT = 10.0f; // Counters natural energy drop-off in higher frequencies
+
+private:
+	struct Range {
+		int firstBin = 0;
+		int count = 0;
+		int offset = 0; // Start of this band's weights in the table
+	};
+
+	std::vector<Range> ranges;
+	std::vector<float> weights;
+	int numBins = 0;
+
+	// Cache key
+	int cachedSampleRate = 0;
+	int cachedFftSize = 0;
+	float cachedGain = -1.0f;
+	float cachedTilt = -1.0f;
+	BandLayout cachedLayout;
+};
@@ -0,0 +1,173 @@
+#include "BeatTracker.h"
+#include <algorithm>
+#include <cmath>
+
+void BeatTracker::setup(int rate, int size, int hop) {
+    sampleRate = rate;
+    fftSize = size;
+    hopSize = hop;
+    hopSeconds = (float)hopSize / (float)sampleRate;
+    statsAlpha = 1.0f - std::exp(-hopSeconds / 1.0f);
+
+    int numBins = fftSize / 2 + 1;
+    previousLog.assign(numBins, 0.0f);
+    rise.assign(numBins, 0.0f);
+
+    // Flat per-band average of the rise; cancel the analyzer's input scale
+    fluxWeights.update(sampleRate, fftSize, BandLayout::classic(), 1.0f / BandWeights::INPUT_SCALE, 0.0f);
+
+    // Six seconds of onset function is enough for two bars at the slowest tempo
+    int odfLength = (int)std::ceil(6.0f / hopSeconds);
+    odf.assign(odfLength, 0.0f);
+    odfLinear.assign(odfLength, 0.0f);
+    odfWrite = 0;
+    odfCount = 0;
+    hopsSinceTempo = 0;
+
+    for (auto & band : bands) band = BandState();
+    period = 0.5f;
+    confidence = 0.0f;
+    beatTime = 0.0;
+    beatIndex = 0;
+    hasPrevious = false;
+}
+
+unsigned int BeatTracker::process(const float * magnitudes, double time) {
+    if (previousLog.empty()) return 0;
+    double t = time - latency;
+
+    // Log compression keeps quiet passages from being swamped by loud ones
+    int numBins = (int)previousLog.size();
+    for (int i = 0; i < numBins; i++) {
+        float lm = std::log1p(100.0f * magnitudes[i]);
+        rise[i] = hasPrevious ? std::max(0.0f, lm - previousLog[i]) : 0.0f;
+        previousLog[i] = lm;
+    }
+    fluxWeights.reduce(rise.data(), bandFlux);
+
+    unsigned int mask = 0;
+    float odfValue = 0.0f;
+    for (int b = 0; b < NUM_BANDS; b++) {
+        BandState & band = bands[b];
+        band.flux = bandFlux[b];
+        band.strength = 0.0f;
+
+        // Test against the statistics of the past, then fold this hop in
+        float threshold = band.mean + thresholdK * std::sqrt(band.variance) + 1e-4f;
+        if (hasPrevious && band.flux > threshold && t - band.lastOnset > refractory) {
+            band.strength = std::min((band.flux - threshold) / threshold, 4.0f);
+            band.lastOnset = t;
+            mask |= 1u << b;
+        }
+
+        float delta = band.flux - band.mean;
+        band.mean += statsAlpha * delta;
+        band.variance = (1.0f - statsAlpha) * (band.variance + statsAlpha * delta * delta);
+
+        // Kick and bass carry the beat, upper bands still help on sparse material
+        float weight = (b <= BAND_LOW_MIDS) ? 1.0f : 0.5f;
+        odfValue += weight * band.flux / std::max(band.mean, 1e-4f);
+    }
+    hasPrevious = true;
+
+    odf[odfWrite] = odfValue;
+    odfWrite = (odfWrite + 1) % (int)odf.size();
+    odfCount = std::min(odfCount + 1, (int)odf.size());
+
+    // Re-estimate the tempo four times a second once there are three seconds of history
+    if (++hopsSinceTempo * hopSeconds >= 0.25f && odfCount * hopSeconds >= 3.0f) {
+        estimateTempo();
+        hopsSinceTempo = 0;
+    }
+
+    bool lowOnset = (mask & ((1u << BAND_SUB_BASS) | (1u << BAND_LOW_MIDS))) != 0;
+    advancePhase(t, lowOnset);
+    return mask;
+}
+
+void BeatTracker::estimateTempo() {
+    // Oldest first, mean removed
+    int n = odfCount;
+    int start = (odfWrite - n + (int)odf.size()) % (int)odf.size();
+    float mean = 0.0f;
+    for (int i = 0; i < n; i++) {
+        odfLinear[i] = odf[(start + i) % odf.size()];
+        mean += odfLinear[i];
+    }
+    mean /= (float)n;
+    float energy = 0.0f;
+    for (int i = 0; i < n; i++) {
+        odfLinear[i] -= mean;
+        energy += odfLinear[i] * odfLinear[i];
+    }
+    if (energy <= 1e-9f) return;
+    energy /= (float)n;
+
+    int lagMin = std::max(1, (int)(60.0f / (maxBpm * hopSeconds)));
+    int lagMax = std::min(n / 2, (int)(60.0f / (minBpm * hopSeconds)) + 1);
+    if (lagMax <= lagMin + 1) return;
+
+    auto acfAt = [&](int lag) {
+        float sum = 0.0f;
+        for (int i = 0; i + lag < n; i++) sum += odfLinear[i] * odfLinear[i + lag];
+        return sum / (float)(n - lag);
+    };
+
+    int bestLag = -1;
+    float bestScore = 0.0f;
+    float bestAcf = 0.0f;
+    for (int lag = lagMin; lag <= lagMax; lag++) {
+        float acf = acfAt(lag);
+        // Log-Gaussian prior around 120 BPM resolves the usual half/double tempo ambiguity
+        float bpm = 60.0f / ((float)lag * hopSeconds);
+        float octaves = std::log2(bpm / 120.0f);
+        float score = acf * std::exp(-0.5f * octaves * octaves / (0.8f * 0.8f));
+        if (score > bestScore) {
+            bestScore = score;
+            bestAcf = acf;
+            bestLag = lag;
+        }
+    }
+    if (bestLag < 0) return;
+
+    // Parabolic refinement to a fractional lag
+    float lag = (float)bestLag;
+    if (bestLag > lagMin && bestLag < lagMax) {
+        float a = acfAt(bestLag - 1);
+        float c = acfAt(bestLag + 1);
+        float denom = a - 2.0f * bestAcf + c;
+        if (denom < 0.0f) lag += 0.5f * (a - c) / denom;
+    }
+
+    float estimate = lag * hopSeconds;
+    float conf = std::min(1.0f, std::max(0.0f, bestAcf / energy));
+    if (conf > 0.1f) {
+        // Jump on a real tempo change, otherwise glide
+        if (std::fabs(estimate / period - 1.0f) > 0.15f) period = estimate;
+        else period += 0.25f * (estimate - period);
+    }
+    confidence += 0.3f * (conf - confidence);
+}
+
+void BeatTracker::advancePhase(double t, bool lowOnset) {
+    if (beatTime <= 0.0) {
+        if (lowOnset) beatTime = t;
+        return;
+    }
+
+    // Free-run the predicted grid up to now
+    while (t >= beatTime + period) {
+        beatTime += period;
+        beatIndex++;
+    }
+    if (!lowOnset) return;
+
+    // Pull the grid towards onsets that land near a predicted beat
+    double nextBeat = beatTime + period;
+    double error = (t - beatTime < nextBeat - t) ? t - beatTime : t - nextBeat;
+    if (std::fabs(error) < 0.2 * period) {
+        beatTime += 0.25 * error;
+    } else if (confidence < 0.3f) {
+        beatTime = t; // No stable grid yet, re-anchor on the kick
+    }
+}
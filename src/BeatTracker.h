@@ -0,0 +1,73 @@
+#pragma once
+#include "BandFrame.h"
+#include "BandWeights.h"
+#include <cstdint>
+#include <vector>
+
+// Spectral-flux onset detector and tempo/phase tracker.
+// Runs on the analyzer thread once per hop. Per band it measures the half-wave rectified
+// rise in log magnitude (spectral flux), compares it against an adaptive mean + k * stddev
+// threshold and reports onsets. A combined onset function feeds an autocorrelation tempo
+// estimate, and low-band onsets steer the beat phase like a simple PLL. All times are on
+// the analyzer clock, already shifted back by the known pipeline latency, so the renderer
+// can evaluate the beat phase at its own present time.
+class BeatTracker {
+public:
+	void setup(int sampleRate, int fftSize, int hopSize);
+	// Seconds between the sound reaching the input and the frame timestamp
+	void setLatencyCompensation(double seconds) { latency = seconds; }
+
+	// magnitudes: fftSize / 2 + 1 bins. Returns a bit mask of bands with an onset this hop.
+	unsigned int process(const float * magnitudes, double time);
+
+	float getFlux(int band) const { return bands[band].flux; }
+	float getOnsetStrength(int band) const { return bands[band].strength; } // 0 unless the band fired this hop
+	double getBeatTime() const { return beatTime; } // Time of the most recent (predicted) beat
+	uint64_t getBeatIndex() const { return beatIndex; } // Beats counted up to beatTime
+	float getBeatPeriod() const { return period; }
+	float getConfidence() const { return confidence; }
+
+	// Tunables
+	float thresholdK = 1.5f; // Standard deviations above the running mean
+	float refractory = 0.09f; // Seconds before the same band may fire again
+	float minBpm = 70.0f;
+	float maxBpm = 180.0f;
+
+private:
+	struct BandState {
+		float flux = 0.0f;
+		float mean = 0.0f;
+		float variance = 0.0f;
+		float strength = 0.0f;
+		double lastOnset = -1.0;
+	};
+
+	void estimateTempo();
+	void advancePhase(double time, bool lowOnset);
+
+	int sampleRate = 44100;
+	int fftSize = 1024;
+	int hopSize = 256;
+	float hopSeconds = 0.0f;
+	float statsAlpha = 0.01f; // Per hop, ~1s time constant
+	double latency = 0.0;
+
+	BandWeights fluxWeights;
+	std::vector<float> previousLog;
+	std::vector<float> rise;
+	float bandFlux[NUM_BANDS] = {};
+	BandState bands[NUM_BANDS];
+
+	// Onset detection function history for the tempo estimate
+	std::vector<float> odf;
+	std::vector<float> odfLinear;
+	int odfWrite = 0;
+	int odfCount = 0;
+	int hopsSinceTempo = 0;
+
+	float period = 0.5f; // 120 BPM until proven otherwise
+	float confidence = 0.0f;
+	double beatTime = 0.0;
+	uint64_t beatIndex = 0;
+	bool hasPrevious = false;
+};
@@ -0,0 +1,341 @@
+#include "ClipDeck.h"
+
+ClipDeck::ClipDeck() {
+    for (auto & slot : slots) slot.stream.setup(&pool);
+}
+
+ClipDeck::~ClipDeck() {
+    joinLoader();
+}
+
+void ClipDeck::setPicker(std::function<string(const string & playing)> newPicker) {
+    picker = newPicker;
+}
+
+void ClipDeck::setMovieInfo(std::function<bool(const string & path, MovieInfo & info)> lookup) {
+    movieInfo = lookup;
+}
+
+void ClipDeck::start() {
+    if (slots[current].state != SLOT_EMPTY) return;
+    retryTimer = 0.0f;
+    prefetch(slots[current]);
+}
+
+void ClipDeck::stop() {
+    joinLoader();
+    for (auto & slot : slots) {
+        slot.decoder.stop();
+        slot.player.stop();
+        slot.player.close();
+        slot.stream.release();
+        slot.state = SLOT_EMPTY;
+    }
+    current = 0;
+    phase = PHASE_IDLE;
+    crossfade = 0.0f;
+}
+
+void ClipDeck::stopInBackground() {
+    // The decoders belong to the loader thread from here on, their memory is counted as it was
+    for (auto & slot : slots) {
+        slot.stream.release();
+        slot.closingBytes = getDecodeBytes(slot);
+    }
+    current = 0;
+    phase = PHASE_IDLE;
+    crossfade = 0.0f;
+
+    closing = true;
+    runOnLoader([this]() {
+        for (auto & slot : slots) closeSlot(slot);
+        closing = false;
+    });
+}
+
+void ClipDeck::joinLoader() {
+    if (loader.joinable()) loader.join();
+}
+
+void ClipDeck::runOnLoader(std::function<void()> work) {
+    if (frameStepped) {
+        joinLoader();
+        work();
+        return;
+    }
+    std::thread pending = std::move(loader);
+    loader = std::thread([pending = std::move(pending), work]() mutable {
+        if (pending.joinable()) pending.join();
+        work();
+    });
+}
+
+void ClipDeck::closeSlot(Slot & slot) {
+    slot.decoder.stop(); // Waits for a seek or decode in flight
+    slot.player.stop();
+    slot.player.close();
+    slot.state = SLOT_EMPTY;
+}
+
+size_t ClipDeck::getDecodeBytes(const Slot & slot) const {
+    if (closing || slot.state == SLOT_CLOSING) return slot.closingBytes;
+    return slot.decoder.isRunning() ? slot.decoder.getBytes() : 0;
+}
+
+void ClipDeck::prefetch(Slot & slot) {
+    string path = picker ? picker(slots[current].path) : "";
+    if (path.empty()) return;
+    joinLoader(); // The previous load has finished, its slot is no longer SLOT_LOADING
+
+    slot.path = path;
+    // Frames stay on the CPU, the stream uploads them. No GL work on the worker.
+    slot.player.setUseTexture(false);
+    slot.player.setPixelFormat(yuvUpload ? OF_PIXELS_NV12 : OF_PIXELS_RGB);
+    slot.state = SLOT_LOADING;
+    slot.shownFrame = -1;
+
+    Slot * target = &slot;
+    auto lookup = movieInfo;
+    auto load = [target, lookup]() {
+        ofVideoPlayer & player = target->player;
+        if (player.isLoaded()) player.close();
+
+        bool loaded = player.load(target->path);
+        if (loaded) {
+            // Pre-roll: opened, silent and parked on the first frame
+            player.setLoopState(OF_LOOP_NONE);
+            player.setVolume(0);
+            player.play();
+            player.setPaused(true);
+
+            // Keyframes plan the transport's seeks. The decoder fills in what the header lacks.
+            MovieInfo & movie = target->movie;
+            movie = MovieInfo();
+            if (!lookup || !lookup(target->path, movie)) MovieProbe::probe(target->path, movie);
+            if (movie.frameCount <= 0) movie.frameCount = player.getTotalNumFrames();
+            if (movie.duration <= 0.0f) movie.duration = player.getDuration();
+            if (movie.fps <= 0.0f && movie.duration > 0.0f) movie.fps = movie.frameCount / movie.duration;
+        }
+        target->state = loaded ? SLOT_LOADED : SLOT_FAILED;
+    };
+    if (frameStepped) load(); // Same clip state at the same step, however long the open takes
+    else loader = std::thread(load);
+}
+
+void ClipDeck::activate(Slot & slot) {
+    // Every clip gets its own jump sequence, the same one for the same clip order and seed
+    slot.transport.reset(slot.movie, transportSeed + 0x9E3779B97F4A7C15ull * ++clipsStarted);
+    slot.shownFrame = -1;
+    // Decoded ahead the player stays paused and is stepped by its worker
+    if (!frameStepped && decodeAheadFrames > 0) slot.decoder.start(&slot.player, slot.movie, decodeAheadFrames);
+}
+
+float ClipDeck::advance(Slot & slot, float dt, const BandFrame & frame, double presentTime) {
+    const ofPixels * pixels = nextFrame(slot, dt, frame, presentTime);
+    float ms = pixels && slot.stream.update(*pixels) ? slot.stream.getLastUploadMs() : 0.0f;
+    slot.decoder.release(); // Copied into the stream, the buffer can be decoded into again
+    return ms;
+}
+
+const ofPixels * ClipDeck::nextFrame(Slot & slot, float dt, const BandFrame & frame, double presentTime) {
+    if (!isClocked(slot)) {
+        slot.player.update();
+        return slot.player.isFrameNew() ? &slot.player.getPixels() : nullptr;
+    }
+
+    // The transport moves only while the clip is on screen, a primed clip stays on its first frame
+    if (dt > 0.0f) {
+        ClipTransport::Controls controls;
+        if (reactiveTransport) controls = transportControls;
+        controls.beats = frame.getBeats(presentTime);
+        controls.beatPeriod = frame.beatPeriod;
+        controls.beatLocked = reactiveTransport && frame.beatConfidence > 0.5f;
+        slot.transport.update(dt, controls);
+    }
+    int target = slot.transport.getFrame();
+
+    if (slot.decoder.isRunning()) {
+        slot.transport.predict(dt > 0.0f ? dt : 1.0f / 60.0f, slot.decoder.getCapacity(), plan);
+        slot.decoder.setPlan(plan);
+        if (target == slot.shownFrame) return nullptr;
+        const ofPixels * pixels = slot.decoder.acquire(target);
+        if (pixels) slot.shownFrame = target; // Missed frames keep the last one on screen
+        return pixels;
+    }
+
+    // Frame-stepped: seek to the transport's frame, only when it moves to a new one
+    if (target == slot.shownFrame) return nullptr;
+    slot.player.setFrame(target);
+    slot.shownFrame = target;
+    for (int wait = 0; wait < 2000; wait++) { // The decoder delivers the seek asynchronously
+        slot.player.update();
+        if (slot.player.isFrameNew()) return &slot.player.getPixels();
+        ofSleepMillis(1);
+    }
+    ofLogWarning() << "VIDEO: no frame " << target << " from " << slot.path;
+    return nullptr;
+}
+
+void ClipDeck::update(float dt, const BandFrame & frame, double presentTime) {
+    Slot & cur = slots[current];
+    Slot & next = slots[1 - current];
+
+    // --- CURRENT CLIP ---
+    if (cur.state == SLOT_LOADED) {
+        activate(cur);
+        if (!isClocked(cur)) cur.player.setPaused(false);
+        cur.state = SLOT_ACTIVE;
+        ofLogNotice() << "STARTING VIDEO: " << cur.path;
+    } else if (cur.state == SLOT_FAILED) {
+        ofLogError() << "FAILED TO LOAD VIDEO: " << cur.path;
+        cur.state = SLOT_EMPTY;
+        retryTimer = 1.0f;
+    }
+
+    if (cur.state == SLOT_EMPTY) {
+        retryTimer -= dt;
+        if (retryTimer <= 0.0f) prefetch(cur);
+        return;
+    }
+    if (cur.state != SLOT_ACTIVE) return; // First clip still opening
+
+    float frameUploadMs = advance(cur, dt, frame, presentTime);
+
+    // --- PREFETCH ---
+    // Keep the other slot loaded with the next clip while this one plays
+    switch (next.state.load()) {
+        case SLOT_EMPTY:
+            retryTimer -= dt;
+            if (retryTimer <= 0.0f) prefetch(next);
+            break;
+        case SLOT_FAILED:
+            ofLogError() << "FAILED TO LOAD VIDEO: " << next.path;
+            next.state = SLOT_EMPTY;
+            retryTimer = 1.0f;
+            break;
+        case SLOT_LOADED:
+            // Upload the first frame now so the fade never starts on black
+            activate(next);
+            next.state = SLOT_PRIMED;
+            [[fallthrough]];
+        case SLOT_PRIMED:
+            // Parked on its first frame until the fade starts, decoding ahead from there
+            frameUploadMs += advance(next, phase == PHASE_FADING ? dt : 0.0f, frame, presentTime);
+            break;
+        default:
+            break;
+    }
+
+    // --- TRANSITION ---
+    // A decoded-ahead player belongs to its worker, the transport says where the clip is
+    bool clocked = isClocked(cur);
+    bool done = clocked ? cur.transport.isFinished() : cur.player.getIsMovieDone();
+    float remaining = clocked ? cur.transport.getRemaining() : cur.player.getDuration() * (1.0f - cur.player.getPosition());
+    bool locked = beatAligned && frame.beatConfidence > 0.5f;
+    double beats = frame.getBeats(presentTime);
+
+    if (phase == PHASE_IDLE && next.state == SLOT_PRIMED) {
+        // Leave room for the fade, plus up to one bar of waiting when aligned
+        float lead = crossfadeTime + (locked ? 4.0f * frame.beatPeriod : 0.0f);
+        if (done || remaining <= lead) {
+            phase = PHASE_WAITING;
+            targetBeat = (floor(beats / 4.0) + 1.0) * 4.0;
+            transitionMaxFrame = 0.0f;
+        }
+    }
+
+    if (phase != PHASE_IDLE) transitionMaxFrame = std::max(transitionMaxFrame, dt);
+
+    if (phase == PHASE_WAITING && (!locked || done || beats >= targetBeat)) {
+        if (!isClocked(next)) next.player.setPaused(false);
+        crossfade = 0.0f;
+        phase = PHASE_FADING;
+    }
+
+    if (phase == PHASE_FADING) {
+        // Hold at zero until the incoming clip has a frame on the GPU
+        if (next.stream.isAllocated()) {
+            crossfade += dt / std::max(crossfadeTime, 0.001f);
+        }
+        if (crossfade >= 1.0f) finishTransition();
+    }
+
+    // --- UPLOAD TIMING ---
+    uploadMs = frameUploadMs;
+    uploadWindowPeak = std::max(uploadWindowPeak, uploadMs);
+    uploadWindowTime += dt;
+    if (uploadWindowTime >= 1.0f) {
+        uploadPeakMs = uploadWindowPeak;
+        uploadWindowPeak = 0.0f;
+        uploadWindowTime = 0.0f;
+        decodePeakMs = decodeWindowPeak;
+        decodeWindowPeak = 0.0f;
+    }
+    for (auto & slot : slots) {
+        if (slot.state != SLOT_CLOSING) decodeWindowPeak = std::max(decodeWindowPeak, slot.decoder.takeDecodePeakMs());
+    }
+}
+
+void ClipDeck::finishTransition() {
+    Slot & old = slots[current];
+    current = 1 - current;
+    slots[current].state = SLOT_ACTIVE;
+    crossfade = 0.0f;
+    phase = PHASE_IDLE;
+
+    lastTransitionMaxFrame = transitionMaxFrame;
+    ofLogNotice() << "STARTING VIDEO: " << slots[current].path
+                  << " (longest frame during transition: " << ofToString(lastTransitionMaxFrame * 1000.0f, 1) << " ms)";
+
+    // Textures go back to the pool for the next clip. Stopping the decoder can wait for a seek
+    // in flight, so it and the player are closed on the loader thread; the slot is prefetched
+    // into again once that has emptied it.
+    old.stream.release();
+    old.closingBytes = getDecodeBytes(old);
+    old.state = SLOT_CLOSING;
+    Slot * target = &old;
+    runOnLoader([this, target]() { closeSlot(*target); });
+}
+
+ofVideoPlayer & ClipDeck::getIncoming() {
+    bool fading = phase == PHASE_FADING && slots[1 - current].stream.isAllocated();
+    return fading ? slots[1 - current].player : slots[current].player;
+}
+
+VideoTextureStream & ClipDeck::getIncomingStream() {
+    bool fading = phase == PHASE_FADING && slots[1 - current].stream.isAllocated();
+    return fading ? slots[1 - current].stream : slots[current].stream;
+}
+
+ClipDeck::DecodeStats ClipDeck::getDecodeStats() const {
+    DecodeStats stats;
+    if (closing) {
+        for (auto & slot : slots) stats.bytes += getDecodeBytes(slot);
+        return stats;
+    }
+    const DecodeAhead & decoder = slots[current].decoder;
+    stats.queued = decoder.getQueued();
+    stats.capacity = decoder.isRunning() ? decoder.getCapacity() : 0;
+    stats.decodeMs = decoder.getDecodeMs();
+    stats.decodePeakMs = decodePeakMs;
+    stats.underruns = decoder.getUnderruns();
+    stats.skipped = decoder.getSkipped();
+    stats.seeks = decoder.getSeeks();
+    const ClipTransport & transport = slots[current].transport;
+    stats.reversed = transport.isReversed();
+    stats.stuttering = transport.isStuttering();
+    stats.jumps = transport.getJumps();
+    for (auto & slot : slots) stats.bytes += getDecodeBytes(slot);
+    return stats;
+}
+
+size_t ClipDeck::getMemoryBytes() const {
+    size_t bytes = pool.getBytes();
+    for (auto & slot : slots) bytes += slot.stream.getBufferBytes() + getDecodeBytes(slot);
+    return bytes;
+}
+
+bool ClipDeck::isReady() const {
+    const Slot & cur = slots[current];
+    return cur.state == SLOT_ACTIVE && cur.stream.isAllocated();
+}
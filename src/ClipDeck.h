@@ -0,0 +1,144 @@
+#pragma once
+#include "ofMain.h"
+#include "BandFrame.h"
+#include "VideoTextureStream.h"
+#include "DecodeAhead.h"
+#include "ClipTransport.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Double-buffered clip player.
+// While one clip plays, the next clip is opened and pre-rolled on a worker thread.
+// The render thread only uploads frames (VideoTextureStream) and crossfades, so a clip change
+// never blocks update()/draw() on a file open. The old clip is closed on the worker as well.
+// Live clips are decoded ahead on their own threads (DecodeAhead). Which frame is shown is up
+// to the clip's ClipTransport (rate, reverse, stutter, beat jumps), and its plan of the frames
+// coming up is what the decoder works on.
+class ClipDeck {
+public:
+	ClipDeck();
+	~ClipDeck();
+
+	// Chooses the next clip on the render thread, given the one playing. Empty = none yet.
+	void setPicker(std::function<string(const string & playing)> picker);
+	// Keyframe index and frame count of a clip, e.g. from the library. Clips it does not know
+	// are probed on the loader thread.
+	void setMovieInfo(std::function<bool(const string & path, MovieInfo & info)> lookup);
+	void start(); // Begin loading the first clip, no-op once started
+	void stop(); // Close both players, waits for a pending load
+	// stop() without blocking the render thread: the textures go back to the pool at once, the
+	// pending load, decoders and players are finished on the loader thread. start() again once
+	// isClosing() is false.
+	void stopInBackground();
+	bool isClosing() const { return closing; }
+
+	// Render thread, once per frame. The frame supplies the beat grid for aligned transitions.
+	void update(float dt, const BandFrame & frame, double presentTime);
+
+	bool isReady() const; // Current clip has a texture to draw
+	ofVideoPlayer & getCurrent() { return slots[current].player; }
+	ofVideoPlayer & getIncoming(); // Same as current outside of a transition
+	VideoTextureStream & getCurrentStream() { return slots[current].stream; }
+	VideoTextureStream & getIncomingStream();
+	float getCrossfade() const { return crossfade; } // 0 = current only, 1 = incoming only
+
+	// Settings
+	float crossfadeTime = 1.5f; // Seconds
+	bool beatAligned = true; // Start transitions on the next bar once the tempo is locked
+	bool yuvUpload = true; // Ask players for NV12 and convert in the shader, applies to the next clip
+	// Frames each clip decodes ahead of the render loop, applies to the next clip. Costs up to
+	// (n + 1) frames of memory per slot; 0 decodes on the render thread in player.update().
+	int decodeAheadFrames = 8;
+	// Playback controls for the transport, set every frame (modulation). Without decode-ahead
+	// clips play linearly, frame-stepped renders follow the transport as well.
+	ClipTransport::Controls transportControls;
+	bool reactiveTransport = true; // Off = plain forward playback at rate 1
+	uint64_t transportSeed = 1; // Jump targets, each clip continues the sequence
+	// Offline rendering: clips open synchronously and stay paused, each update() advances the
+	// clip position by dt and seeks to the frame at that timestamp, so which video frame is
+	// shown depends only on the simulation clock, never on decode or render speed
+	bool frameStepped = false;
+
+	// CPU time spent uploading frames in the last update(), and the peak over the last second
+	float getUploadMs() const { return uploadMs; }
+	float getUploadPeakMs() const { return uploadPeakMs; }
+	size_t getBytesPerFrame() const { return slots[current].stream.getBytesPerFrame(); }
+
+	// Decode-ahead of the current clip: queue depth, worker decode time, frames that were due
+	// but not decoded yet, seeks, and the memory both slots hold in frame buffers. Only the
+	// memory while isClosing(), the decoders are the loader thread's then.
+	struct DecodeStats {
+		int queued = 0;
+		int capacity = 0;
+		float decodeMs = 0.0f;
+		float decodePeakMs = 0.0f; // Over the last second, both slots
+		uint64_t underruns = 0;
+		uint64_t skipped = 0; // Decoded but never shown
+		uint64_t seeks = 0;
+		size_t bytes = 0;
+		bool reversed = false; // Transport state of the current clip
+		bool stuttering = false;
+		int jumps = 0;
+	};
+	DecodeStats getDecodeStats() const;
+	// What the deck holds right now: pooled textures (also once stopped), PBOs and decode queues.
+	// Safe while isClosing(), the queues count as they were when the deck was handed off.
+	size_t getMemoryBytes() const;
+
+	// Longest frame time (seconds) seen during the most recent transition
+	float getLastTransitionMaxFrame() const { return lastTransitionMaxFrame; }
+
+private:
+	// SLOT_CLOSING: the loader thread stops the decoder and closes the player, then empties it
+	enum SlotState { SLOT_EMPTY, SLOT_LOADING, SLOT_LOADED, SLOT_PRIMED, SLOT_ACTIVE, SLOT_FAILED, SLOT_CLOSING };
+	enum Phase { PHASE_IDLE, PHASE_WAITING, PHASE_FADING };
+
+	struct Slot {
+		ofVideoPlayer player;
+		VideoTextureStream stream;
+		string path;
+		std::atomic<int> state { SLOT_EMPTY };
+		MovieInfo movie; // Filled by the loader
+		ClipTransport transport; // Position when frame-stepped or decoded ahead
+		int shownFrame = -1;
+		DecodeAhead decoder; // Running while the slot is decoded ahead, then owns the player
+		size_t closingBytes = 0; // Decode memory when it was handed to the loader thread
+	};
+
+	void prefetch(Slot & slot);
+	void activate(Slot & slot); // Loaded -> playing or decoding ahead, paused at the first frame
+	float advance(Slot & slot, float dt, const BandFrame & frame, double presentTime); // Upload ms
+	const ofPixels * nextFrame(Slot & slot, float dt, const BandFrame & frame, double presentTime); // New frame, if any
+	bool isClocked(const Slot & slot) const { return frameStepped || slot.decoder.isRunning(); } // Position is the transport's
+	void finishTransition();
+	void joinLoader();
+	// After whatever the loader thread is doing, inline when frame-stepped
+	void runOnLoader(std::function<void()> work);
+	void closeSlot(Slot & slot); // Loader thread
+	size_t getDecodeBytes(const Slot & slot) const; // The handed-off count while closing
+
+	std::function<string(const string &)> picker;
+	std::function<bool(const string &, MovieInfo &)> movieInfo;
+	uint64_t clipsStarted = 0;
+	vector<int> plan;
+	Slot slots[2];
+	int current = 0;
+	std::thread loader; // Owns the slot in SLOT_LOADING, or both while closing
+	std::atomic<bool> closing { false };
+
+	Phase phase = PHASE_IDLE;
+	double targetBeat = 0.0;
+	float crossfade = 0.0f;
+	float retryTimer = 0.0f;
+	float transitionMaxFrame = 0.0f;
+	float lastTransitionMaxFrame = 0.0f;
+
+	TexturePool pool;
+	float uploadMs = 0.0f;
+	float uploadPeakMs = 0.0f;
+	float uploadWindowPeak = 0.0f;
+	float uploadWindowTime = 0.0f;
+	float decodeWindowPeak = 0.0f;
+	float decodePeakMs = 0.0f;
+};
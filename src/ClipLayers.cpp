@@ -0,0 +1,156 @@
+#include "ClipLayers.h"
+
+ClipLayers::ClipLayers() {
+    // Bass layer keyed over the base, treble layer cut in by difference, mids added on top
+    layers[1].blend = ReactiveUniforms::BLEND_LUMA;
+    layers[2].blend = ReactiveUniforms::BLEND_DIFFERENCE;
+    layers[2].mosh = 0.5f;
+    layers[3].blend = ReactiveUniforms::BLEND_ADD;
+    layers[3].mosh = 0.0f;
+
+    // Picks go through the plan, so a smaller budget applies from each layer's next clip
+    for (int i = 0; i < MAX_LAYERS; i++) {
+        decks[i].setPicker([this, i](const string & playing) {
+            string path;
+            path.swap(firstClip[i]);
+            if (!path.empty()) return path;
+            path = pickClip(i, playing);
+            if (path.empty() && i > 0) overBudget[i] = true;
+            return path;
+        });
+    }
+}
+
+void ClipLayers::setPicker(std::function<string(const string & playing, int maxHeight)> newPicker) {
+    picker = newPicker;
+}
+
+void ClipLayers::setMovieInfo(std::function<bool(const string & path, MovieInfo & info)> lookup) {
+    movieInfo = lookup;
+    for (auto & deck : decks) deck.setMovieInfo(lookup);
+}
+
+string ClipLayers::pickClip(int layer, const string & playing) {
+    if (!picker) return "";
+    string path = picker(playing, plan.maxClipHeight);
+    if (layer == 0) return path.empty() ? picker(playing, 0) : path; // The base always plays, at any size if it must
+    if (path.empty()) return path;
+
+    // One more slot at the clip's real height on top of everything held now. Offline clips
+    // are not indexed and open synchronously anyway, live ones of unknown size never fit.
+    MovieInfo movie;
+    bool known = movieInfo && movieInfo(path, movie);
+    if (!known && decks[0].frameStepped) known = MovieProbe::probe(path, movie);
+    if (!known || movie.height <= 0) return "";
+    size_t slotBytes = LayerBudget::getLayerBytes(movie.height, decks[0].decodeAheadFrames, decks[0].yuvUpload) / 2;
+    size_t held = getMemoryBytes();
+    if (held + slotBytes > memoryBudget) {
+        ofLogNotice() << "LAYERS: layer " << layer + 1 << " clip " << movie.height << "p over budget, "
+                      << ((held + slotBytes) >> 20) << " of " << (memoryBudget >> 20) << "MB";
+        return "";
+    }
+    return path;
+}
+
+void ClipLayers::updatePlan() {
+    int wanted = std::min(std::max(maxLayers, 1), (int)MAX_LAYERS);
+    plan = LayerBudget::plan(memoryBudget, wanted, decks[0].decodeAheadFrames, decks[0].yuvUpload, maxClipHeight);
+}
+
+void ClipLayers::start() {
+    updatePlan(); // The base clip's first pick already leaves room for the overlays
+    decks[0].start();
+    running[0] = true;
+}
+
+void ClipLayers::stop() {
+    for (int i = 0; i < MAX_LAYERS; i++) {
+        decks[i].stop();
+        running[i] = false;
+        overBudget[i] = false;
+        firstClip[i].clear();
+    }
+}
+
+void ClipLayers::syncSettings(ClipDeck & deck) {
+    const ClipDeck & base = decks[0];
+    deck.crossfadeTime = base.crossfadeTime;
+    deck.beatAligned = base.beatAligned;
+    deck.yuvUpload = base.yuvUpload;
+    deck.decodeAheadFrames = base.decodeAheadFrames;
+    deck.transportControls = base.transportControls;
+    deck.reactiveTransport = base.reactiveTransport;
+    deck.frameStepped = base.frameStepped;
+}
+
+void ClipLayers::update(float dt, const BandFrame & frame, double presentTime) {
+    ClipDeck & base = decks[0];
+    updatePlan();
+    base.update(dt, frame, presentTime);
+
+    // --- OVERLAYS ---
+    // Started once the base clip plays and a first clip fits, stopped when the plan drops them
+    // or their next clip does not fit. A stopped overlay closes in the background and can
+    // start again once it has.
+    for (int i = 1; i < MAX_LAYERS; i++) {
+        ClipDeck & deck = decks[i];
+        startDelay[i] = std::max(startDelay[i] - dt, 0.0f);
+        if (!running[i] && running[0] && base.isReady() && i < plan.layers && startDelay[i] <= 0.0f && !deck.isClosing()) {
+            firstClip[i] = pickClip(i, "");
+            if (firstClip[i].empty()) {
+                startDelay[i] = 2.0f;
+                continue;
+            }
+            syncSettings(deck);
+            deck.transportSeed = base.transportSeed + i; // Its own jumps, the same ones for the same seed
+            deck.start();
+            running[i] = true;
+            ofLogNotice() << "LAYERS: layer " << i + 1 << " of " << plan.layers << " started, clips up to "
+                          << (plan.maxClipHeight > 0 ? ofToString(plan.maxClipHeight) : "any height");
+        } else if (running[i] && (i >= plan.layers || overBudget[i])) {
+            deck.stopInBackground(); // Hidden from this frame on, a clip still opening is waited for off the render thread
+            running[i] = false;
+            ofLogNotice() << "LAYERS: layer " << i + 1 << " stopped, " << (overBudget[i] ? "no next clip fits" : ofToString(plan.layers) + " fit");
+            overBudget[i] = false;
+            startDelay[i] = 2.0f;
+        }
+        if (!running[i]) continue;
+
+        syncSettings(deck);
+        deck.update(dt, frame, presentTime);
+    }
+}
+
+float ClipLayers::getVisibility(int layer) const {
+    if (layer <= 0 || layer >= MAX_LAYERS || !running[layer] || !decks[layer].isReady()) return 0.0f;
+    // Fades out to the middle of a clip change and back in on the next clip
+    return std::fabs(1.0f - 2.0f * decks[layer].getCrossfade());
+}
+
+VideoTextureStream & ClipLayers::getStream(int layer) {
+    return isShowingIncoming(layer) ? decks[layer].getIncomingStream() : decks[layer].getCurrentStream();
+}
+
+ofVideoPlayer & ClipLayers::getPlayer(int layer) {
+    return isShowingIncoming(layer) ? decks[layer].getIncoming() : decks[layer].getCurrent();
+}
+
+int ClipLayers::getNumLayers() const {
+    int count = 0;
+    for (bool layer : running) count += layer ? 1 : 0;
+    return count;
+}
+
+float ClipLayers::getUploadPeakMs() const {
+    float ms = 0.0f;
+    for (int i = 0; i < MAX_LAYERS; i++) {
+        if (running[i]) ms += decks[i].getUploadPeakMs();
+    }
+    return ms;
+}
+
+size_t ClipLayers::getMemoryBytes() const {
+    size_t bytes = 0;
+    for (auto & deck : decks) bytes += deck.getMemoryBytes();
+    return bytes;
+}
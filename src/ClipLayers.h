@@ -0,0 +1,75 @@
+#pragma once
+#include "ofMain.h"
+#include "ClipDeck.h"
+#include "LayerBudget.h"
+#include "ReactiveUniforms.h"
+#include <functional>
+
+// Up to MAX_LAYERS clips on screen at once, all composited in the one scene pass.
+// Layer 0 is the base clip, the overlays are blended over it in shader.frag (luma key,
+// difference or add) with an opacity the music drives (modulation targets layer1..layer3).
+// Every layer is its own ClipDeck with prefetch and decode-ahead. The base crossfades in the
+// shader as before; an overlay dips out and back in when its clip changes, so the shader
+// only ever needs one clip per overlay. How many layers run and the largest clip they pick
+// are planned against a memory budget (LayerBudget) every frame; overlays that no longer
+// fit are stopped, new ones start as the budget and the quality governor allow. Each
+// overlay clip is also checked at its real height against what the decks hold right now
+// (pooled textures, PBOs, decode queues): an overlay does not start, or stops, when its
+// next clip would go over the budget.
+// Render thread only.
+class ClipLayers {
+public:
+	static const int MAX_LAYERS = ReactiveUniforms::MAX_OVERLAYS + 1;
+
+	struct Layer {
+		ReactiveUniforms::BlendMode blend = ReactiveUniforms::BLEND_LUMA;
+		float mosh = 1.0f; // Share of the mosh displacement and RGB split, 0 = the clip as is
+	};
+
+	ClipLayers();
+
+	// Chooses a layer's next clip given the one it plays and the largest height the plan
+	// allows (0 = any)
+	void setPicker(std::function<string(const string & playing, int maxHeight)> picker);
+	void setMovieInfo(std::function<bool(const string & path, MovieInfo & info)> lookup);
+	void start(); // Base layer, the overlays follow in update()
+	void stop(); // All layers
+
+	// Once per frame. Overlays take the base deck's settings.
+	void update(float dt, const BandFrame & frame, double presentTime);
+
+	bool isReady() const { return decks[0].isReady(); }
+	ClipDeck & getBase() { return decks[0]; } // Settings set here apply to every layer
+
+	// Overlays 1..MAX_LAYERS-1: the clip on screen (current, or incoming past the middle of a
+	// change) and how far it is faded in, 0 while the layer is stopped or has no frame yet
+	float getVisibility(int layer) const;
+	VideoTextureStream & getStream(int layer);
+	ofVideoPlayer & getPlayer(int layer);
+
+	int getNumLayers() const; // Running, the base included
+	const LayerBudget::Plan & getPlan() const { return plan; }
+	float getUploadPeakMs() const; // All layers
+	size_t getMemoryBytes() const; // Held by all decks, stopped ones' pooled textures included
+
+	// Settings
+	Layer layers[MAX_LAYERS]; // [0] is the base clip, drawn as it comes
+	int maxLayers = 1; // Wanted, the plan may run fewer
+	int maxClipHeight = 0; // Cap from outside (quality governor), 0 = none
+	size_t memoryBudget = (size_t)512 << 20; // Bytes for all layers' textures, PBOs and queues
+
+private:
+	void updatePlan();
+	void syncSettings(ClipDeck & deck);
+	string pickClip(int layer, const string & playing); // Empty = nothing fits
+	bool isShowingIncoming(int layer) const { return decks[layer].getCrossfade() >= 0.5f; }
+
+	ClipDeck decks[MAX_LAYERS];
+	bool running[MAX_LAYERS] = {};
+	bool overBudget[MAX_LAYERS] = {}; // Next clip rejected, stopped in update()
+	string firstClip[MAX_LAYERS]; // Checked before the layer starts, the deck's first pick
+	float startDelay[MAX_LAYERS] = {}; // Seconds before another try at starting
+	std::function<string(const string &, int)> picker;
+	std::function<bool(const string &, MovieInfo &)> movieInfo;
+	LayerBudget::Plan plan;
+};
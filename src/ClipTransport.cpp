@@ -0,0 +1,128 @@
+#include "ClipTransport.h"
+#include <algorithm>
+#include <cmath>
+
+void ClipTransport::reset(const MovieInfo & clip, uint64_t seed) {
+    movie = clip;
+    fps = movie.fps > 0.0f ? movie.fps : 30.0f;
+    frameCount = std::max(1, movie.frameCount > 0 ? movie.frameCount : (int)(movie.duration * fps));
+    rng.setSeed(seed);
+    state = State();
+    last = Controls();
+    finished = false;
+    reversed = false;
+    reverseUntilBeat = 0.0;
+    nextJumpBeat = -1.0;
+    pendingJump = -1;
+    jumps = 0;
+}
+
+int ClipTransport::clampFrame(double position) const {
+    return std::min(std::max((int)std::floor(position), 0), frameCount - 1);
+}
+
+int ClipTransport::getFrame() const {
+    return clampFrame(state.position);
+}
+
+float ClipTransport::getRemaining() const {
+    float rate = std::min(std::max(last.rate, settings.minRate), settings.maxRate);
+    return (float)((frameCount - 1 - state.position) / (fps * rate));
+}
+
+bool ClipTransport::advance(State & s, float dt, const Controls & controls, bool reverse) const {
+    // Stutter: replay the last fraction of a beat at normal speed until it is let go
+    if (controls.stutter && !s.looping) {
+        s.looping = true;
+        s.loopLength = std::max(2.0, (double)settings.stutterBeats * controls.beatPeriod * fps);
+        s.loopStart = std::max(0.0, s.position - s.loopLength);
+        s.loopLength = std::max(1.0, s.position - s.loopStart);
+        s.loopTime = 0.0;
+        s.resumeAt = s.position;
+    } else if (!controls.stutter && s.looping) {
+        s.looping = false;
+        s.position = s.resumeAt;
+    }
+    if (s.looping) {
+        s.loopTime += dt * fps;
+        s.position = s.loopStart + std::fmod(s.loopTime, s.loopLength);
+        return false;
+    }
+
+    float rate = std::min(std::max(controls.rate, settings.minRate), settings.maxRate);
+    s.position += (reverse ? -1.0 : 1.0) * rate * dt * fps;
+    if (s.position <= 0.0) s.position = 0.0; // Reversed into the start, hold the first frame
+    if (s.position >= frameCount - 1) {
+        s.position = frameCount - 1;
+        return true;
+    }
+    return false;
+}
+
+int ClipTransport::pickJumpTarget() {
+    // Keyframes decode without a run-up, any frame will do when the clip has no index
+    int current = getFrame();
+    int minDistance = (int)(settings.minJumpSeconds * fps);
+    int lastUsable = std::max(0, frameCount - 1 - (int)(settings.jumpEveryBeats * last.beatPeriod * fps)); // Room for the next section
+    for (int attempt = 0; attempt < 8; attempt++) {
+        int target = movie.keyframes.empty() ? rng.index(lastUsable + 1) : (int)movie.keyframes[rng.index((int)movie.keyframes.size())];
+        if (target <= lastUsable && std::abs(target - current) >= minDistance) return target;
+    }
+    return movie.keyframeAtOrBefore(rng.index(lastUsable + 1));
+}
+
+void ClipTransport::update(float dt, const Controls & controls) {
+    last = controls;
+
+    // --- BEAT JUMPS ---
+    // Scheduled on the beat grid, the target is known jumpLeadBeats early for the decoder
+    bool jumping = controls.beatLocked && settings.jumpEveryBeats > 0 && !finished;
+    if (!jumping) {
+        nextJumpBeat = -1.0;
+        pendingJump = -1;
+    } else {
+        double every = settings.jumpEveryBeats;
+        if (nextJumpBeat < 0.0) nextJumpBeat = (std::floor(controls.beats / every) + 1.0) * every;
+        if (pendingJump < 0 && controls.beats >= nextJumpBeat - settings.jumpLeadBeats) pendingJump = pickJumpTarget();
+        if (controls.beats >= nextJumpBeat) {
+            state = State();
+            state.position = pendingJump;
+            jumps++;
+            if (rng.uniform() < settings.reverseChance) reverseUntilBeat = controls.beats + settings.reverseBeats;
+            nextJumpBeat += every;
+            pendingJump = -1;
+        }
+    }
+
+    // --- PLAYBACK ---
+    reversed = controls.reverse || controls.beats < reverseUntilBeat;
+    if (advance(state, dt, controls, reversed)) finished = true;
+}
+
+void ClipTransport::predict(float dt, int maxFrames, std::vector<int> & plan) const {
+    plan.clear();
+    if (maxFrames <= 0) return;
+    auto add = [&](int frame) {
+        if ((int)plan.size() < maxFrames && std::find(plan.begin(), plan.end(), frame) == plan.end()) plan.push_back(frame);
+    };
+    add(getFrame());
+
+    // The jump is the frame most likely to miss its deadline: it comes right after the next few
+    int afterCurrent = std::min(3, maxFrames / 4);
+    State s = state;
+    Controls controls = last;
+    dt = std::max(dt, 1.0f / 240.0f);
+    for (int step = 0; step < maxFrames * 4 && (int)plan.size() < maxFrames; step++) {
+        if (step == afterCurrent && pendingJump >= 0) {
+            add(pendingJump);
+            add(clampFrame(pendingJump + 1));
+        }
+        controls.beats += dt / std::max(controls.beatPeriod, 0.05f);
+        if (pendingJump >= 0 && controls.beats >= nextJumpBeat) break; // Past the jump, the frames after it are planned
+        bool reverse = controls.reverse || controls.beats < reverseUntilBeat;
+        bool end = advance(s, dt, controls, reverse);
+        add(clampFrame(s.position));
+        if (end) break;
+    }
+    if (pendingJump >= 0) add(pendingJump); // Short plans still carry it
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "MovieProbe.h"
+#include "SeededRandom.h"
+#include <vector>
+
+// Audio-reactive transport for one clip: playback rate, reverse, stutter loops and jumps to
+// a new position on the beat. Decides which source frame is on screen every render frame and
+// predicts which frames the next moments will need, so the decoder can seek and decode them
+// before they are due (DecodeAhead). Jump targets are keyframes from the clip's index, picked
+// a couple of beats early, so a jump costs one seek and one decode that happen ahead of time.
+// No openFrameworks dependency.
+class ClipTransport {
+public:
+	struct Settings {
+		float minRate = 0.25f;
+		float maxRate = 3.0f;
+		int jumpEveryBeats = 16; // On every nth beat while the tempo is locked, 0 = never
+		float jumpLeadBeats = 2.0f; // The target is chosen (and pre-decoded) this early
+		float minJumpSeconds = 2.0f; // Land at least this far from the current position
+		float reverseChance = 0.25f; // After a jump, play the next reverseBeats backwards
+		int reverseBeats = 4;
+		float stutterBeats = 0.25f; // Loop length while stuttering
+	};
+
+	// Per frame input: modulation targets plus the beat grid
+	struct Controls {
+		float rate = 1.0f;
+		bool reverse = false;
+		bool stutter = false;
+		double beats = 0.0; // BandFrame::getBeats() at the present time
+		float beatPeriod = 0.5f;
+		bool beatLocked = false;
+	};
+
+	void reset(const MovieInfo & movie, uint64_t seed);
+	void update(float dt, const Controls & controls);
+
+	int getFrame() const; // Source frame to show
+	bool isFinished() const { return finished; } // Forward playback ran into the end
+	float getRemaining() const; // Seconds until the end at the current rate, forward
+	bool isReversed() const { return reversed; }
+	bool isStuttering() const { return state.looping; }
+	int getJumps() const { return jumps; }
+
+	// Frames the next steps of dt will show, in the order they are needed (current first),
+	// plus the pending jump target and the frames after it. At most maxFrames, no repeats.
+	void predict(float dt, int maxFrames, std::vector<int> & plan) const;
+
+	Settings settings;
+
+private:
+	struct State {
+		double position = 0.0; // Frames
+		bool looping = false;
+		double loopStart = 0.0;
+		double loopLength = 1.0;
+		double loopTime = 0.0;
+		double resumeAt = 0.0; // Where playback continues after the loop
+	};
+
+	// Moves s by dt at the controls' rate and direction, true when it ran into the end
+	bool advance(State & s, float dt, const Controls & controls, bool reverse) const;
+	int pickJumpTarget();
+	int clampFrame(double position) const;
+
+	MovieInfo movie;
+	float fps = 30.0f;
+	int frameCount = 1;
+	SeededRandom rng;
+
+	State state;
+	Controls last; // Controls of the last update(), predict() assumes they hold
+	bool finished = false;
+	bool reversed = false;
+	double reverseUntilBeat = 0.0;
+	double nextJumpBeat = -1.0; // < 0 = not scheduled
+	int pendingJump = -1; // Target frame of the scheduled jump, once chosen
+	int jumps = 0;
+};
@@ -0,0 +1,203 @@
+#include "DecodeAhead.h"
+#include <chrono>
+
+// Stepping forward beats a seek when the target is this close, even across a keyframe
+static const int MAX_STEP_RUN = 8;
+
+void DecodeAhead::start(ofVideoPlayer * clipPlayer, const MovieInfo & clipMovie, int maxFrames) {
+    stop();
+    player = clipPlayer;
+    movie = clipMovie;
+    capacity = std::max(2, maxFrames);
+    buffers.reset(new Buffer[capacity]);
+    reading = -1;
+    plans.allocate(4);
+    plan = Plan();
+    lastPlan = Plan();
+    decoderFrame = -1;
+    endFrame = INT_MAX;
+    decodeMs = decodePeakMs = 0.0f;
+    frameBytes = 0;
+    skipped = seeks = 0;
+    underruns = 0;
+    quit = false;
+    worker = std::thread(&DecodeAhead::workerLoop, this);
+}
+
+void DecodeAhead::stop() {
+    if (!worker.joinable()) return;
+    quit = true;
+    worker.join();
+    player = nullptr;
+}
+
+// --- RENDER THREAD ---
+
+void DecodeAhead::setPlan(const vector<int> & frames) {
+    Plan next;
+    next.count = std::min((int)frames.size(), MAX_PLAN);
+    for (int i = 0; i < next.count; i++) next.frames[i] = frames[i];
+    lastPlan = next;
+    plans.push(next); // Full means the worker has three newer-than-it-knows plans already, dropping one is fine
+}
+
+const ofPixels * DecodeAhead::acquire(int frame) {
+    release();
+    for (int i = 0; i < capacity; i++) {
+        Buffer & buffer = buffers[i];
+        if (buffer.frame.load(std::memory_order_acquire) != frame) continue;
+        int expected = BUFFER_READY;
+        if (!buffer.state.compare_exchange_strong(expected, BUFFER_READING)) continue;
+        if (buffer.frame.load(std::memory_order_relaxed) != frame) { // Evicted between the two loads
+            buffer.state = BUFFER_READY;
+            continue;
+        }
+        buffer.shown = true;
+        reading = i;
+        return &buffer.pixels;
+    }
+    underruns++;
+    return nullptr;
+}
+
+void DecodeAhead::release() {
+    if (reading < 0) return;
+    buffers[reading].state.store(BUFFER_READY, std::memory_order_release);
+    reading = -1;
+}
+
+int DecodeAhead::getQueued() const {
+    int queued = 0;
+    for (int i = 0; i < lastPlan.count; i++) {
+        if (isCached(lastPlan.frames[i])) queued++;
+    }
+    return queued;
+}
+
+// --- WORKER ---
+
+bool DecodeAhead::isCached(int frame) const {
+    for (int i = 0; i < capacity; i++) {
+        int state = buffers[i].state.load(std::memory_order_acquire);
+        if ((state == BUFFER_READY || state == BUFFER_READING) && buffers[i].frame.load(std::memory_order_relaxed) == frame) return true;
+    }
+    return false;
+}
+
+bool DecodeAhead::isPlanned(int frame) const {
+    for (int i = 0; i < plan.count; i++) {
+        if (plan.frames[i] == frame) return true;
+    }
+    return false;
+}
+
+void DecodeAhead::workerLoop() {
+    // The pre-rolled player already holds frame 0
+    if (waitForFrame() || player->getPixels().isAllocated()) {
+        decoderFrame = 0;
+        store(0);
+    }
+
+    while (!quit) {
+        Plan next;
+        while (plans.pop(next)) plan = next;
+
+        // Soonest planned frame that is missing
+        int target = -1;
+        for (int i = 0; i < plan.count && target < 0; i++) {
+            if (plan.frames[i] < endFrame && !isCached(plan.frames[i])) target = plan.frames[i];
+        }
+        if (target < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!decode(target)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2)); // Retried with the next plan
+            continue;
+        }
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        decodeMs = ms;
+        if (ms > decodePeakMs) decodePeakMs = ms; // Only the render thread lowers it
+    }
+}
+
+bool DecodeAhead::waitForFrame() {
+    for (int wait = 0; wait < 500 && !quit; wait++) {
+        player->update();
+        if (player->isFrameNew()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false; // Half a second without a frame: past the end or a decoder that gave up
+}
+
+bool DecodeAhead::decode(int target) {
+    if (target == decoderFrame) return store(target); // Evicted while the player still holds it
+
+    // Step when the target is ahead in the same group of pictures or just a few frames on,
+    // otherwise start over from its keyframe
+    int keyframe = movie.keyframeAtOrBefore(target);
+    bool step = decoderFrame >= 0 && decoderFrame < target && (decoderFrame >= keyframe || target - decoderFrame <= MAX_STEP_RUN);
+    if (!step) {
+        player->setFrame(keyframe);
+        seeks++;
+        if (!waitForFrame()) {
+            decoderFrame = -1;
+            return false;
+        }
+        decoderFrame = keyframe;
+        if (isPlanned(keyframe) && !isCached(keyframe) && !store(keyframe)) return false;
+    }
+
+    // Run up to the target, keeping every frame the plan asks for on the way
+    while (decoderFrame < target && !quit) {
+        player->nextFrame();
+        if (!waitForFrame()) {
+            endFrame = decoderFrame + 1; // The container counted more frames than the decoder delivers
+            decoderFrame = -1;
+            return false;
+        }
+        decoderFrame++;
+        if (isPlanned(decoderFrame) && !isCached(decoderFrame) && !store(decoderFrame)) return false;
+    }
+    return decoderFrame == target;
+}
+
+bool DecodeAhead::store(int frame) {
+    // A free buffer, else the unplanned frame furthest from what is needed now. A second look
+    // when the render thread grabbed the chosen one for upload in the meantime.
+    int nowFrame = plan.count > 0 ? plan.frames[0] : frame;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int victim = -1;
+        int victimDistance = -1;
+        for (int i = 0; i < capacity; i++) {
+            int state = buffers[i].state.load(std::memory_order_acquire);
+            if (state == BUFFER_FREE) {
+                victim = i;
+                break;
+            }
+            int cached = buffers[i].frame.load(std::memory_order_relaxed);
+            if (state != BUFFER_READY || isPlanned(cached)) continue;
+            int distance = std::abs(cached - nowFrame);
+            if (distance > victimDistance) {
+                victim = i;
+                victimDistance = distance;
+            }
+        }
+        if (victim < 0) return false; // Every buffer holds a planned frame
+
+        Buffer & buffer = buffers[victim];
+        int expected = buffer.state.load(std::memory_order_relaxed);
+        if (expected == BUFFER_READING || !buffer.state.compare_exchange_strong(expected, BUFFER_WRITING)) continue;
+        if (expected == BUFFER_READY && !buffer.shown) skipped++;
+
+        buffer.frame.store(frame, std::memory_order_relaxed);
+        buffer.pixels = player->getPixels();
+        buffer.shown = false;
+        frameBytes = buffer.pixels.size();
+        buffer.state.store(BUFFER_READY, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
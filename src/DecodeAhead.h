@@ -0,0 +1,89 @@
+#pragma once
+#include "ofMain.h"
+#include "MovieProbe.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <thread>
+
+// Decodes a clip on its own thread into a bounded cache of frames, ahead of the render loop.
+// The render thread hands over a plan: the source frames it will show next, in the order it
+// needs them (ClipTransport::predict). The worker owns the (paused) player and fills the
+// cache in plan order: it steps forward when the next frame is close, otherwise it seeks to
+// the keyframe at or before it (from the clip's index) and decodes up from there, keeping
+// every planned frame it passes. Reverse playback therefore costs one seek per cache-full of
+// frames and a beat jump to a keyframe one seek, both done before the frames are due.
+// The render thread only looks frames up and never waits: a frame that is not decoded in
+// time leaves the previous one on screen and counts as an underrun.
+// Memory is bounded by maxFrames frame buffers.
+class DecodeAhead {
+public:
+	static const int MAX_PLAN = 64;
+
+	~DecodeAhead() { stop(); }
+
+	// player must be loaded and parked on its first frame. Nothing else may touch it until stop().
+	void start(ofVideoPlayer * player, const MovieInfo & movie, int maxFrames);
+	void stop(); // Joins the worker, the player is the caller's again
+	bool isRunning() const { return worker.joinable(); }
+
+	// Render thread
+	void setPlan(const vector<int> & frames); // Needed next, soonest first, at most MAX_PLAN
+	// The decoded frame, nullptr when it is not in the cache (yet). The pixels stay valid
+	// until release(), call it once they are uploaded.
+	const ofPixels * acquire(int frame);
+	void release();
+
+	int getQueued() const; // Frames of the current plan that are decoded
+	int getCapacity() const { return capacity; }
+	float getDecodeMs() const { return decodeMs; } // Last planned frame incl. its seek and run-up
+	float takeDecodePeakMs() { return decodePeakMs.exchange(0.0f); } // Peak since the last call
+	uint64_t getUnderruns() const { return underruns; } // Frames due on screen that were not decoded yet
+	uint64_t getSkipped() const { return skipped; } // Decoded frames evicted without being shown
+	uint64_t getSeeks() const { return seeks; }
+	size_t getBytes() const { return (size_t)capacity * frameBytes; }
+
+private:
+	enum BufferState { BUFFER_FREE, BUFFER_WRITING, BUFFER_READY, BUFFER_READING };
+
+	struct Buffer {
+		ofPixels pixels;
+		std::atomic<int> frame { -1 };
+		std::atomic<int> state { BUFFER_FREE };
+		std::atomic<bool> shown { false };
+	};
+
+	struct Plan {
+		int count = 0;
+		int frames[MAX_PLAN];
+	};
+
+	void workerLoop();
+	bool decode(int target); // Into the cache, false when the decoder failed or the cache is full of plan frames
+	bool waitForFrame(); // Polls the player until the frame asked for arrives
+	bool store(int frame); // The player's current pixels into a free or evictable buffer
+	bool isCached(int frame) const;
+	bool isPlanned(int frame) const; // Worker's copy of the plan
+
+	ofVideoPlayer * player = nullptr;
+	MovieInfo movie;
+	std::unique_ptr<Buffer[]> buffers;
+	int capacity = 0;
+	int reading = -1; // Buffer between acquire() and release(), render thread
+
+	SpscRing<Plan> plans; // Render -> worker, the newest one wins
+	Plan plan; // Worker
+	Plan lastPlan; // Render thread, for getQueued()
+	int decoderFrame = -1; // Frame the player holds, -1 = unknown (seek first)
+	int endFrame = INT_MAX; // First frame the decoder could not step to, never planned again
+
+	std::thread worker;
+	std::atomic<bool> quit { false };
+	std::atomic<float> decodeMs { 0.0f };
+	std::atomic<float> decodePeakMs { 0.0f };
+	std::atomic<size_t> frameBytes { 0 };
+	std::atomic<uint64_t> skipped { 0 };
+	std::atomic<uint64_t> seeks { 0 };
+	uint64_t underruns = 0;
+};
@@ -0,0 +1,69 @@
+#include "FrameHistory.h"
+#include <algorithm>
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+void FrameHistory::clear() {
+    for (auto & frame : frames) frame = BandFrame();
+    newest = 0;
+    count = 0;
+    age = 0.0;
+}
+
+void FrameHistory::push(const BandFrame & frame) {
+    newest = (newest + 1) % SIZE;
+    frames[newest] = frame;
+    count = std::min(count + 1, SIZE);
+}
+
+void FrameHistory::observe(double now) {
+    if (count == 0) return;
+    double current = now - frames[newest].time;
+    // Up at once, down by a little per render frame
+    age = current > age ? current : age + (current - age) * 0.005;
+}
+
+double FrameHistory::getDelay() const {
+    if (count < 2) return age;
+    return age + std::max(frames[newest].time - frames[(newest - 1 + SIZE) % SIZE].time, 0.0);
+}
+
+BandFrame FrameHistory::sample(double time, bool * blended) const {
+    if (blended) *blended = false;
+    const BandFrame & last = frames[newest];
+    if (count < 2 || time >= last.time) return last;
+
+    // Newest frame at or before time, walking back
+    for (int back = 1; back < count; back++) {
+        const BandFrame & before = frames[(newest - back + SIZE) % SIZE];
+        if (before.time > time) continue;
+        const BandFrame & after = frames[(newest - back + 1 + SIZE) % SIZE];
+        double span = after.time - before.time;
+        if (span <= 0.0) return after;
+
+        float alpha = (float)((time - before.time) / span);
+        BandFrame out = after;
+        out.time = time;
+        for (int i = 0; i < NUM_BANDS; i++) {
+            out.bands[i] = lerp(before.bands[i], after.bands[i], alpha);
+        }
+        if (before.numSpectrumBands == after.numSpectrumBands) {
+            for (int i = 0; i < after.numSpectrumBands; i++) {
+                out.spectrum[i] = lerp(before.spectrum[i], after.spectrum[i], alpha);
+            }
+        }
+        if (before.numChannelBandSets == after.numChannelBandSets) {
+            for (int c = 0; c < after.numChannelBandSets; c++) {
+                for (int i = 0; i < NUM_BANDS; i++) {
+                    out.channelBands[c][i] = lerp(before.channelBands[c][i], after.channelBands[c][i], alpha);
+                }
+            }
+        }
+        out.stereoWidth = lerp(before.stereoWidth, after.stereoWidth, alpha);
+        if (blended) *blended = true;
+        return out;
+    }
+    return frames[(newest - count + 1 + SIZE) % SIZE]; // Older than everything kept
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "BandFrame.h"
+
+// The render thread's most recent analysis frames, and how far back to sample them.
+// Frames are a hop apart on the analyzer clock but arrive in bursts, one device buffer or
+// analysis wakeup at a time, so the newest one is anywhere from a few ms to a buffer or more
+// old when a render frame reads it. Sampling by the largest age seen lately plus one hop
+// keeps the time sampled between two frames that are already here, even when a frame comes
+// in a little later than any before, and the bands blend from frame to frame instead of
+// holding the newest one. No openFrameworks dependency.
+class FrameHistory {
+public:
+	static const int SIZE = 16; // Frames kept, bursts of up to SIZE - 1 hops still blend
+
+	void clear();
+	void push(const BandFrame & frame);
+	const BandFrame & getNewest() const { return frames[newest]; } // Empty frame before the first push
+
+	// Live: how old the newest frame is at now on the analyzer clock, held at its peak and
+	// let down slowly (a few seconds), so the sample time stays steady
+	void observe(double now);
+	double getAge() const { return age; }
+	double getDelay() const; // How far before now to sample: the age plus one hop
+
+	// Interpolated between the two frames around time, the nearest one outside them.
+	// blended: set to whether two frames bracketed time.
+	BandFrame sample(double time, bool * blended = nullptr) const;
+
+private:
+	BandFrame frames[SIZE];
+	int newest = 0;
+	int count = 0;
+	double age = 0.0;
+};
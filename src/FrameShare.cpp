@@ -0,0 +1,111 @@
+#include "FrameShare.h"
+#include <chrono>
+
+bool FrameShare::start(const string & segmentName, int slots, int numBuffers) {
+    stop();
+    name = segmentName;
+    numSlots = slots;
+    readbacks.resize(std::max(2, numBuffers));
+    pboSize = 0;
+    writeIndex = readIndex = inFlight = 0;
+    captured = dropped = 0;
+    running = true;
+    ofLogNotice() << "SHARE: frames go to shared memory " << name << " once the first one is drawn";
+    return true;
+}
+
+void FrameShare::stop() {
+    if (!running) return;
+    for (auto & readback : readbacks) release(readback);
+    writer.close();
+    running = false;
+    ofLogNotice() << "SHARE: stopped after " << writer.getSequence() << " frames, " << dropped << " dropped";
+}
+
+void FrameShare::release(Readback & readback) {
+    if (readback.fence) glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+}
+
+bool FrameShare::resize(int width, int height) {
+    // The segment is sized for one resolution, readers see it closed and reopen the new one
+    size_t bytes = (size_t)width * height * 4;
+    for (auto & readback : readbacks) release(readback);
+    writeIndex = readIndex = inFlight = 0;
+    if (!writer.open(name, numSlots, bytes)) {
+        ofLogError() << "SHARE: " << writer.getError();
+        running = false;
+        return false;
+    }
+    for (auto & readback : readbacks) readback.pbo.allocate(bytes, GL_STREAM_READ);
+    pboSize = bytes;
+    ofLogNotice() << "SHARE: " << name << " " << width << "x" << height << " RGBA, " << numSlots << " slots";
+    return true;
+}
+
+void FrameShare::capture(const ofFbo & fbo, uint64_t renderMicros) {
+    if (!running) return;
+    int width = (int)fbo.getWidth();
+    int height = (int)fbo.getHeight();
+    if (width <= 0 || height <= 0) return;
+    if ((size_t)width * height * 4 != pboSize && !resize(width, height)) return;
+
+    captured++;
+    if (inFlight == (int)readbacks.size()) {
+        dropped++; // The GPU is behind, skipping a frame beats stalling the render loop
+        return;
+    }
+
+    // glReadPixels into a bound pack buffer returns at once, the copy happens on the GPU
+    Readback & readback = readbacks[writeIndex];
+    writeIndex = (writeIndex + 1) % (int)readbacks.size();
+    inFlight++;
+    readback.renderMicros = renderMicros;
+    readback.width = width;
+    readback.height = height;
+    readback.frame = captured;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getId());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo.getId());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameShare::publish() {
+    if (!running) return;
+
+    // Oldest first, stop at the first readback the GPU has not finished
+    while (inFlight > 0) {
+        Readback & readback = readbacks[readIndex];
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        release(readback);
+        readIndex = (readIndex + 1) % (int)readbacks.size();
+        inFlight--;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t bytes = (size_t)readback.width * readback.height * 4;
+        uint8_t * target = writer.beginFrame();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo.getId());
+        const void * pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (target && pixels) {
+            memcpy(target, pixels, bytes);
+            SharedFrameRing::Frame frame;
+            frame.renderMicros = readback.renderMicros;
+            frame.width = readback.width;
+            frame.height = readback.height;
+            frame.stride = readback.width * 4;
+            frame.format = SharedFrameRing::FORMAT_RGBA8;
+            frame.flags = SharedFrameRing::FLAG_BOTTOM_UP;
+            writer.publish(frame);
+        }
+        if (pixels) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        copyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        readbackFrames = (float)(captured - readback.frame);
+    }
+}
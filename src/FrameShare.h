@@ -0,0 +1,53 @@
+#pragma once
+#include "ofMain.h"
+#include "SharedFrameRing.h"
+
+// Publishes finished frames to a SharedFrameRing for a local encoder or streaming process.
+// capture() queues an asynchronous glReadPixels into the next pixel buffer object and drops
+// a fence behind it; publish() copies every readback whose fence has passed into the shared
+// ring. Nothing waits on the GPU: when all buffers are still in flight the frame is dropped
+// and counted instead. Frames go out as RGBA8, bottom row first. Render thread only.
+class FrameShare {
+public:
+	static constexpr const char * DEFAULT_NAME = "/cognitoni-frames";
+
+	bool start(const string & name = DEFAULT_NAME, int numSlots = 4, int numBuffers = 3);
+	void stop(); // GL context required, the segment alone is also removed on destruction
+	bool isRunning() const { return running; }
+
+	// Queue the readback of a finished frame, renderMicros = SharedFrameRing::nowMicros() when it was drawn
+	void capture(const ofFbo & fbo, uint64_t renderMicros);
+	void publish(); // Hand finished readbacks to the ring, call once per frame before capture()
+
+	uint64_t getPublished() const { return writer.getSequence(); }
+	uint64_t getDropped() const { return dropped; }
+	float getCopyMs() const { return copyMs; } // CPU time of the last map + copy
+	float getReadbackFrames() const { return readbackFrames; } // Frames captured after the last published one was
+
+private:
+	struct Readback {
+		ofBufferObject pbo;
+		GLsync fence = nullptr;
+		uint64_t renderMicros = 0;
+		int width = 0;
+		int height = 0;
+		uint64_t frame = 0; // capture() count when queued
+	};
+
+	bool resize(int width, int height);
+	void release(Readback & readback);
+
+	SharedFrameWriter writer;
+	string name;
+	int numSlots = 4;
+	bool running = false;
+	vector<Readback> readbacks;
+	size_t pboSize = 0;
+	int writeIndex = 0; // Next buffer capture() uses
+	int readIndex = 0; // Oldest buffer in flight
+	int inFlight = 0;
+	uint64_t captured = 0;
+	uint64_t dropped = 0;
+	float copyMs = 0.0f;
+	float readbackFrames = 0.0f;
+};
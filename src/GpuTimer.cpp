@@ -0,0 +1,36 @@
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer() {
+    if (created) glDeleteQueries(NUM_QUERIES, queries);
+}
+
+void GpuTimer::begin() {
+    if (!created) {
+        glGenQueries(NUM_QUERIES, queries);
+        created = true;
+    }
+
+    // Collect whatever finished since the last frames, oldest first
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        int index = (current + i) % NUM_QUERIES;
+        if (!pending[index]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+        ms = (float)(elapsed / 1.0e6);
+        pending[index] = false;
+    }
+
+    // Reuse a query only once its result has been read (or it is too old to matter)
+    pending[current] = false;
+    glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+
+void GpuTimer::end() {
+    if (!created) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[current] = true;
+    current = (current + 1) % NUM_QUERIES;
+}
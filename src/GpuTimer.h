@@ -0,0 +1,21 @@
+#pragma once
+#include "ofMain.h"
+
+// GL_TIME_ELAPSED query ring. Results are read a few frames later, when the GPU has them,
+// so timing never stalls the pipeline. Begin/end pairs must not nest with other timers.
+class GpuTimer {
+public:
+	~GpuTimer();
+
+	void begin();
+	void end();
+	float getMs() const { return ms; } // Latest finished measurement
+
+private:
+	static const int NUM_QUERIES = 4;
+	GLuint queries[NUM_QUERIES] = {};
+	bool pending[NUM_QUERIES] = {};
+	bool created = false;
+	int current = 0;
+	float ms = 0.0f;
+};
@@ -0,0 +1,155 @@
+#include "InputStage.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define INPUT_STAGE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define INPUT_STAGE_NEON
+#endif
+
+int InputStage::getNumStreams(ChannelMode mode) {
+    switch (mode) {
+        case CHANNEL_MODE_STEREO: return 3; // mid, left, right
+        case CHANNEL_MODE_MID_SIDE: return 2; // mid, side
+        default: return 1; // mid
+    }
+}
+
+void InputStage::setup(ChannelMode newMode, int newLeft, int newRight) {
+    mode = newMode;
+    leftChannel = std::max(0, newLeft);
+    rightChannel = newRight;
+    numStreams = getNumStreams(mode);
+
+    left.assign(MAX_BLOCK, 0.0f);
+    right.assign(MAX_BLOCK, 0.0f);
+    side.assign(MAX_BLOCK, 0.0f);
+    streams.assign(numStreams, std::vector<float>(MAX_BLOCK, 0.0f));
+    midEnergy = 0.0f;
+    sideEnergy = 0.0f;
+}
+
+void InputStage::process(const float * in, int numFrames, int numChannels) {
+    numFrames = std::min(numFrames, MAX_BLOCK);
+    if (numChannels <= 0 || streams.empty()) return;
+
+    // Fall back to what the device actually delivered
+    int l = (leftChannel < numChannels) ? leftChannel : 0;
+    int r = (rightChannel >= 0 && rightChannel < numChannels && rightChannel != l) ? rightChannel : -1;
+
+    // Write straight into the output streams where the mode keeps that signal
+    float * mid = streams[0].data();
+    float * outLeft = (mode == CHANNEL_MODE_STEREO) ? streams[1].data() : left.data();
+    float * outRight = (mode == CHANNEL_MODE_STEREO) ? streams[2].data() : right.data();
+    float * outSide = (mode == CHANNEL_MODE_MID_SIDE) ? streams[1].data() : side.data();
+
+    if (r < 0) {
+        // Mono source: every stream carries the one channel, side is silent
+        if (numChannels == 1) {
+            std::memcpy(mid, in, sizeof(float) * numFrames);
+        } else {
+            for (int i = 0; i < numFrames; i++) mid[i] = in[i * numChannels + l];
+        }
+        float energy = 0.0f;
+        for (int i = 0; i < numFrames; i++) energy += mid[i] * mid[i];
+        if (mode == CHANNEL_MODE_STEREO) {
+            std::memcpy(outLeft, mid, sizeof(float) * numFrames);
+            std::memcpy(outRight, mid, sizeof(float) * numFrames);
+        } else if (mode == CHANNEL_MODE_MID_SIDE) {
+            std::memset(outSide, 0, sizeof(float) * numFrames);
+        }
+        midEnergy = energy;
+        sideEnergy = 0.0f;
+        return;
+    }
+
+    deinterleave(in, numFrames, numChannels, l, r, outLeft, outRight);
+    midSide(outLeft, outRight, numFrames, mid, outSide, midEnergy, sideEnergy);
+}
+
+void InputStage::deinterleave(const float * in, int numFrames, int numChannels, int l, int r, float * outLeft, float * outRight) {
+    int i = 0;
+
+    // Plain stereo is the common case and the only layout worth vectorizing
+    if (numChannels == 2 && l == 0 && r == 1) {
+#if defined(INPUT_STAGE_SSE)
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128 a = _mm_loadu_ps(in + i * 2); // L0 R0 L1 R1
+            __m128 b = _mm_loadu_ps(in + i * 2 + 4); // L2 R2 L3 R3
+            _mm_storeu_ps(outLeft + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(outRight + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#elif defined(INPUT_STAGE_NEON)
+        for (; i + 4 <= numFrames; i += 4) {
+            float32x4x2_t lr = vld2q_f32(in + i * 2);
+            vst1q_f32(outLeft + i, lr.val[0]);
+            vst1q_f32(outRight + i, lr.val[1]);
+        }
+#endif
+    }
+
+    // Arbitrary channel pairs out of multichannel interfaces
+    for (; i < numFrames; i++) {
+        outLeft[i] = in[i * numChannels + l];
+        outRight[i] = in[i * numChannels + r];
+    }
+}
+
+void InputStage::midSide(const float * l, const float * r, int numFrames, float * mid, float * side, float & midEnergy, float & sideEnergy) {
+    int i = 0;
+    float me = 0.0f;
+    float se = 0.0f;
+
+#if defined(INPUT_STAGE_SSE)
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 accMid = _mm_setzero_ps();
+    __m128 accSide = _mm_setzero_ps();
+    for (; i + 4 <= numFrames; i += 4) {
+        __m128 a = _mm_loadu_ps(l + i);
+        __m128 b = _mm_loadu_ps(r + i);
+        __m128 m = _mm_mul_ps(_mm_add_ps(a, b), half);
+        __m128 s = _mm_mul_ps(_mm_sub_ps(a, b), half);
+        _mm_storeu_ps(mid + i, m);
+        _mm_storeu_ps(side + i, s);
+        accMid = _mm_add_ps(accMid, _mm_mul_ps(m, m));
+        accSide = _mm_add_ps(accSide, _mm_mul_ps(s, s));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, accMid);
+    me = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_ps(lanes, accSide);
+    se = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(INPUT_STAGE_NEON)
+    float32x4_t accMid = vdupq_n_f32(0.0f);
+    float32x4_t accSide = vdupq_n_f32(0.0f);
+    for (; i + 4 <= numFrames; i += 4) {
+        float32x4_t a = vld1q_f32(l + i);
+        float32x4_t b = vld1q_f32(r + i);
+        float32x4_t m = vmulq_n_f32(vaddq_f32(a, b), 0.5f);
+        float32x4_t s = vmulq_n_f32(vsubq_f32(a, b), 0.5f);
+        vst1q_f32(mid + i, m);
+        vst1q_f32(side + i, s);
+        accMid = vmlaq_f32(accMid, m, m);
+        accSide = vmlaq_f32(accSide, s, s);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, accMid);
+    me = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    vst1q_f32(lanes, accSide);
+    se = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; i < numFrames; i++) {
+        float m = (l[i] + r[i]) * 0.5f;
+        float s = (l[i] - r[i]) * 0.5f;
+        mid[i] = m;
+        side[i] = s;
+        me += m * m;
+        se += s * s;
+    }
+    midEnergy = me;
+    sideEnergy = se;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+// How the selected input channels feed the analyzer
+enum ChannelMode {
+	CHANNEL_MODE_MONO = 0, // Downmix only
+	CHANNEL_MODE_STEREO, // Downmix plus separate left and right band sets
+	CHANNEL_MODE_MID_SIDE, // Downmix (mid) plus a side band set
+	NUM_CHANNEL_MODES
+};
+
+// Realtime front end of the analyzer.
+// Picks the analysis channels out of an interleaved device buffer (any channel count),
+// deinterleaves them and builds the planar streams the analysis thread consumes:
+// stream 0 is always the mid/downmix, followed by left + right or side depending on the
+// mode. Scratch buffers are allocated in setup(), process() never touches the heap.
+class InputStage {
+public:
+	static const int MAX_BLOCK = 4096; // Frames per process() call, callers chunk larger buffers
+
+	// leftChannel / rightChannel are zero-based device channels, rightChannel < 0 for a mono source
+	void setup(ChannelMode mode, int leftChannel, int rightChannel);
+
+	// Audio thread
+	void process(const float * interleaved, int numFrames, int numChannels);
+
+	int getNumStreams() const { return numStreams; }
+	const float * getStream(int index) const { return streams[index].data(); }
+	// Sum of squares of mid and side over the last process() call (side is 0 for mono sources)
+	float getMidEnergy() const { return midEnergy; }
+	float getSideEnergy() const { return sideEnergy; }
+
+	static int getNumStreams(ChannelMode mode);
+
+	// Kernels, exposed for benchmarks
+	static void deinterleave(const float * in, int numFrames, int numChannels, int left, int right, float * outLeft, float * outRight);
+	static void midSide(const float * left, const float * right, int numFrames, float * mid, float * side, float & midEnergy, float & sideEnergy);
+
+private:
+	ChannelMode mode = CHANNEL_MODE_MONO;
+	int leftChannel = 0;
+	int rightChannel = 1;
+	int numStreams = 1;
+
+	std::vector<float> left;
+	std::vector<float> right;
+	std::vector<float> side;
+	std::vector<std::vector<float>> streams;
+	float midEnergy = 0.0f;
+	float sideEnergy = 0.0f;
+};
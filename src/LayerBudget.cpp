@@ -0,0 +1,37 @@
+#include "LayerBudget.h"
+#include <algorithm>
+
+const int LayerBudget::HEIGHTS[NUM_HEIGHTS] = { 2160, 1440, 1080, 720, 540 };
+
+int LayerBudget::getFramesPerLayer(int decodeAheadFrames) {
+    // Per slot: texture + 3 PBOs + the decode queue (the player's pixels without one)
+    int decoded = decodeAheadFrames > 0 ? decodeAheadFrames + 1 : 1;
+    return 2 * (4 + decoded);
+}
+
+size_t LayerBudget::getLayerBytes(int clipHeight, int decodeAheadFrames, bool yuv) {
+    size_t width = ((size_t)clipHeight * 16 + 8) / 9;
+    size_t frameBytes = width * clipHeight * (yuv ? 3 : 6) / 2;
+    return frameBytes * getFramesPerLayer(decodeAheadFrames);
+}
+
+LayerBudget::Plan LayerBudget::plan(size_t budgetBytes, int maxLayers, int decodeAheadFrames, bool yuv, int maxClipHeight) {
+    Plan result;
+    for (int layers = std::max(maxLayers, 1); layers >= 1; layers--) {
+        for (int i = 0; i < NUM_HEIGHTS; i++) {
+            int height = maxClipHeight > 0 ? std::min(HEIGHTS[i], maxClipHeight) : HEIGHTS[i];
+            size_t bytes = getLayerBytes(height, decodeAheadFrames, yuv) * layers;
+            if (bytes > budgetBytes) continue;
+            result.layers = layers;
+            result.maxClipHeight = (i == 0 && maxClipHeight <= 0) ? 0 : height; // The largest rung is no cap
+            result.bytes = bytes;
+            return result;
+        }
+    }
+
+    // Nothing fits: the base clip alone, as small as the library has
+    result.layers = 1;
+    result.maxClipHeight = maxClipHeight > 0 ? std::min(HEIGHTS[NUM_HEIGHTS - 1], maxClipHeight) : HEIGHTS[NUM_HEIGHTS - 1];
+    result.bytes = getLayerBytes(result.maxClipHeight, decodeAheadFrames, yuv);
+    return result;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+// How many clip layers can play at once, and at what clip size, within a memory budget.
+// Each layer is a ClipDeck: two slots (playing + prefetched), each holding a texture, the
+// stream's three PBOs and the decode-ahead queue (frames + 1, or the player's own frame when
+// decode-ahead is off). Clips are assumed 16:9, NV12 at 1.5 bytes per pixel, RGB at 3.
+// The plan keeps as many layers as fit at the smallest height and gives them the largest
+// height that fits all of them. No openFrameworks dependency.
+class LayerBudget {
+public:
+	static const int NUM_HEIGHTS = 5;
+	static const int HEIGHTS[NUM_HEIGHTS]; // Clip height caps, largest first
+
+	struct Plan {
+		int layers = 1;
+		int maxClipHeight = 0; // Clips up to this height, 0 = any
+		size_t bytes = 0; // Estimate for that many layers at that height
+	};
+
+	// Frames' worth of memory one layer holds
+	static int getFramesPerLayer(int decodeAheadFrames);
+	static size_t getLayerBytes(int clipHeight, int decodeAheadFrames, bool yuv);
+
+	// maxClipHeight: a cap from elsewhere (quality governor), 0 = none. One layer is always
+	// planned, at the smallest height if even that is over budget.
+	static Plan plan(size_t budgetBytes, int maxLayers, int decodeAheadFrames, bool yuv, int maxClipHeight = 0);
+};
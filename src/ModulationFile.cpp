@@ -0,0 +1,52 @@
+#include "ModulationFile.h"
+#include "ofxJSON.h"
+
+bool ModulationFile::load(const string & path, ModulationMatrix & matrix) {
+    ofxJSONElement json;
+    if (!json.open(path)) {
+        ofLogWarning() << "MODULATION: could not read " << path << ", keeping current mapping";
+        return false;
+    }
+
+    // Start from the built-in mapping so a file only overrides what it names
+    ModulationMatrix loaded;
+
+    const Json::Value & base = json["base"];
+    for (int i = 0; i < NUM_MOD_TARGETS; i++) {
+        const char * name = ModulationMatrix::getTargetName((ModTarget)i);
+        if (base.isMember(name)) loaded.setBase((ModTarget)i, base[name].asFloat());
+    }
+
+    auto readRange = [](const Json::Value & value, float & low, float & high) {
+        if (value.isArray() && value.size() == 2) {
+            low = value[0].asFloat();
+            high = value[1].asFloat();
+        }
+    };
+
+    if (json.isMember("routes")) {
+        vector<ModRoute> routes;
+        const Json::Value & list = json["routes"];
+        for (int i = 0; i < (int)list.size(); i++) {
+            const Json::Value & entry = list[i];
+            ModRoute route;
+            if (!ModulationMatrix::findSource(entry["source"].asString(), route.source) ||
+                !ModulationMatrix::findTarget(entry["target"].asString(), route.target)) {
+                ofLogWarning() << "MODULATION: skipping route " << i << ", unknown source or target";
+                continue;
+            }
+            readRange(entry["in"], route.inMin, route.inMax);
+            readRange(entry["out"], route.outMin, route.outMax);
+            if (entry.isMember("clamp")) route.clamp = entry["clamp"].asBool();
+            if (entry.isMember("step")) route.step = entry["step"].asBool();
+            if (entry.isMember("attack")) route.attack = std::max(0.0f, entry["attack"].asFloat());
+            if (entry.isMember("release")) route.release = std::max(0.0f, entry["release"].asFloat());
+            routes.push_back(route);
+        }
+        loaded.setRoutes(routes);
+    }
+
+    matrix = loaded;
+    ofLogNotice() << "MODULATION: " << matrix.getRoutes().size() << " routes from " << path;
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "ofMain.h"
+#include "ModulationMatrix.h"
+
+// modulation.json: "base" values per target and a list of "routes"
+// (source, target, in: [a, b], out: [a, b], optional clamp, step, attack, release).
+// Shared by the live app and the offline analysis.
+class ModulationFile {
+public:
+	// Starts from the built-in mapping so a file only overrides what it names.
+	// Leaves matrix untouched and returns false when the file cannot be read.
+	static bool load(const string & path, ModulationMatrix & matrix);
+};
@@ -0,0 +1,159 @@
+#include "ModulationMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+static const char * sourceNames[NUM_MOD_SOURCES] = {
+    "subBass", "lowMids", "mids", "highMids", "treble",
+    "impact", "stereoWidth", "beatPhase", "beatPulse", "beatConfidence",
+    "flux.subBass", "flux.lowMids", "flux.mids", "flux.highMids", "flux.treble",
+    "constant"
+};
+
+static const char * targetNames[NUM_MOD_TARGETS] = {
+    "pixelSize", "rgbShift", "invert", "lowThresh", "highThresh",
+    "zoom", "bounce", "jitter", "blurAlpha", "brightness", "slice",
+    "clipRate", "clipReverse", "clipStutter",
+    "layer1", "layer2", "layer3"
+};
+
+ModulationMatrix::ModulationMatrix() {
+    setDefaults();
+}
+
+float ModulationMatrix::getDefaultBase(ModTarget target) {
+    switch (target) {
+        case MOD_DST_LOW_THRESH: return 0.10f; // Patterns trigger earlier
+        case MOD_DST_HIGH_THRESH: return 0.80f; // Blocks trigger earlier
+        case MOD_DST_ZOOM: return 1.0f;
+        case MOD_DST_BOUNCE: return 1.0f;
+        case MOD_DST_CLIP_RATE: return 1.0f;
+        default: return 0.0f;
+    }
+}
+
+void ModulationMatrix::setDefaults() {
+    for (int i = 0; i < NUM_MOD_TARGETS; i++) base[i] = getDefaultBase((ModTarget)i);
+
+    auto route = [](ModSource src, ModTarget dst, float inMin, float inMax, float outMin, float outMax, bool clamp) {
+        ModRoute r;
+        r.source = src;
+        r.target = dst;
+        r.inMin = inMin;
+        r.inMax = inMax;
+        r.outMin = outMin;
+        r.outMax = outMax;
+        r.clamp = clamp;
+        return r;
+    };
+
+    std::vector<ModRoute> defaults;
+    defaults.push_back(route(MOD_SRC_TREBLE, MOD_DST_PIXEL_SIZE, 0.1f, 1.2f, 1.0f, 14.0f, true));
+    defaults.push_back(route(MOD_SRC_SUB_BASS, MOD_DST_RGB_SHIFT, 0.0f, 1.0f, 0.0f, 8.0f, false));
+    defaults.push_back(route(MOD_SRC_IMPACT, MOD_DST_RGB_SHIFT, 0.0f, 1.0f, 0.0f, 120.0f, false));
+
+    // High-bass invert trigger
+    ModRoute invert = route(MOD_SRC_SUB_BASS, MOD_DST_INVERT, 0.8f, 0.8f, 0.0f, 1.0f, true);
+    invert.step = true;
+    defaults.push_back(invert);
+
+    defaults.push_back(route(MOD_SRC_MIDS, MOD_DST_BLUR_ALPHA, 0.2f, 0.8f, 80.0f, 15.0f, true));
+    defaults.push_back(route(MOD_SRC_HIGH_MIDS, MOD_DST_JITTER, 0.3f, 1.0f, 0.0f, 0.3f, true));
+    defaults.push_back(route(MOD_SRC_IMPACT, MOD_DST_BOUNCE, 0.0f, 1.0f, 0.0f, 18.0f, false));
+    defaults.push_back(route(MOD_SRC_HIGH_MIDS, MOD_DST_BRIGHTNESS, 0.2f, 0.8f, 150.0f, 190.0f, true));
+    defaults.push_back(route(MOD_SRC_MIDS, MOD_DST_SLICE, 0.0f, 1.0f, 0.0f, 1.0f, false));
+
+    // Impact zoom: the old per-frame 0.4 attack / 0.08 release lerps at 60fps
+    ModRoute zoom = route(MOD_SRC_IMPACT, MOD_DST_ZOOM, 0.05f, 0.5f, 0.0f, 0.35f, true);
+    zoom.attack = 0.033f;
+    zoom.release = 0.2f;
+    defaults.push_back(zoom);
+    defaults.push_back(route(MOD_SRC_BEAT_PULSE, MOD_DST_ZOOM, 0.0f, 1.0f, 0.0f, 0.04f, true));
+
+    // Clip transport: busier mids run the video faster, hard hits stutter it
+    ModRoute rate = route(MOD_SRC_MIDS, MOD_DST_CLIP_RATE, 0.2f, 1.0f, -0.25f, 0.75f, true);
+    rate.attack = 0.25f;
+    rate.release = 1.0f;
+    defaults.push_back(rate);
+    ModRoute stutter = route(MOD_SRC_IMPACT, MOD_DST_CLIP_STUTTER, 0.6f, 0.6f, 0.0f, 1.0f, true);
+    stutter.step = true;
+    stutter.release = 0.15f;
+    defaults.push_back(stutter);
+
+    // Overlay layers: a bass layer that swells under a treble layer, the third follows the mids
+    ModRoute bassLayer = route(MOD_SRC_SUB_BASS, MOD_DST_LAYER1, 0.2f, 0.9f, 0.0f, 0.9f, true);
+    bassLayer.attack = 0.05f;
+    bassLayer.release = 0.6f;
+    defaults.push_back(bassLayer);
+    ModRoute trebleLayer = route(MOD_SRC_TREBLE, MOD_DST_LAYER2, 0.15f, 0.7f, 0.0f, 0.7f, true);
+    trebleLayer.attack = 0.02f;
+    trebleLayer.release = 0.3f;
+    defaults.push_back(trebleLayer);
+    ModRoute midLayer = route(MOD_SRC_MIDS, MOD_DST_LAYER3, 0.3f, 1.0f, 0.0f, 0.6f, true);
+    midLayer.attack = 0.1f;
+    midLayer.release = 0.8f;
+    defaults.push_back(midLayer);
+
+    setRoutes(defaults);
+}
+
+void ModulationMatrix::setRoutes(const std::vector<ModRoute> & newRoutes) {
+    routes = newRoutes;
+    envelopes.assign(routes.size(), 0.0f);
+}
+
+float ModulationMatrix::smoothTowards(float current, float target, float tau, float dt) {
+    if (tau <= 0.0f) return target;
+    return current + (target - current) * (1.0f - std::exp(-dt / tau));
+}
+
+void ModulationMatrix::update(float dt) {
+    for (int i = 0; i < NUM_MOD_TARGETS; i++) values[i] = base[i];
+
+    for (size_t i = 0; i < routes.size(); i++) {
+        const ModRoute & r = routes[i];
+        float x = (r.source == MOD_SRC_CONSTANT) ? 1.0f : sources[r.source];
+
+        float y;
+        if (r.step) {
+            y = (x >= r.inMin) ? r.outMax : r.outMin;
+        } else {
+            float range = r.inMax - r.inMin;
+            float t = (range != 0.0f) ? (x - r.inMin) / range : 0.0f;
+            if (r.clamp) t = std::min(1.0f, std::max(0.0f, t));
+            y = r.outMin + t * (r.outMax - r.outMin);
+        }
+
+        // Attack while rising, release while falling
+        float & env = envelopes[i];
+        env = smoothTowards(env, y, (y > env) ? r.attack : r.release, dt);
+        values[r.target] += env;
+    }
+}
+
+const char * ModulationMatrix::getSourceName(ModSource source) {
+    return sourceNames[source];
+}
+
+const char * ModulationMatrix::getTargetName(ModTarget target) {
+    return targetNames[target];
+}
+
+bool ModulationMatrix::findSource(const std::string & name, ModSource & out) {
+    for (int i = 0; i < NUM_MOD_SOURCES; i++) {
+        if (name == sourceNames[i]) {
+            out = (ModSource)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ModulationMatrix::findTarget(const std::string & name, ModTarget & out) {
+    for (int i = 0; i < NUM_MOD_TARGETS; i++) {
+        if (name == targetNames[i]) {
+            out = (ModTarget)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Analysis features a route can read
+enum ModSource {
+	MOD_SRC_SUB_BASS = 0,
+	MOD_SRC_LOW_MIDS,
+	MOD_SRC_MIDS,
+	MOD_SRC_HIGH_MIDS,
+	MOD_SRC_TREBLE,
+	MOD_SRC_IMPACT, // Onset-driven hit envelope
+	MOD_SRC_STEREO_WIDTH,
+	MOD_SRC_BEAT_PHASE, // 0..1 across each beat
+	MOD_SRC_BEAT_PULSE, // 1 on the beat, decaying over it, scaled by confidence
+	MOD_SRC_BEAT_CONFIDENCE,
+	MOD_SRC_FLUX_SUB_BASS,
+	MOD_SRC_FLUX_LOW_MIDS,
+	MOD_SRC_FLUX_MIDS,
+	MOD_SRC_FLUX_HIGH_MIDS,
+	MOD_SRC_FLUX_TREBLE,
+	MOD_SRC_CONSTANT, // Always 1
+	NUM_MOD_SOURCES
+};
+
+// Reactive parameters a route can drive
+enum ModTarget {
+	MOD_DST_PIXEL_SIZE = 0,
+	MOD_DST_RGB_SHIFT,
+	MOD_DST_INVERT,
+	MOD_DST_LOW_THRESH,
+	MOD_DST_HIGH_THRESH,
+	MOD_DST_ZOOM,
+	MOD_DST_BOUNCE,
+	MOD_DST_JITTER,
+	MOD_DST_BLUR_ALPHA,
+	MOD_DST_BRIGHTNESS,
+	MOD_DST_SLICE,
+	MOD_DST_CLIP_RATE, // Playback speed of the clip, 1 = normal (ClipTransport)
+	MOD_DST_CLIP_REVERSE, // > 0.5 plays the clip backwards
+	MOD_DST_CLIP_STUTTER, // > 0.5 loops the last fraction of a beat
+	MOD_DST_LAYER1, // Opacity of the overlay clip layers (ClipLayers), 0 = hidden
+	MOD_DST_LAYER2,
+	MOD_DST_LAYER3,
+	NUM_MOD_TARGETS
+};
+
+// One source -> target mapping: a range remap followed by an attack/release envelope.
+// Routes into the same target are summed on top of the target's base value.
+struct ModRoute {
+	ModSource source = MOD_SRC_CONSTANT;
+	ModTarget target = MOD_DST_ZOOM;
+	float inMin = 0.0f;
+	float inMax = 1.0f;
+	float outMin = 0.0f;
+	float outMax = 1.0f;
+	bool clamp = true;
+	bool step = false; // outMax at or above inMin, else outMin
+	float attack = 0.0f; // Seconds, 0 = follow instantly
+	float release = 0.0f;
+};
+
+// Data-driven mapping from analysis features to shader/draw parameters.
+// Envelopes are integrated against the real frame time, so the response is the same at
+// 30, 60 or 144 fps. Routes are normally loaded from modulation.json (see ofApp).
+class ModulationMatrix {
+public:
+	ModulationMatrix();
+
+	// The mapping the app shipped with before it was data-driven
+	void setDefaults();
+	void setRoutes(const std::vector<ModRoute> & routes);
+	const std::vector<ModRoute> & getRoutes() const { return routes; }
+	void setBase(ModTarget target, float value) { base[target] = value; }
+
+	void setSource(ModSource source, float value) { sources[source] = value; }
+	void update(float dt);
+	float get(ModTarget target) const { return values[target]; }
+
+	static const char * getSourceName(ModSource source);
+	static const char * getTargetName(ModTarget target);
+	// Return false for unknown names
+	static bool findSource(const std::string & name, ModSource & out);
+	static bool findTarget(const std::string & name, ModTarget & out);
+	static float getDefaultBase(ModTarget target);
+
+	// dt-correct one-pole smoothing towards target with time constant tau (seconds)
+	static float smoothTowards(float current, float target, float tau, float dt);
+
+private:
+	std::vector<ModRoute> routes;
+	std::vector<float> envelopes; // One per route
+	float sources[NUM_MOD_SOURCES] = {};
+	float base[NUM_MOD_TARGETS] = {};
+	float values[NUM_MOD_TARGETS] = {};
+};
@@ -0,0 +1,183 @@
+#include "MovieProbe.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define probeSeek _fseeki64
+#else
+#define probeSeek fseeko
+#endif
+
+static uint16_t readU16(const uint8_t * p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t readU32(const uint8_t * p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static uint64_t readU64(const uint8_t * p) {
+    return (uint64_t)readU32(p) << 32 | readU32(p + 4);
+}
+
+struct Box {
+    const uint8_t * payload = nullptr;
+    size_t size = 0;
+    const uint8_t * type = nullptr;
+};
+
+// Step to the next child box in [data, data + size), false at the end or on a corrupt header
+static bool nextBox(const uint8_t * data, size_t size, size_t & pos, Box & box) {
+    if (pos + 8 > size) return false;
+    uint64_t boxSize = readU32(data + pos);
+    size_t header = 8;
+    if (boxSize == 1) {
+        if (pos + 16 > size) return false;
+        boxSize = readU64(data + pos + 8);
+        header = 16;
+    } else if (boxSize == 0) {
+        boxSize = size - pos; // Runs to the end of the parent
+    }
+    if (boxSize < header || boxSize > size - pos) return false;
+
+    box.type = data + pos + 4;
+    box.payload = data + pos + header;
+    box.size = (size_t)boxSize - header;
+    pos += (size_t)boxSize;
+    return true;
+}
+
+static bool findBox(const uint8_t * data, size_t size, const char * type, Box & out) {
+    size_t pos = 0;
+    Box box;
+    while (nextBox(data, size, pos, box)) {
+        if (memcmp(box.type, type, 4) == 0) {
+            out = box;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MovieProbe::parseMoov(const uint8_t * data, size_t size, MovieInfo & info) {
+    size_t pos = 0;
+    Box trak;
+    while (nextBox(data, size, pos, trak)) {
+        if (memcmp(trak.type, "trak", 4) != 0) continue;
+
+        Box mdia, hdlr, mdhd, minf, stbl, stsd, stts, stss;
+        if (!findBox(trak.payload, trak.size, "mdia", mdia)) continue;
+        if (!findBox(mdia.payload, mdia.size, "hdlr", hdlr) || hdlr.size < 12) continue;
+        if (memcmp(hdlr.payload + 8, "vide", 4) != 0) continue; // Not the video track
+
+        // Media timescale and duration
+        if (!findBox(mdia.payload, mdia.size, "mdhd", mdhd) || mdhd.size < 20) continue;
+        uint32_t timescale;
+        uint64_t duration;
+        if (mdhd.payload[0] == 1) {
+            if (mdhd.size < 32) continue;
+            timescale = readU32(mdhd.payload + 20);
+            duration = readU64(mdhd.payload + 24);
+        } else {
+            timescale = readU32(mdhd.payload + 12);
+            duration = readU32(mdhd.payload + 16);
+        }
+        if (timescale == 0) continue;
+        info.duration = (float)((double)duration / (double)timescale);
+
+        if (!findBox(mdia.payload, mdia.size, "minf", minf)) continue;
+        if (!findBox(minf.payload, minf.size, "stbl", stbl)) continue;
+
+        // First sample entry: codec fourcc, then the visual sample entry fields
+        if (findBox(stbl.payload, stbl.size, "stsd", stsd) && stsd.size >= 8 + 36) {
+            const uint8_t * entry = stsd.payload + 8;
+            info.codec.assign((const char *)entry + 4, 4);
+            info.width = readU16(entry + 32);
+            info.height = readU16(entry + 34);
+        }
+
+        // Frame rate from the sample count over the track duration
+        if (findBox(stbl.payload, stbl.size, "stts", stts) && stts.size >= 8) {
+            uint32_t entries = readU32(stts.payload + 4);
+            uint64_t samples = 0;
+            for (uint32_t i = 0; i < entries && 8 + (size_t)(i + 1) * 8 <= stts.size; i++) {
+                samples += readU32(stts.payload + 8 + i * 8);
+            }
+            if (info.duration > 0.0f) info.fps = (float)((double)samples / info.duration);
+            info.frameCount = (int)samples;
+        }
+
+        // Keyframes: 1-based sync sample numbers. No stss at all means every sample is one.
+        info.keyframes.clear();
+        if (findBox(stbl.payload, stbl.size, "stss", stss) && stss.size >= 8) {
+            uint32_t entries = readU32(stss.payload + 4);
+            info.keyframes.reserve(std::min<size_t>(entries, (stss.size - 8) / 4));
+            for (uint32_t i = 0; i < entries && 8 + (size_t)(i + 1) * 4 <= stss.size; i++) {
+                uint32_t sample = readU32(stss.payload + 8 + i * 4);
+                if (sample > 0 && (info.keyframes.empty() || sample - 1 > info.keyframes.back())) info.keyframes.push_back(sample - 1);
+            }
+            if (info.keyframes.empty() || info.keyframes.front() != 0) info.keyframes.insert(info.keyframes.begin(), 0);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool MovieProbe::probe(const std::string & path, MovieInfo & info) {
+    FILE * file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    // Hop over the top-level boxes (mdat can be gigabytes) until moov turns up
+    bool found = false;
+    uint8_t header[16];
+    int64_t offset = 0;
+    while (fread(header, 1, 8, file) == 8) {
+        uint64_t boxSize = readU32(header);
+        size_t headerSize = 8;
+        if (boxSize == 1) {
+            if (fread(header + 8, 1, 8, file) != 8) break;
+            boxSize = readU64(header + 8);
+            headerSize = 16;
+        }
+        if (boxSize != 0 && boxSize < headerSize) break;
+
+        if (memcmp(header + 4, "moov", 4) == 0) {
+            if (boxSize == 0 || boxSize - headerSize > (64u << 20)) break; // Not a sane header
+            std::vector<uint8_t> moov((size_t)(boxSize - headerSize));
+            if (fread(moov.data(), 1, moov.size(), file) == moov.size()) {
+                found = parseMoov(moov.data(), moov.size(), info);
+            }
+            break;
+        }
+        if (boxSize == 0) break; // Last box runs to the end of the file
+        offset += (int64_t)boxSize;
+        if (probeSeek(file, offset, SEEK_SET) != 0) break;
+    }
+
+    fclose(file);
+    return found;
+}
+
+// --- KEYFRAMES ---
+
+bool MovieInfo::isKeyframe(int frame) const {
+    if (keyframes.empty()) return true;
+    return std::binary_search(keyframes.begin(), keyframes.end(), (uint32_t)std::max(frame, 0));
+}
+
+int MovieInfo::keyframeAtOrBefore(int frame) const {
+    if (keyframes.empty()) return std::max(frame, 0);
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), (uint32_t)std::max(frame, 0));
+    return it == keyframes.begin() ? 0 : (int)*(it - 1);
+}
+
+int MovieInfo::nearestKeyframe(int frame) const {
+    if (keyframes.empty()) return std::max(frame, 0);
+    auto it = std::lower_bound(keyframes.begin(), keyframes.end(), (uint32_t)std::max(frame, 0));
+    if (it == keyframes.end()) return (int)keyframes.back();
+    if (it == keyframes.begin()) return (int)*it;
+    int after = (int)*it;
+    int before = (int)*(it - 1);
+    return (frame - before <= after - frame) ? before : after;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Container facts read straight from the file header, no decoder involved
+struct MovieInfo {
+	float duration = 0.0f; // Seconds
+	int width = 0;
+	int height = 0;
+	float fps = 0.0f;
+	std::string codec; // Sample entry fourcc, e.g. avc1, hvc1, apcn
+	int frameCount = 0; // Video samples, 0 = unknown
+	// Sync samples (keyframes) as 0-based frame numbers in decode order, ascending.
+	// Empty with frameCount > 0 means the track has no stss: every frame is a keyframe.
+	std::vector<uint32_t> keyframes;
+
+	bool isKeyframe(int frame) const; // Unknown index counts every frame
+	int keyframeAtOrBefore(int frame) const; // Where a decoder has to start for frame
+	int nearestKeyframe(int frame) const;
+};
+
+// Minimal ISO base media (MP4 / QuickTime MOV) reader.
+// Walks the top-level boxes, loads only the moov box and reads the first video track's
+// mdhd, stsd, stts and stss (the keyframe table seeks are planned with). Cheap enough to
+// run on thousands of files during a library scan and safe on any thread.
+class MovieProbe {
+public:
+	static bool probe(const std::string & path, MovieInfo & info);
+
+	// Parse an in-memory moov payload (without its 8 byte header)
+	static bool parseMoov(const uint8_t * data, size_t size, MovieInfo & info);
+};
@@ -0,0 +1,146 @@
+#include "OfflineAnalysis.h"
+#include "AudioAnalyzer.h"
+#include "ModulationFile.h"
+#include "ReactiveState.h"
+#include "VirtualAudioInput.h"
+#include <chrono>
+#include <cstdio>
+
+static const char * BAND_COLUMNS[NUM_BANDS] = { "sub_bass", "low_mids", "mids", "high_mids", "treble" };
+
+static void printUsage() {
+    printf("usage: cognitoni --analyze <input.wav | raw.pcm | -> [options]\n"
+           "  --out <file>           .csv (default analysis.csv) or .bin\n"
+           "  --modulation <file>    modulation.json (default: the app's data folder)\n"
+           "  --buffer <frames>      buffer size fed per step (default 256)\n"
+           "  --gain <x>             analyzer input gain (default 1)\n"
+           "  --rate <hz>            raw PCM sample rate (default 48000)\n"
+           "  --channels <n>         raw PCM channels (default 2)\n");
+}
+
+int OfflineAnalysis::run(const vector<string> & args) {
+    string inputPath;
+    string outPath = "analysis.csv";
+    string modulationPath = ofToDataPath("modulation.json", true);
+    int bufferSize = 256;
+    int rawRate = 48000;
+    int rawChannels = 2;
+    float gain = 1.0f;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        const string & arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--out" && hasValue) outPath = args[++i];
+        else if (arg == "--modulation" && hasValue) modulationPath = args[++i];
+        else if (arg == "--buffer" && hasValue) bufferSize = std::max(16, ofToInt(args[++i]));
+        else if (arg == "--gain" && hasValue) gain = ofToFloat(args[++i]);
+        else if (arg == "--rate" && hasValue) rawRate = ofToInt(args[++i]);
+        else if (arg == "--channels" && hasValue) rawChannels = std::max(1, ofToInt(args[++i]));
+        else if (inputPath.empty() && (arg == "-" || arg.compare(0, 2, "--") != 0)) inputPath = arg;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (inputPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // --- INPUT ---
+    VirtualAudioInput input;
+    if (!input.open(inputPath, bufferSize, rawRate, rawChannels)) return 1;
+    input.setLooping(false);
+    const int rate = input.getSampleRate();
+    const int numChannels = input.getNumChannels();
+
+    // Same analyzer and envelopes as the live session, driven on this thread
+    AudioAnalyzer analyzer;
+    AnalyzerSettings analyzerSettings;
+    analyzerSettings.sampleRate = rate;
+    analyzer.setup(analyzerSettings);
+    analyzer.setGain(gain);
+
+    ReactiveState reactive;
+    ModulationFile::load(modulationPath, reactive.modulation); // Built-in mapping if missing
+
+    // --- OUTPUT ---
+    vector<string> columns = { "time" };
+    for (int b = 0; b < NUM_BANDS; b++) columns.push_back(BAND_COLUMNS[b]);
+    columns.insert(columns.end(), { "impact", "impact_trigger", "strobe_trigger", "strobe", "beat", "beat_confidence" });
+    for (int t = 0; t < NUM_MOD_TARGETS; t++) columns.push_back(ModulationMatrix::getTargetName((ModTarget)t));
+
+    bool binary = ofToLower(ofFilePath::getFileExt(outPath)) == "bin";
+    FILE * out = fopen(outPath.c_str(), binary ? "wb" : "w");
+    if (!out) {
+        ofLogError() << "OFFLINE: could not write " << outPath;
+        return 1;
+    }
+    if (binary) {
+        uint32_t header[2] = { 1, (uint32_t)columns.size() };
+        fwrite("CGNA", 1, 4, out);
+        fwrite(header, sizeof(uint32_t), 2, out);
+        for (auto & name : columns) fwrite(name.c_str(), 1, name.size() + 1, out);
+    } else {
+        for (size_t c = 0; c < columns.size(); c++) fprintf(out, c ? ",%s" : "%s", columns[c].c_str());
+        fputc('\n', out);
+    }
+
+    // --- RUN ---
+    // One step per buffer, with the file position as the clock: the analyzer stamps each
+    // block at its end like a device callback, and the envelopes advance by one buffer.
+    vector<float> samples((size_t)bufferSize * numChannels);
+    vector<float> row(columns.size());
+    const float dt = (float)bufferSize / rate;
+    uint64_t framesRead = 0;
+    uint64_t rows = 0;
+    auto started = std::chrono::steady_clock::now();
+
+    while (true) {
+        size_t got = input.read(samples.data(), bufferSize);
+        if (got == 0) break;
+        framesRead += got;
+        double time = (double)framesRead / rate;
+
+        analyzer.pushSamples(samples.data(), got, numChannels, rate, time);
+        analyzer.processPending();
+        analyzer.pollFrames();
+        BandFrame frame = analyzer.sampleAt(time - analyzer.getFrameInterval());
+
+        float onsetStrength[NUM_BANDS];
+        unsigned int onsets = analyzer.consumeOnsets(onsetStrength);
+        reactive.update(frame, time, onsets, onsetStrength, dt);
+
+        int c = 0;
+        row[c++] = (float)time;
+        for (int b = 0; b < NUM_BANDS; b++) row[c++] = frame.bands[b];
+        row[c++] = reactive.impactDelta;
+        row[c++] = reactive.impactTriggered ? 1.0f : 0.0f;
+        row[c++] = reactive.strobeTriggered ? 1.0f : 0.0f;
+        row[c++] = std::max(0.0f, reactive.strobeTimer);
+        row[c++] = (float)reactive.beatClock;
+        row[c++] = reactive.beatConfidence;
+        for (int t = 0; t < NUM_MOD_TARGETS; t++) row[c++] = reactive.modulation.get((ModTarget)t);
+
+        if (binary) {
+            fwrite(row.data(), sizeof(float), row.size(), out);
+        } else {
+            fprintf(out, "%.6f", time);
+            for (size_t i = 1; i < row.size(); i++) fprintf(out, ",%g", row[i]);
+            fputc('\n', out);
+        }
+        rows++;
+    }
+    fclose(out);
+
+    // --- REPORT ---
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double audioSeconds = (double)framesRead / rate;
+    ofLogNotice() << "OFFLINE: " << rows << " rows, " << ofToString(audioSeconds, 2) << "s of audio in "
+                  << ofToString(wall, 3) << "s (" << ofToString(audioSeconds / std::max(wall, 1e-9), 1)
+                  << "x real time) -> " << outPath;
+    if (analyzer.getDroppedSamples() > 0) {
+        ofLogWarning() << "OFFLINE: " << analyzer.getDroppedSamples() << " samples dropped, lower --buffer";
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "ofMain.h"
+
+// Headless analysis: decodes an audio file (anything VirtualAudioInput reads) and runs it
+// through the live analyzer and ReactiveState in device-sized buffers as fast as the CPU
+// allows, writing one row per buffer: time, the five bands, the impact envelope, impact and
+// strobe triggers, the beat clock and every modulation target. Started from main() with
+//   cognitoni --analyze input.wav [--out bands.csv|bands.bin] [--modulation modulation.json]
+//             [--buffer 256] [--gain 1] [--rate 48000 --channels 2]
+// A .bin output is a "CGNA" header (uint32 version, uint32 column count, NUL terminated
+// column names) followed by rows of float32 columns, all little endian.
+class OfflineAnalysis {
+public:
+	// Returns the process exit code
+	static int run(const vector<string> & args);
+};
@@ -0,0 +1,143 @@
+#include "OfflineRender.h"
+#include "ClipLayers.h"
+#include "VideoLibrary.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#ifdef TARGET_WIN32
+	#define popen _popen
+	#define pclose _pclose
+#endif
+
+// A printf pattern with exactly one integer conversion (%d, %06d, ...) and only %% otherwise,
+// so formatting it with the frame number can never read arguments that are not there
+static bool isFramePattern(const string & pattern) {
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%') continue;
+        if (++i < pattern.size() && pattern[i] == '%') continue;
+        while (i < pattern.size() && strchr("-+ #0", pattern[i])) i++;
+        while (i < pattern.size() && isdigit((unsigned char)pattern[i])) i++;
+        if (i >= pattern.size() || (pattern[i] != 'd' && pattern[i] != 'i')) return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+bool OfflineRenderSettings::parse(const vector<string> & args) {
+    for (size_t i = 0; i < args.size(); i++) {
+        const string & arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--clips" && hasValue) {
+            string value = args[++i];
+            clips.clear();
+            ofDirectory dir(value);
+            if (dir.isDirectory()) {
+                // Listing order is up to the file system, sort it so the seed picks the same clips
+                dir.listDir();
+                for (size_t f = 0; f < dir.size(); f++) {
+                    if (VideoLibrary::isVideoFile(dir.getPath(f))) clips.push_back(ofFilePath::getAbsolutePath(dir.getPath(f), false));
+                }
+                std::sort(clips.begin(), clips.end());
+            } else {
+                for (auto & path : ofSplitString(value, ",", true, true)) clips.push_back(ofFilePath::getAbsolutePath(path, false));
+            }
+        }
+        else if (arg == "--seed" && hasValue) {
+            const string & value = args[++i];
+            char * end = nullptr;
+            errno = 0;
+            seed = strtoull(value.c_str(), &end, 10);
+            if (value.empty() || !isdigit((unsigned char)value[0]) || *end != '\0' || errno == ERANGE) {
+                ofLogError() << "RENDER: --seed takes a whole number, got " << value;
+                return false;
+            }
+        }
+        else if (arg == "--fps" && hasValue) fps = std::max(1, ofToInt(args[++i]));
+        else if (arg == "--duration" && hasValue) duration = std::max(0.0, ofToDouble(args[++i]));
+        else if (arg == "--out" && hasValue) {
+            outPattern = ofFilePath::getAbsolutePath(args[++i], false);
+            if (!isFramePattern(outPattern)) {
+                ofLogError() << "RENDER: --out needs exactly one frame number like %06d (and %% for a percent sign), got " << outPattern;
+                return false;
+            }
+        }
+        else if (arg == "--pipe" && hasValue) pipeCommand = args[++i];
+        else if (arg == "--layers" && hasValue) layers = ofClamp(ofToInt(args[++i]), 1, ClipLayers::MAX_LAYERS);
+        else if (arg == "--verify-cpu") verifyCpu = true;
+        else if (arg == "--tolerance" && hasValue) tolerance = std::max(0, ofToInt(args[++i]));
+        else if (arg == "--size" && hasValue) {
+            vector<string> size = ofSplitString(args[++i], "x");
+            if (size.size() == 2) {
+                width = std::max(16, ofToInt(size[0]));
+                height = std::max(16, ofToInt(size[1]));
+            }
+        }
+        else if (audioPath.empty() && arg.compare(0, 2, "--") != 0) audioPath = ofFilePath::getAbsolutePath(arg, false);
+        else {
+            ofLogError() << "RENDER: unknown argument " << arg;
+            return false;
+        }
+    }
+
+    if (audioPath.empty() || clips.empty()) {
+        ofLogError() << "RENDER: usage: --render <audio.wav> --clips <folder | a.mp4,b.mp4> [--seed n] [--fps n] "
+                        "[--size WxH] [--duration s] [--out frame-%06d.png | --pipe \"encoder command\"] [--layers n] [--verify-cpu] [--tolerance n]";
+        return false;
+    }
+    return true;
+}
+
+FrameWriter::~FrameWriter() {
+    close();
+}
+
+bool FrameWriter::open(const OfflineRenderSettings & settings) {
+    close();
+    framesWritten = 0;
+    pattern = settings.outPattern;
+
+    if (!settings.pipeCommand.empty()) {
+#ifdef TARGET_WIN32
+        pipe = popen(settings.pipeCommand.c_str(), "wb"); // Text mode would turn every 0x0A byte into CR LF
+#else
+        pipe = popen(settings.pipeCommand.c_str(), "w");
+#endif
+        if (!pipe) {
+            ofLogError() << "RENDER: could not start " << settings.pipeCommand;
+            return false;
+        }
+        ofLogNotice() << "RENDER: piping " << settings.width << "x" << settings.height << " rgb24 to " << settings.pipeCommand;
+        return true;
+    }
+
+    string dir = ofFilePath::getEnclosingDirectory(pattern, false);
+    if (!dir.empty()) ofDirectory::createDirectory(dir, false, true);
+    ofLogNotice() << "RENDER: writing " << pattern;
+    return true;
+}
+
+bool FrameWriter::write(const ofPixels & pixels) {
+    if (pipe) {
+        size_t bytes = pixels.size();
+        if (fwrite(pixels.getData(), 1, bytes, pipe) != bytes) {
+            ofLogError() << "RENDER: encoder pipe closed";
+            return false;
+        }
+    } else {
+        char path[4096];
+        snprintf(path, sizeof(path), pattern.c_str(), framesWritten);
+        if (!ofSaveImage(pixels, path)) {
+            ofLogError() << "RENDER: could not write " << path;
+            return false;
+        }
+    }
+    framesWritten++;
+    return true;
+}
+
+void FrameWriter::close() {
+    if (pipe) pclose(pipe);
+    pipe = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "ofMain.h"
+#include <cstdio>
+
+// Settings for a deterministic offline render, parsed from
+//   cognitoni --render <audio.wav> --clips <folder | a.mp4,b.mp4> [--seed 1] [--fps 60]
+//             [--size 1920x1080] [--duration seconds] [--out render/frame-%06d.png]
+//             [--pipe "ffmpeg -f rawvideo -pix_fmt rgb24 -s 1920x1080 -r 60 -i - out.mkv"]
+//             [--layers 1] [--verify-cpu] [--tolerance 4]
+// The simulation steps at exactly 1/fps, audio is read from the file per frame, clips are
+// decoded by timestamp and every random choice comes from the seed, so identical inputs give
+// bit-identical frames (on the same GPU and driver).
+struct OfflineRenderSettings {
+	string audioPath;
+	vector<string> clips; // Absolute paths, sorted when taken from a folder
+	uint64_t seed = 1;
+	int fps = 60;
+	int width = 1920;
+	int height = 1080;
+	double duration = 0.0; // Seconds, 0 = until the audio ends
+	string outPattern = "render/frame-%06d.png"; // printf pattern for the frame number
+	string pipeCommand; // When set, raw RGB frames go to this command's stdin instead
+	int layers = 1; // Clips on screen at once (ClipLayers), within the same memory budget as live
+	bool verifyCpu = false; // Render every scene with SoftwareMosh too and diff it against the GPU
+	int tolerance = 4; // 8 bit levels a channel may differ before the pixel counts as off
+
+	bool parse(const vector<string> & args); // Logs and returns false on bad arguments
+};
+
+// Writes rendered frames as numbered images or to an encoder pipe
+class FrameWriter {
+public:
+	~FrameWriter();
+
+	bool open(const OfflineRenderSettings & settings);
+	bool write(const ofPixels & pixels); // RGB, frames are numbered in call order
+	void close();
+	int getFramesWritten() const { return framesWritten; }
+
+private:
+	string pattern;
+	FILE * pipe = nullptr;
+	int framesWritten = 0;
+};
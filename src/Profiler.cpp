@@ -0,0 +1,224 @@
+#include "Profiler.h"
+#include <chrono>
+#include <fstream>
+
+Profiler::Profiler() {
+    stages[STAGE_FRAME].name = "frame";
+    stages[STAGE_AUDIO_CALLBACK].name = "audio cb";
+    stages[STAGE_AUDIO_JITTER].name = "audio jitter";
+    numStages = NUM_BUILTIN_STAGES;
+    audioCalls.allocate(256);
+    sorted.reserve(HISTORY);
+    text.reserve(64);
+}
+
+uint64_t Profiler::nowMicros() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+int Profiler::addStage(const string & name) {
+    if (numStages >= MAX_STAGES) {
+        ofLogWarning() << "PROFILER: too many stages, ignoring " << name;
+        return STAGE_FRAME;
+    }
+    stages[numStages].name = name;
+    return numStages++;
+}
+
+void Profiler::setEnabled(bool enable) {
+    if (enable == isEnabled()) return;
+    if (enable && events.empty()) events.resize(MAX_EVENTS);
+
+    // Start from a clean slate so the history never mixes two sessions
+    for (int i = 0; i < numStages; i++) {
+        std::fill(stages[i].history, stages[i].history + HISTORY, 0.0f);
+        stages[i].accum = 0.0f;
+        stages[i].start = 0;
+    }
+    frameCount = 0;
+    frameStart = 0;
+    numEvents = 0;
+    lastAudioStart = 0;
+    AudioCall call;
+    while (audioCalls.pop(call)) {}
+
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Profiler::record(uint64_t start, float value, int stage, int thread) {
+    Event & event = events[numEvents % MAX_EVENTS];
+    event.start = start;
+    event.value = value;
+    event.stage = (int16_t)stage;
+    event.thread = (int8_t)thread;
+    numEvents++;
+}
+
+void Profiler::beginFrame() {
+    if (!isEnabled()) return;
+    uint64_t now = nowMicros();
+
+    // Audio callbacks since the last frame: longest duration and worst period deviation
+    AudioCall call;
+    while (audioCalls.pop(call)) {
+        float duration = (call.end - call.start) / 1000.0f;
+        Stage & callback = stages[STAGE_AUDIO_CALLBACK];
+        callback.accum = std::max(callback.accum, duration);
+        record(call.start, (float)(call.end - call.start), STAGE_AUDIO_CALLBACK, 1);
+
+        if (lastAudioStart > 0 && audioPeriodMicros > 0.0) {
+            float jitter = (float)fabs((double)(call.start - lastAudioStart) - audioPeriodMicros) / 1000.0f;
+            Stage & jitterStage = stages[STAGE_AUDIO_JITTER];
+            jitterStage.accum = std::max(jitterStage.accum, jitter);
+        }
+        lastAudioStart = call.start;
+    }
+
+    if (frameStart > 0) stages[STAGE_FRAME].accum = (now - frameStart) / 1000.0f;
+    frameStart = now;
+
+    int slot = frameCount % HISTORY;
+    for (int i = 0; i < numStages; i++) {
+        stages[i].history[slot] = stages[i].accum;
+        stages[i].accum = 0.0f;
+    }
+    frameCount++;
+}
+
+void Profiler::begin(int stage) {
+    stages[stage].start = nowMicros();
+}
+
+void Profiler::end(int stage) {
+    Stage & s = stages[stage];
+    if (s.start == 0) return; // Enabled mid-scope
+    uint64_t elapsed = nowMicros() - s.start;
+    s.accum += elapsed / 1000.0f;
+    record(s.start, (float)elapsed, stage, 0);
+    s.start = 0;
+}
+
+void Profiler::addSample(int stage, float ms) {
+    if (!isEnabled()) return;
+    stages[stage].accum += ms;
+    record(nowMicros(), ms, stage, -1);
+}
+
+float Profiler::getLast(int stage) const {
+    if (frameCount == 0) return 0.0f;
+    return stages[stage].history[(frameCount - 1) % HISTORY];
+}
+
+float Profiler::getPercentile(int stage, float p) const {
+    int count = std::min(frameCount, HISTORY);
+    if (count == 0) return 0.0f;
+    sorted.assign(stages[stage].history, stages[stage].history + count);
+    int index = (int)ofClamp(p * (count - 1) + 0.5f, 0, count - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void Profiler::audioCallbackBegin() {
+    if (!isEnabled()) return;
+    audioStart = nowMicros();
+}
+
+void Profiler::audioCallbackEnd() {
+    if (!isEnabled() || audioStart == 0) return;
+    AudioCall call;
+    call.start = audioStart;
+    call.end = nowMicros();
+    audioCalls.push(call); // Dropped when the render thread stalls, the HUD shows that anyway
+    audioStart = 0;
+}
+
+void Profiler::draw(float x, float y) const {
+    if (!isEnabled()) return;
+    const float rowH = 14;
+    const float graphX = x + 250;
+    const float graphW = 120;
+
+    ofPushStyle();
+    ofSetColor(0, 0, 0, 180);
+    ofDrawRectRounded(x - 10, y - 24, graphX - x + graphW + 20, numStages * rowH + 34, 8);
+    ofSetColor(255);
+    text.assign("stage         ms  p50   p99");
+    ofDrawBitmapString(text, x, y - 6, 0.0f);
+
+    int count = std::min(frameCount, HISTORY);
+    for (int i = 0; i < numStages; i++) {
+        float rowY = y + 10 + i * rowH;
+        float p50 = getPercentile(i, 0.5f);
+        float p99 = getPercentile(i, 0.99f);
+
+        char line[64];
+        snprintf(line, sizeof(line), "%-12.12s %5.2f %5.2f %5.2f", stages[i].name.c_str(), getLast(i), p50, p99);
+        text.assign(line);
+        ofSetColor(200);
+        ofDrawBitmapString(text, x, rowY, 0.0f);
+
+        // Rolling graph, oldest on the left, scaled to the stage's own p99
+        float scale = (rowH - 3) / std::max(p99 * 1.2f, 0.01f);
+        graph.clear();
+        graph.setMode(OF_PRIMITIVE_LINE_STRIP);
+        for (int f = 0; f < count; f++) {
+            float value = stages[i].history[(frameCount - count + f) % HISTORY];
+            graph.addVertex(glm::vec3(graphX + graphW * f / (HISTORY - 1), rowY - std::min(value * scale, rowH - 3), 0));
+        }
+        ofSetColor(i == STAGE_FRAME ? ofColor(255, 200, 80) : ofColor(80, 200, 255));
+        graph.draw();
+    }
+    ofPopStyle();
+}
+
+bool Profiler::exportCsv(const string & path) const {
+    std::ofstream out(ofToDataPath(path, true));
+    if (!out) {
+        ofLogError() << "PROFILER: could not write " << path;
+        return false;
+    }
+
+    out << "frame";
+    for (int i = 0; i < numStages; i++) out << "," << stages[i].name;
+    out << "\n";
+
+    int count = std::min(frameCount, HISTORY);
+    for (int f = 0; f < count; f++) {
+        int frame = frameCount - count + f;
+        out << frame;
+        for (int i = 0; i < numStages; i++) out << "," << stages[i].history[frame % HISTORY];
+        out << "\n";
+    }
+    ofLogNotice() << "PROFILER: " << count << " frames written to " << path;
+    return true;
+}
+
+bool Profiler::exportTrace(const string & path) const {
+    std::ofstream out(ofToDataPath(path, true));
+    if (!out) {
+        ofLogError() << "PROFILER: could not write " << path;
+        return false;
+    }
+
+    // Chrome trace event format: complete events for scopes, counters for samples
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"render\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"audio\"}}";
+
+    size_t count = std::min(numEvents, (size_t)MAX_EVENTS);
+    for (size_t e = numEvents - count; e < numEvents; e++) {
+        const Event & event = events[e % MAX_EVENTS];
+        const string & name = stages[event.stage].name;
+        if (event.thread < 0) {
+            out << ",\n{\"name\":\"" << name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << event.start
+                << ",\"args\":{\"ms\":" << event.value << "}}";
+        } else {
+            out << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (int)event.thread
+                << ",\"ts\":" << event.start << ",\"dur\":" << event.value << "}";
+        }
+    }
+    out << "\n]}\n";
+    ofLogNotice() << "PROFILER: " << count << " events written to " << path;
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "ofMain.h"
+#include "SpscRing.h"
+#include <atomic>
+
+// Frame profiler: CPU time per named stage (ProfileScope), values measured elsewhere such as
+// GPU queries (addSample), and the audio callback's duration and arrival jitter. Keeps the
+// last HISTORY frames per stage for the HUD graphs and percentiles, plus a ring of timed
+// events that exports as a Chrome trace (chrome://tracing, Perfetto).
+// Disabled, a scope costs one relaxed load and a branch and nothing is recorded.
+class Profiler {
+public:
+	static const int HISTORY = 240; // Frames, ~4s at 60fps
+	static const int MAX_STAGES = 32;
+	static const int MAX_EVENTS = 1 << 15;
+
+	// Stages every profiler has, addStage() numbers from NUM_BUILTIN_STAGES on
+	enum BuiltinStage {
+		STAGE_FRAME = 0, // Time between beginFrame() calls
+		STAGE_AUDIO_CALLBACK, // Longest audio callback in the frame
+		STAGE_AUDIO_JITTER, // Largest deviation from the expected callback period
+		NUM_BUILTIN_STAGES
+	};
+
+	Profiler();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+	int addStage(const string & name); // Setup only
+	void setAudioPeriod(double seconds) { audioPeriodMicros = seconds * 1.0e6; } // bufferSize / sampleRate
+
+	// Render thread
+	void beginFrame(); // Commits the last frame to the history and drains the audio timings
+	void begin(int stage);
+	void end(int stage);
+	void addSample(int stage, float ms);
+
+	int getNumStages() const { return numStages; }
+	const string & getStageName(int stage) const { return stages[stage].name; }
+	float getLast(int stage) const;
+	float getPercentile(int stage, float p) const; // p in 0..1 over the history
+
+	// Name, last / p50 / p99 and a rolling graph per stage
+	void draw(float x, float y) const;
+	bool exportCsv(const string & path) const;
+	bool exportTrace(const string & path) const;
+
+	// Audio thread, wait-free
+	void audioCallbackBegin();
+	void audioCallbackEnd();
+
+	static uint64_t nowMicros();
+
+private:
+	struct Stage {
+		string name;
+		float history[HISTORY] = {};
+		float accum = 0.0f; // This frame so far
+		uint64_t start = 0; // Open scope
+	};
+
+	struct Event {
+		uint64_t start = 0;
+		float value = 0.0f; // Microseconds for scopes, ms for samples
+		int16_t stage = 0;
+		int8_t thread = 0; // 0 render, 1 audio, -1 sample (trace counter)
+	};
+
+	struct AudioCall {
+		uint64_t start = 0;
+		uint64_t end = 0;
+	};
+
+	void record(uint64_t start, float value, int stage, int thread);
+
+	std::atomic<bool> enabled { false };
+	Stage stages[MAX_STAGES];
+	int numStages = 0;
+	int frameCount = 0; // Frames committed to the history
+	uint64_t frameStart = 0;
+
+	vector<Event> events; // Ring, allocated when first enabled
+	size_t numEvents = 0;
+
+	SpscRing<AudioCall> audioCalls;
+	uint64_t audioStart = 0; // Audio thread only
+	uint64_t lastAudioStart = 0; // Render thread only
+	double audioPeriodMicros = 0.0;
+
+	mutable vector<float> sorted; // Scratch for percentiles
+	mutable ofMesh graph;
+	mutable string text; // HUD line, reused so drawing the rows allocates nothing
+};
+
+// Times the enclosing block as one stage
+class ProfileScope {
+public:
+	ProfileScope(Profiler & profiler, int stage) : profiler(profiler.isEnabled() ? &profiler : nullptr), stage(stage) {
+		if (this->profiler) this->profiler->begin(stage);
+	}
+	~ProfileScope() { stop(); }
+
+	// End early, for stages that do not map onto a block
+	void stop() {
+		if (profiler) profiler->end(stage);
+		profiler = nullptr;
+	}
+
+private:
+	Profiler * profiler;
+	int stage;
+};
@@ -0,0 +1,82 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <cstdio>
+
+// Cheapest savings first: slices cost texture fetches on every pixel, scanlines a full pass,
+// the trail two float blits; resolution and lighter clips cut everything at once
+const QualityGovernor::Level QualityGovernor::LEVELS[NUM_LEVELS] = {
+    { "full", 1.0f, 64, true, true, 0, 4 },
+    { "slices capped", 1.0f, 16, true, true, 0, 4 },
+    { "80% no scanlines", 0.8f, 16, true, false, 1080, 3 },
+    { "66% no slices", 0.66f, 0, true, false, 1080, 2 },
+    { "50% no trail", 0.5f, 0, false, false, 720, 1 },
+};
+
+void QualityGovernor::reset() {
+    int window = std::max(settings.window, 8);
+    frames.assign(window, 0.0f);
+    works.assign(window, 0.0f);
+    scratch.reserve(window);
+    count = 0;
+    writeIndex = 0;
+    level = 0;
+    headroomTime = 0.0f;
+    sinceUp = 1.0e9f;
+    upHold = settings.upHold;
+    framePercentile = workPercentile = 0.0f;
+    reason.clear();
+}
+
+float QualityGovernor::percentileOf(const std::vector<float> & values) {
+    scratch.assign(values.begin(), values.end());
+    size_t rank = std::min(scratch.size() - 1, (size_t)(settings.percentile * scratch.size()));
+    std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+    return scratch[rank];
+}
+
+bool QualityGovernor::update(float frameMs, float cpuMs, float gpuMs) {
+    if (frames.empty()) reset();
+    int window = (int)frames.size();
+    frames[writeIndex] = frameMs;
+    works[writeIndex] = std::max(cpuMs, gpuMs); // CPU and GPU overlap, the slower one sets the pace
+    writeIndex = (writeIndex + 1) % window;
+    count = std::min(count + 1, window);
+    lastCpuMs = cpuMs;
+    lastGpuMs = gpuMs;
+
+    float dt = frameMs / 1000.0f;
+    sinceUp += dt;
+    if (count < window) return false; // Judge a level on a full window of its own frames
+
+    float budget = 1000.0f / std::max(settings.targetFps, 1.0f);
+    framePercentile = percentileOf(frames);
+    workPercentile = percentileOf(works);
+
+    // --- STEP DOWN ---
+    if (framePercentile > budget * settings.overBudget && level < NUM_LEVELS - 1) {
+        if (sinceUp < upHold * 2.0f) upHold = std::min(upHold * 2.0f, settings.maxUpHold); // The last step up did not hold
+        return change(level + 1, "frame", framePercentile, ">", budget * settings.overBudget);
+    }
+
+    // --- STEP UP ---
+    bool spare = workPercentile < budget * settings.headroom && framePercentile <= budget * settings.overBudget;
+    headroomTime = spare ? headroomTime + dt : 0.0f;
+    if (level > 0 && headroomTime >= upHold) {
+        sinceUp = 0.0f;
+        return change(level - 1, "work", workPercentile, "<", budget * settings.headroom);
+    }
+    return false;
+}
+
+bool QualityGovernor::change(int next, const char * measure, float value, const char * comparison, float limit) {
+    char text[160];
+    snprintf(text, sizeof(text), "%s p%.0f %.1fms %s %.1fms (cpu %.1fms gpu %.1fms)", measure, settings.percentile * 100.0f, value,
+             comparison, limit, lastCpuMs, lastGpuMs);
+    reason = text;
+
+    level = next;
+    if (level == 0) upHold = settings.upHold; // Back at full quality, forget the backoff
+    count = 0;
+    headroomTime = 0.0f;
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Holds the frame rate under load by stepping through a ladder of cheaper render settings.
+// Watches a rolling window of frame intervals and of the frame's work (CPU time in
+// update + draw, GPU time of the passes): a high percentile over budget steps one level
+// down, headroom that lasts steps one level back up. The window restarts after every
+// change, so each step is judged on frames rendered with it. A step up that is undone
+// soon after doubles the time the next one waits. No openFrameworks dependency.
+class QualityGovernor {
+public:
+	// One rung of the ladder, LEVELS[0] is full quality
+	struct Level {
+		const char * name;
+		float renderScale; // Of the configured internal height
+		int maxSlices; // Slice effect cap, 0 = off
+		bool feedback;
+		bool scanlines;
+		int maxClipHeight; // Prefer clips up to this height, 0 = any
+		int maxLayers; // Simultaneous clip layers (ClipLayers), the base clip counts
+	};
+	static const int NUM_LEVELS = 5;
+	static const Level LEVELS[NUM_LEVELS];
+
+	struct Settings {
+		float targetFps = 60.0f;
+		int window = 90; // Frames per decision
+		float percentile = 0.9f;
+		float overBudget = 1.15f; // Frame interval above budget * this: step down
+		float headroom = 0.6f; // Work below budget * this: step up (vsync hides it in the interval)
+		float upHold = 4.0f; // Seconds of headroom before stepping up
+		float maxUpHold = 60.0f; // Backoff limit
+	};
+
+	void reset();
+	// Once per frame, all in ms. Returns true when the level changed, getReason() says why.
+	bool update(float frameMs, float cpuMs, float gpuMs);
+
+	int getLevelIndex() const { return level; }
+	const Level & getLevel() const { return LEVELS[level]; }
+	const std::string & getReason() const { return reason; }
+	float getFramePercentile() const { return framePercentile; } // Of the last full window
+	float getWorkPercentile() const { return workPercentile; }
+
+	Settings settings;
+
+private:
+	bool change(int next, const char * measure, float value, const char * comparison, float limit);
+	float percentileOf(const std::vector<float> & values);
+
+	std::vector<float> frames;
+	std::vector<float> works;
+	std::vector<float> scratch;
+	int count = 0; // Samples in the window since the last change
+	int writeIndex = 0;
+
+	int level = 0;
+	float headroomTime = 0.0f;
+	float sinceUp = 1.0e9f; // Seconds since the last step up
+	float upHold = 0.0f; // Current wait, settings.upHold with backoff
+	float framePercentile = 0.0f;
+	float workPercentile = 0.0f;
+	float lastCpuMs = 0.0f;
+	float lastGpuMs = 0.0f;
+	std::string reason;
+};
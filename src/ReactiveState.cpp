@@ -0,0 +1,51 @@
+#include "ReactiveState.h"
+#include <algorithm>
+#include <cmath>
+
+void ReactiveState::update(const BandFrame & frame, double presentTime, unsigned int onsets, const float * onsetStrength, float dt) {
+    // --- BEAT ---
+    // The beat grid is latency compensated, so evaluate it at the moment this step is shown
+    beatClock = frame.getBeats(presentTime);
+    beatConfidence = frame.beatConfidence;
+    beatPhase = (float)(beatClock - std::floor(beatClock));
+
+    // --- IMPACT & STROBE LOGIC ---
+    // Everything below integrates the real step time, so it looks the same at any frame rate
+    if (strobeTimer > 0) strobeTimer -= dt * 6.0f; // Fades out over ~0.17s
+
+    // Kick/bass onsets from the analyzer (spectral flux over an adaptive threshold).
+    // impactDelta jumps on the onset and releases in time, not per rendered frame.
+    impactTriggered = false;
+    strobeTriggered = false;
+    impactDelta *= std::exp(-dt / 0.12f);
+    if (onsets & ((1 << BAND_SUB_BASS) | (1 << BAND_LOW_MIDS))) {
+        float kick = std::max(onsetStrength[BAND_SUB_BASS], onsetStrength[BAND_LOW_MIDS]);
+        float hit = 0.1f + 0.6f * std::min(std::max(kick / 2.0f, 0.0f), 1.0f); // 0..2 -> 0.1..0.7
+        impactDelta = std::max(impactDelta, hit);
+        impactTriggered = true;
+
+        // Trigger flash on significant hits
+        if (kick > 1.0f) {
+            strobeTimer = 1.0f;
+            strobeTriggered = true;
+        }
+    }
+
+    // --- MODULATION ---
+    // Feed the analysis features, the matrix maps them to zoom, RGB shift, blur etc. with
+    // attack/release envelopes from modulation.json
+    modulation.setSource(MOD_SRC_SUB_BASS, frame.bands[BAND_SUB_BASS]);
+    modulation.setSource(MOD_SRC_LOW_MIDS, frame.bands[BAND_LOW_MIDS]);
+    modulation.setSource(MOD_SRC_MIDS, frame.bands[BAND_MIDS]);
+    modulation.setSource(MOD_SRC_HIGH_MIDS, frame.bands[BAND_HIGH_MIDS]);
+    modulation.setSource(MOD_SRC_TREBLE, frame.bands[BAND_TREBLE]);
+    modulation.setSource(MOD_SRC_IMPACT, impactDelta);
+    modulation.setSource(MOD_SRC_STEREO_WIDTH, frame.stereoWidth);
+    modulation.setSource(MOD_SRC_BEAT_PHASE, beatPhase);
+    modulation.setSource(MOD_SRC_BEAT_PULSE, beatConfidence * std::pow(1.0f - beatPhase, 6.0f));
+    modulation.setSource(MOD_SRC_BEAT_CONFIDENCE, beatConfidence);
+    for (int b = 0; b < NUM_BANDS; b++) {
+        modulation.setSource((ModSource)(MOD_SRC_FLUX_SUB_BASS + b), frame.flux[b]);
+    }
+    modulation.update(dt);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "BandFrame.h"
+#include "ModulationMatrix.h"
+
+// Envelopes derived from the analysis once per step: kick impact and strobe from the onsets,
+// the beat clock, and the modulation matrix fed with every feature. The live app steps it per
+// rendered frame and the offline analysis per audio buffer, so both run the same code.
+// No openFrameworks dependency.
+class ReactiveState {
+public:
+	// frame: bands sampled for this step. presentTime: when the step is seen (analyzer clock),
+	// the beat grid is evaluated there. onsets / onsetStrength: everything since the last step.
+	void update(const BandFrame & frame, double presentTime, unsigned int onsets, const float * onsetStrength, float dt);
+
+	ModulationMatrix modulation;
+
+	double beatClock = 0.0; // Beats elapsed at present time, fraction = phase
+	float beatPhase = 0.0f;
+	float beatConfidence = 0.0f; // Tempo tracker confidence 0..1
+	float impactDelta = 0.0f; // Onset-driven hit envelope
+	float strobeTimer = 0.0f; // 1 on a hard hit, fades out over ~0.17s
+
+	// What fired in the last update()
+	bool impactTriggered = false;
+	bool strobeTriggered = false;
+};
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// CPU mirror of the std140 "ReactiveParams" block in shader.frag, uploaded once per frame.
+// std140 packs scalars at 4 byte alignment and vec2 at 8, so the order here must match
+// the shader exactly. Add new members at the end and keep vec2s on an 8 byte boundary.
+struct ReactiveUniforms {
+	static const int MAX_SLICES = 64;
+	static const int MAX_OVERLAYS = 3; // Clip layers over the base clip (ClipLayers)
+
+	// How an overlay layer combines with what is under it, shader.frag's BLEND_* constants
+	enum BlendMode {
+		BLEND_LUMA = 0, // Keyed by the layer's brightness
+		BLEND_DIFFERENCE,
+		BLEND_ADD,
+		NUM_BLEND_MODES
+	};
+
+	float time = 0.0f;
+	float beatClock = 0.0f;
+	float beatConfidence = 0.0f;
+	float subBass = 0.0f;
+	float lowMids = 0.0f;
+	float mids = 0.0f;
+	float highMids = 0.0f;
+	float treble = 0.0f;
+	float pixelSize = 1.0f;
+	float rgbShift = 0.0f;
+	float impactDelta = 0.0f;
+	float lowThresh = 0.10f;
+	float highThresh = 0.80f;
+	int32_t invertToggle = 0;
+	float res[2] = { 1.0f, 1.0f };
+	float res1[2] = { 1.0f, 1.0f }; // Incoming clip during a crossfade
+	float crossfade = 0.0f;
+	int32_t yuv0 = 0; // tex0 holds Y with UV in tex0uv
+	int32_t yuv1 = 0;
+	int32_t numSlices = 0; // 0 = no slicing
+	float pad0[2] = {}; // vec4 array starts on a 16 byte boundary
+	float sliceOffsets[MAX_SLICES] = {}; // Texels, std140 vec4[16]
+	int32_t spectrumBins = 0; // Columns of the spectrogram texture, 0 = none bound
+	int32_t spectrogramRows = 1;
+	int32_t spectrogramHead = 0; // Newest row of the ring (SpectrogramTexture::getHead)
+	float pad1 = 0.0f; // Layer vectors start on a 16 byte boundary
+	float layerOpacity[4] = {}; // Overlays in x..z, 0 = not drawn
+	float layerMosh[4] = {}; // Share of the mosh displacement and RGB split each overlay takes
+	int32_t layerBlend[4] = {}; // BlendMode
+	int32_t layerYuv[4] = {};
+	float layerRes[MAX_OVERLAYS][4] = {}; // xy = texture size, std140 vec4 each
+
+	// Binding point shared by the buffer and the shader block
+	static const unsigned int BINDING = 0;
+};
+
+static_assert(offsetof(ReactiveUniforms, res) == 56, "res must sit on an 8 byte std140 boundary");
+static_assert(offsetof(ReactiveUniforms, res1) == 64, "res1 must sit on an 8 byte std140 boundary");
+static_assert(offsetof(ReactiveUniforms, sliceOffsets) == 96, "sliceOffsets must sit on a 16 byte std140 boundary");
+static_assert(offsetof(ReactiveUniforms, spectrumBins) == 352, "spectrumBins must follow the slice array");
+static_assert(offsetof(ReactiveUniforms, layerOpacity) == 368, "layerOpacity must sit on a 16 byte std140 boundary");
+static_assert(offsetof(ReactiveUniforms, layerRes) == 432, "layerRes must follow the layer vectors");
+static_assert(sizeof(ReactiveUniforms) == 480, "ReactiveUniforms no longer matches the std140 block");
@@ -0,0 +1,90 @@
+#include "RealFft.h"
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+RealFft::RealFft(int fftSize) {
+    size = fftSize;
+    half = size / 2;
+
+    // Same Hamming window as ofxFft's OF_FFT_WINDOW_HAMMING
+    window.resize(size);
+    double windowSum = 0.0;
+    for (int i = 0; i < size; i++) {
+        window[i] = (float)(0.54 - 0.46 * std::cos(2.0 * PI * i / (size - 1)));
+        windowSum += window[i];
+    }
+    normalizer = (float)(2.0 / windowSum);
+
+    int bits = 0;
+    while ((1 << bits) < half) bits++;
+    bitReverse.resize(half);
+    for (int i = 0; i < half; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+        bitReverse[i] = r;
+    }
+
+    twiddleRe.resize(half / 2);
+    twiddleIm.resize(half / 2);
+    for (int j = 0; j < half / 2; j++) {
+        twiddleRe[j] = (float)std::cos(-2.0 * PI * j / half);
+        twiddleIm[j] = (float)std::sin(-2.0 * PI * j / half);
+    }
+    splitRe.resize(half);
+    splitIm.resize(half);
+    for (int k = 0; k < half; k++) {
+        splitRe[k] = (float)std::cos(-2.0 * PI * k / size);
+        splitIm[k] = (float)std::sin(-2.0 * PI * k / size);
+    }
+
+    re.resize(half);
+    im.resize(half);
+    amplitude.resize(half + 1);
+}
+
+const float * RealFft::transform(const float * samples) {
+    // Even samples as the real part, odd as the imaginary part, in bit reversed order
+    for (int n = 0; n < half; n++) {
+        int j = bitReverse[n];
+        re[j] = samples[2 * n] * window[2 * n];
+        im[j] = samples[2 * n + 1] * window[2 * n + 1];
+    }
+
+    // --- HALF SIZE COMPLEX FFT ---
+    for (int len = 2; len <= half; len <<= 1) {
+        int span = len / 2;
+        int step = half / len;
+        for (int i = 0; i < half; i += len) {
+            for (int k = 0; k < span; k++) {
+                float wr = twiddleRe[k * step];
+                float wi = twiddleIm[k * step];
+                int a = i + k;
+                int b = a + span;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    // --- SPLIT ---
+    // X[k] = E[k] + W^k O[k], with E and O recovered from Z[k] and conj(Z[half - k])
+    for (int k = 0; k <= half; k++) {
+        int a = (k == half) ? 0 : k;
+        int b = (k == 0) ? 0 : half - k;
+        float zr = re[a], zi = im[a];
+        float cr = re[b], ci = -im[b];
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        float orr = 0.5f * (zi - ci), oi = -0.5f * (zr - cr); // -i (Z - conj) / 2
+        float wr = (k == half) ? -1.0f : splitRe[k];
+        float wi = (k == half) ? 0.0f : splitIm[k];
+        float xr = er + orr * wr - oi * wi;
+        float xi = ei + orr * wi + oi * wr;
+        amplitude[k] = std::sqrt(xr * xr + xi * xi) * normalizer;
+    }
+    return amplitude.data();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+
+// Magnitude spectrum of one analysis window. BandAnalysis runs one per window size; the app
+// backs it with ofxFft, the standalone core library with RealFft.
+class SpectrumTransform {
+public:
+	virtual ~SpectrumTransform() {}
+	// getSize() samples in, getSize() / 2 + 1 amplitudes out, valid until the next call
+	virtual const float * transform(const float * samples) = 0;
+	virtual int getSize() const = 0;
+};
+
+// Hamming-windowed real FFT (radix 2, the real signal packed into a half size complex
+// transform). Amplitudes are scaled by 2 / window sum like ofxFft's, so a full scale sine
+// reads about 1 in its bin and band levels keep their calibration. Tables are built in the
+// constructor, transform() never allocates. No dependencies.
+class RealFft : public SpectrumTransform {
+public:
+	explicit RealFft(int size = 1024); // Power of two, at least 4
+
+	const float * transform(const float * samples) override;
+	int getSize() const override { return size; }
+
+private:
+	int size;
+	int half;
+	float normalizer;
+	std::vector<float> window;
+	std::vector<int> bitReverse; // half entries
+	std::vector<float> twiddleRe, twiddleIm; // e^(-2 pi i j / half), half / 2 entries
+	std::vector<float> splitRe, splitIm; // e^(-2 pi i k / size), half entries
+	std::vector<float> re, im; // Packed complex signal, then its spectrum
+	std::vector<float> amplitude;
+};
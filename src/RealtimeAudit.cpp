@@ -0,0 +1,343 @@
+#include "RealtimeAudit.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <execinfo.h>
+#endif
+#if defined(__GNUC__)
+    #include <cxxabi.h>
+    #define AUDIT_NOINLINE __attribute__((noinline))
+    #define AUDIT_INLINE inline __attribute__((always_inline))
+#else
+    #define AUDIT_NOINLINE __declspec(noinline)
+    #define AUDIT_INLINE __forceinline
+#endif
+#if defined(__linux__)
+    #include <dlfcn.h>
+    #include <pthread.h>
+#endif
+
+namespace {
+
+// One call stack that allocated or locked inside a section
+struct Site {
+    std::atomic<uint64_t> key { 0 }; // Hash of the stack, section and kind, 0 = free
+    std::atomic<bool> ready { false }; // Stack written
+    int section = 0;
+    int kind = 0;
+    int depth = 0;
+    void * frames[RealtimeAudit::MAX_DEPTH] = {};
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<uint64_t> bytes { 0 };
+};
+
+// record() and the intercepting function sit above the caller on every stack
+const int SKIP_FRAMES = 2;
+
+std::atomic<bool> enabled(false);
+std::atomic<uint64_t> events[RealtimeAudit::NUM_SECTIONS][RealtimeAudit::NUM_KINDS];
+std::atomic<uint64_t> bytes[RealtimeAudit::NUM_SECTIONS];
+std::atomic<uint64_t> sections[RealtimeAudit::NUM_SECTIONS];
+std::atomic<uint64_t> flagged[RealtimeAudit::NUM_SECTIONS];
+std::atomic<uint64_t> untracked(0);
+Site sites[RealtimeAudit::MAX_SITES];
+
+thread_local int currentSection = RealtimeAudit::SECTION_NONE;
+thread_local bool sectionFailed = false;
+thread_local bool recording = false; // The stack walk and the report may allocate or lock themselves
+
+// Inlined at any optimisation level, so it never shows up as a frame of its own
+AUDIT_INLINE int captureStack(void ** frames, int count) {
+#if defined(_WIN32)
+    return CaptureStackBackTrace(0, count, frames, nullptr);
+#else
+    return backtrace(frames, count);
+#endif
+}
+
+AUDIT_NOINLINE void record(RealtimeAudit::Kind kind, size_t size) {
+    int section = currentSection;
+    if (section == RealtimeAudit::SECTION_NONE || recording) return;
+    recording = true;
+
+    events[section][kind].fetch_add(1, std::memory_order_relaxed);
+    if (kind == RealtimeAudit::KIND_ALLOCATION) bytes[section].fetch_add(size, std::memory_order_relaxed);
+    if (RealtimeAudit::isFailure((RealtimeAudit::Section)section, kind)) sectionFailed = true;
+
+    void * stack[RealtimeAudit::MAX_DEPTH + SKIP_FRAMES];
+    int depth = captureStack(stack, RealtimeAudit::MAX_DEPTH + SKIP_FRAMES);
+    int skip = std::min(depth, SKIP_FRAMES);
+    void ** frames = stack + skip;
+    depth -= skip;
+
+    // FNV-1a over the return addresses, never 0
+    uint64_t key = 1469598103934665603ull;
+    auto mix = [&](uint64_t value) { key = (key ^ value) * 1099511628211ull; };
+    for (int i = 0; i < depth; i++) mix((uint64_t)(uintptr_t)frames[i]);
+    mix((uint64_t)section);
+    mix((uint64_t)kind);
+    key |= 1;
+
+    // Open addressing; a slot is claimed with one compare-exchange and filled by its claimer
+    bool found = false;
+    for (int probe = 0; probe < RealtimeAudit::MAX_SITES && !found; probe++) {
+        Site & site = sites[(key + probe) % RealtimeAudit::MAX_SITES];
+        uint64_t existing = site.key.load(std::memory_order_acquire);
+        if (existing == 0 && site.key.compare_exchange_strong(existing, key, std::memory_order_acq_rel)) {
+            site.section = section;
+            site.kind = kind;
+            site.depth = depth;
+            std::copy(frames, frames + depth, site.frames);
+            site.ready.store(true, std::memory_order_release);
+            existing = key;
+        }
+        if (existing != key) continue;
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        site.bytes.fetch_add(size, std::memory_order_relaxed);
+        found = true;
+    }
+    if (!found) untracked.fetch_add(1, std::memory_order_relaxed);
+
+    recording = false;
+}
+
+// Mangled names in a backtrace_symbols line, demangled in place
+std::string demangle(const char * symbol) {
+    std::string text = symbol;
+#if defined(__GNUC__)
+    size_t begin = text.find("_Z");
+    if (begin == std::string::npos) return text;
+    size_t end = text.find_first_of("+ )", begin);
+    std::string mangled = text.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    int status = 0;
+    char * name = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+    if (status == 0 && name) text.replace(begin, mangled.size(), name);
+    std::free(name);
+#endif
+    return text;
+}
+
+} // namespace
+
+void RealtimeAudit::setEnabled(bool enable) {
+    // The first stack walk loads the unwinder, keep that out of every section
+    void * frame;
+    captureStack(&frame, 1);
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool RealtimeAudit::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void RealtimeAudit::reset() {
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        for (int k = 0; k < NUM_KINDS; k++) events[s][k] = 0;
+        bytes[s] = 0;
+        sections[s] = 0;
+        flagged[s] = 0;
+    }
+    untracked = 0;
+    for (Site & site : sites) {
+        site.ready = false;
+        site.count = 0;
+        site.bytes = 0;
+        site.key = 0;
+    }
+}
+
+void RealtimeAudit::begin(Section section) {
+    currentSection = section;
+    sectionFailed = false;
+    if (enabled.load(std::memory_order_relaxed)) sections[section].fetch_add(1, std::memory_order_relaxed);
+}
+
+void RealtimeAudit::end() {
+    if (currentSection == SECTION_NONE) return;
+    if (sectionFailed && enabled.load(std::memory_order_relaxed)) flagged[currentSection].fetch_add(1, std::memory_order_relaxed);
+    currentSection = SECTION_NONE;
+    sectionFailed = false;
+}
+
+RealtimeAudit::Totals RealtimeAudit::getTotals() {
+    Totals totals;
+    for (int s = 0; s < NUM_SECTIONS; s++) {
+        for (int k = 0; k < NUM_KINDS; k++) totals.events[s][k] = events[s][k].load(std::memory_order_relaxed);
+        totals.bytes[s] = bytes[s].load(std::memory_order_relaxed);
+        totals.sections[s] = sections[s].load(std::memory_order_relaxed);
+        totals.flagged[s] = flagged[s].load(std::memory_order_relaxed);
+    }
+    totals.untracked = untracked.load(std::memory_order_relaxed);
+    return totals;
+}
+
+bool RealtimeAudit::isFailure(Section section, Kind kind) {
+    return section != SECTION_FRAME || kind == KIND_ALLOCATION;
+}
+
+bool RealtimeAudit::passed(const Totals & totals) {
+    for (int s = SECTION_NONE + 1; s < NUM_SECTIONS; s++) {
+        for (int k = 0; k < NUM_KINDS; k++) {
+            if (isFailure((Section)s, (Kind)k) && totals.events[s][k] > 0) return false;
+        }
+    }
+    return true;
+}
+
+const char * RealtimeAudit::getSectionName(Section section) {
+    static const char * names[NUM_SECTIONS] = { "none", "audio callback", "analysis hop", "frame" };
+    return (section >= 0 && section < NUM_SECTIONS) ? names[section] : "?";
+}
+
+const char * RealtimeAudit::getKindName(Kind kind) {
+    return kind == KIND_ALLOCATION ? "allocation" : "lock";
+}
+
+bool RealtimeAudit::writeReport(const std::string & path) {
+    // Nothing this thread does here is counted, whichever section it is in
+    bool wasRecording = recording;
+    recording = true;
+
+    FILE * out = fopen(path.c_str(), "w");
+    if (!out) {
+        recording = wasRecording;
+        return false;
+    }
+
+    Totals totals = getTotals();
+    fprintf(out, "Realtime audit: %s\n", passed(totals) ? "PASSED" : "FAILED");
+    fprintf(out, "Fails on: any allocation or lock in the audio callback or an analysis hop, any allocation in a frame.\n\n");
+    fprintf(out, "%-16s %10s %10s %12s %12s %10s\n", "section", "entered", "failed", "allocations", "bytes", "locks");
+    for (int s = SECTION_NONE + 1; s < NUM_SECTIONS; s++) {
+        fprintf(out, "%-16s %10llu %10llu %12llu %12llu %10llu\n", getSectionName((Section)s), (unsigned long long)totals.sections[s],
+                (unsigned long long)totals.flagged[s], (unsigned long long)totals.events[s][KIND_ALLOCATION], (unsigned long long)totals.bytes[s],
+                (unsigned long long)totals.events[s][KIND_LOCK]);
+    }
+    if (totals.untracked > 0) fprintf(out, "%llu events without a call site (site table full)\n", (unsigned long long)totals.untracked);
+
+    // Failures first, then by count
+    std::vector<const Site *> found;
+    for (const Site & site : sites) {
+        if (site.ready.load(std::memory_order_acquire) && site.count.load(std::memory_order_relaxed) > 0) found.push_back(&site);
+    }
+    std::sort(found.begin(), found.end(), [](const Site * a, const Site * b) {
+        bool failA = isFailure((Section)a->section, (Kind)a->kind), failB = isFailure((Section)b->section, (Kind)b->kind);
+        if (failA != failB) return failA;
+        return a->count.load() > b->count.load();
+    });
+
+    for (const Site * site : found) {
+        Section section = (Section)site->section;
+        Kind kind = (Kind)site->kind;
+        fprintf(out, "\n%s %s, %s x %llu", isFailure(section, kind) ? "FAIL" : "note", getSectionName(section), getKindName(kind),
+                (unsigned long long)site->count.load());
+        if (kind == KIND_ALLOCATION) fprintf(out, " (%llu bytes)", (unsigned long long)site->bytes.load());
+        fprintf(out, "\n");
+#if defined(_WIN32)
+        for (int i = 0; i < site->depth; i++) fprintf(out, "  #%d %p\n", i, site->frames[i]);
+#else
+        char ** symbols = backtrace_symbols(site->frames, site->depth);
+        for (int i = 0; i < site->depth; i++) {
+            if (symbols) fprintf(out, "  #%d %s\n", i, demangle(symbols[i]).c_str());
+            else fprintf(out, "  #%d %p\n", i, site->frames[i]);
+        }
+        std::free(symbols);
+#endif
+    }
+
+    bool ok = !ferror(out);
+    fclose(out);
+    recording = wasRecording;
+    return ok;
+}
+
+// --- INTERCEPTION ---
+// Replaces the global operator new (aligned new keeps the library's own pair). The
+// hook runs before the allocation, so a failing one is still counted.
+
+static void * allocate(size_t size) {
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void * p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+AUDIT_NOINLINE void * operator new(size_t size) {
+    if (enabled.load(std::memory_order_relaxed)) record(RealtimeAudit::KIND_ALLOCATION, size);
+    if (void * p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+AUDIT_NOINLINE void * operator new[](size_t size) {
+    if (enabled.load(std::memory_order_relaxed)) record(RealtimeAudit::KIND_ALLOCATION, size);
+    if (void * p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+AUDIT_NOINLINE void * operator new(size_t size, const std::nothrow_t &) noexcept {
+    if (enabled.load(std::memory_order_relaxed)) record(RealtimeAudit::KIND_ALLOCATION, size);
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+AUDIT_NOINLINE void * operator new[](size_t size, const std::nothrow_t &) noexcept {
+    if (enabled.load(std::memory_order_relaxed)) record(RealtimeAudit::KIND_ALLOCATION, size);
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void * p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void * p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+
+#if defined(__linux__)
+// std::mutex, ofMutex and most C libraries lock through this symbol; the executable's
+// definition takes precedence over libc's, which is looked up once and called through
+extern "C" AUDIT_NOINLINE int pthread_mutex_lock(pthread_mutex_t * mutex) noexcept {
+    using LockFunction = int (*)(pthread_mutex_t *);
+    static std::atomic<LockFunction> next(nullptr);
+    LockFunction lock = next.load(std::memory_order_acquire);
+    if (!lock) {
+        lock = (LockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+        next.store(lock, std::memory_order_release);
+    }
+    if (enabled.load(std::memory_order_relaxed)) record(RealtimeAudit::KIND_LOCK, 0);
+    return lock(mutex);
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Allocation and lock audit for the realtime paths.
+// Threads mark their realtime work as sections (RealtimeSection): the audio callback, one
+// analysis hop, one rendered frame from update() to the end of draw(). While the audit is
+// enabled, global operator new and (on Linux) pthread_mutex_lock, which std::mutex goes
+// through, are intercepted and counted against the section the calling thread is in,
+// together with the call stack, so the report can say where. Plain malloc from C libraries
+// is not seen.
+// Anything on the audio or analysis thread fails the audit, and so does an allocation in a
+// frame. Locks in frames are listed but expected (drivers, video players).
+// Disabled, a hook costs a relaxed load; outside a section, a thread-local read.
+// No openFrameworks dependency.
+class RealtimeAudit {
+public:
+	enum Section {
+		SECTION_NONE = 0,
+		SECTION_AUDIO, // Audio callback
+		SECTION_ANALYSIS, // One analysis hop
+		SECTION_FRAME, // update() + draw()
+		NUM_SECTIONS
+	};
+
+	enum Kind {
+		KIND_ALLOCATION = 0,
+		KIND_LOCK,
+		NUM_KINDS
+	};
+
+	static const int MAX_SITES = 256; // Distinct call stacks, later ones only count
+	static const int MAX_DEPTH = 12; // Frames per call stack
+
+	struct Totals {
+		uint64_t events[NUM_SECTIONS][NUM_KINDS] = {};
+		uint64_t bytes[NUM_SECTIONS] = {};
+		uint64_t sections[NUM_SECTIONS] = {}; // Entered while enabled
+		uint64_t flagged[NUM_SECTIONS] = {}; // ... of those with at least one failing event
+		uint64_t untracked = 0; // Events whose call stack did not fit the site table
+	};
+
+	// Call from outside any section. reset() clears the counts and the call sites.
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+	static void reset();
+
+	// The calling thread enters / leaves a section. Sections do not nest, end() outside one is a no-op.
+	static void begin(Section section);
+	static void end();
+
+	static Totals getTotals();
+	static bool isFailure(Section section, Kind kind);
+	static bool passed(const Totals & totals);
+	static const char * getSectionName(Section section);
+	static const char * getKindName(Kind kind);
+
+	// Totals, then every call site with its count, most frequent first, symbolized where the
+	// platform can. False if the file could not be written.
+	static bool writeReport(const std::string & path);
+};
+
+// Marks the enclosing block as a realtime section of the calling thread
+class RealtimeSection {
+public:
+	explicit RealtimeSection(RealtimeAudit::Section section) { RealtimeAudit::begin(section); }
+	~RealtimeSection() { RealtimeAudit::end(); }
+
+	RealtimeSection(const RealtimeSection &) = delete;
+	RealtimeSection & operator=(const RealtimeSection &) = delete;
+};
@@ -0,0 +1,118 @@
+#include "RenderGraph.h"
+
+static const char * passNames[RenderGraph::NUM_PASSES] = {
+    "scene", "feedback", "flash", "scanlines", "present"
+};
+
+const char * RenderGraph::getPassName(Pass pass) {
+    return passNames[pass];
+}
+
+void RenderGraph::allocate(int outputWidth, int outputHeight, int internalHeight) {
+    int h = (internalHeight > 0) ? internalHeight : outputHeight;
+    int w = (internalHeight > 0) ? (int)roundf((float)h * outputWidth / std::max(outputHeight, 1)) : outputWidth;
+    w = std::max(w, 16);
+    h = std::max(h, 16);
+    if (w == width && h == height) return;
+    width = w;
+    height = h;
+
+    ofFboSettings settings;
+    settings.width = width;
+    settings.height = height;
+    settings.internalformat = GL_RGBA;
+    scene.allocate(settings);
+    post.allocate(settings);
+
+    // Float trail so long fades do not band or leave 8 bit residue
+    settings.internalformat = GL_RGBA16F;
+    for (auto & fbo : trail) {
+        fbo.allocate(settings);
+        fbo.begin();
+        ofClear(0, 0, 0, 255);
+        fbo.end();
+    }
+    output = &scene;
+    ofLogNotice() << "RENDER: internal resolution " << width << "x" << height;
+}
+
+void RenderGraph::startTiming(Pass pass) {
+    activePass = pass;
+    passStart = ofGetElapsedTimeMicros();
+    passes[pass].gpu.begin();
+}
+
+void RenderGraph::stopTiming() {
+    if (activePass < 0) return;
+    passes[activePass].gpu.end();
+    passes[activePass].cpuMs = (ofGetElapsedTimeMicros() - passStart) / 1000.0f;
+    activePass = -1;
+}
+
+bool RenderGraph::begin(Pass pass) {
+    if (pass == PASS_SCENE) output = &scene;
+    if (!passes[pass].enabled) return false; // A disabled scene keeps its last frame
+    startTiming(pass);
+
+    if (pass == PASS_SCENE) {
+        scene.begin();
+        ofClear(0, 0, 0, 0); // Transparent where nothing is drawn, so the trail shows through
+    } else {
+        // Overlays go onto a copy so they never feed back into the trail
+        post.begin();
+        if (output != &post) {
+            ofPushStyle();
+            ofDisableAlphaBlending();
+            ofSetColor(255);
+            output->draw(0, 0);
+            ofPopStyle();
+            drawCalls++;
+            output = &post;
+        }
+    }
+    return true;
+}
+
+void RenderGraph::end() {
+    if (activePass < 0) return;
+    if (activePass == PASS_SCENE) scene.end();
+    else post.end();
+    stopTiming();
+}
+
+void RenderGraph::feedback(float fade) {
+    if (!passes[PASS_FEEDBACK].enabled) return;
+    startTiming(PASS_FEEDBACK);
+
+    ofFbo & src = trail[trailIndex];
+    ofFbo & dst = trail[1 - trailIndex];
+    trailIndex = 1 - trailIndex;
+
+    dst.begin();
+    ofPushStyle();
+    ofDisableAlphaBlending();
+    ofSetColor(255.0f * ofClamp(1.0f - fade, 0.0f, 1.0f));
+    src.draw(0, 0);
+    ofEnableAlphaBlending();
+    ofSetColor(255);
+    output->draw(0, 0);
+    ofPopStyle();
+    dst.end();
+    drawCalls += 2;
+
+    output = &dst;
+    stopTiming();
+}
+
+void RenderGraph::present(float x, float y, float w, float h) {
+    startTiming(PASS_PRESENT);
+    ofPushStyle();
+    ofDisableAlphaBlending();
+    ofSetColor(255);
+    output->draw(x, y, w, h);
+    ofPopStyle();
+    stopTiming();
+
+    lastDrawCalls = drawCalls + 1;
+    drawCalls = 0;
+}
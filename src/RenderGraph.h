@@ -0,0 +1,71 @@
+#pragma once
+#include "ofMain.h"
+#include "GpuTimer.h"
+
+// Fixed chain of offscreen passes at an internal resolution independent of the window:
+//   scene (video + mosh shader) -> feedback trail (ping-pong) -> overlays -> present
+// Each pass can be switched off and reports CPU and GPU time. The trail lives in its own
+// float buffers instead of relying on the back buffer surviving between frames, and the
+// overlays are drawn on a copy so they never smear into it.
+class RenderGraph {
+public:
+	enum Pass {
+		PASS_SCENE = 0, // Video through the mosh shader, off = freeze frame
+		PASS_FEEDBACK, // Trail: previous output faded, scene composited on top
+		PASS_FLASH, // Strobe overlay
+		PASS_SCANLINES, // CRT lines
+		PASS_PRESENT, // Scale to the window
+		NUM_PASSES
+	};
+
+	// internalHeight 0 renders at window size, otherwise e.g. 720 (upscaled) or 2160 (supersampled)
+	void allocate(int outputWidth, int outputHeight, int internalHeight);
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	void setEnabled(Pass pass, bool enabled) { passes[pass].enabled = enabled; }
+	bool isEnabled(Pass pass) const { return passes[pass].enabled; }
+
+	// Draw a pass at internal resolution between begin() and end(). begin() returns false
+	// when the pass is off. The scene starts cleared, overlays draw onto the current output.
+	bool begin(Pass pass);
+	void end();
+
+	void feedback(float fade); // fade 0 keeps the whole trail, 1 keeps none
+	void present(float x, float y, float w, float h);
+	const ofFbo & getOutput() const { return *output; } // Finished frame at internal resolution
+	const ofFbo & getScene() const { return scene; } // Scene pass alone, before the trail and overlays
+
+	static const char * getPassName(Pass pass);
+	float getCpuMs(Pass pass) const { return passes[pass].cpuMs; }
+	float getGpuMs(Pass pass) const { return passes[pass].gpu.getMs(); }
+
+	// Draw calls issued last frame. The graph counts its own copies, callers add what they draw
+	// inside begin()/end(). Latched and reset by present().
+	void addDrawCalls(int count) { drawCalls += count; }
+	int getDrawCalls() const { return lastDrawCalls; }
+
+private:
+	struct PassState {
+		bool enabled = true;
+		float cpuMs = 0.0f;
+		GpuTimer gpu;
+	};
+
+	void startTiming(Pass pass);
+	void stopTiming();
+
+	int width = 0;
+	int height = 0;
+	ofFbo scene;
+	ofFbo post; // Scene or trail plus overlays
+	ofFbo trail[2];
+	int trailIndex = 0;
+	ofFbo * output = &scene; // What the overlays draw on and present shows
+
+	PassState passes[NUM_PASSES];
+	int activePass = -1;
+	uint64_t passStart = 0;
+	int drawCalls = 0;
+	int lastDrawCalls = 0;
+};
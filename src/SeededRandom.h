@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// Small seeded generator (xorshift64*, seeded through splitmix64) for everything random that
+// ends up on screen. Unlike ofRandom() / rand() the sequence is defined here, so an offline
+// render with the same seed repeats exactly on any platform. No openFrameworks dependency.
+class SeededRandom {
+public:
+	explicit SeededRandom(uint64_t seed = 1) { setSeed(seed); }
+
+	void setSeed(uint64_t seed) {
+		uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		state = (z ^ (z >> 31)) | 1; // Never zero
+	}
+
+	uint32_t next() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	// [0, 1) with 24 bits, exact in float
+	float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+	float uniform(float low, float high) { return low + (high - low) * uniform(); }
+	int index(int count) { return count > 0 ? (int)(((uint64_t)next() * (uint32_t)count) >> 32) : 0; }
+
+private:
+	uint64_t state = 1;
+};
@@ -0,0 +1,125 @@
+#include "ShaderCache.h"
+
+static const char * styleNames[ShaderCache::NUM_STYLES] = {
+    "Liquid Silk", "The Vortex", "Plasma Blobs", "Kaleidoscope",
+    "The Tunnel", "Waves of Grain", "Rings of Saturn", "Geometric Fractal"
+};
+
+const char * ShaderCache::getStyleName(int style) {
+    return styleNames[(int)ofClamp(style, 0, NUM_STYLES - 1)];
+}
+
+// Defines go right after #version, which has to stay the first line
+static string withDefines(const string & source, const string & defines) {
+    size_t at = 0;
+    if (source.compare(0, 8, "#version") == 0) {
+        at = source.find('\n');
+        at = (at == string::npos) ? source.size() : at + 1;
+    }
+    return source.substr(0, at) + defines + source.substr(at);
+}
+
+bool ShaderCache::setup(const string & vert, const string & frag) {
+    vertPath = vert;
+    fragPath = frag;
+    vertFile = ofToDataPath(vertPath, true);
+    fragFile = ofToDataPath(fragPath, true);
+    return reload();
+}
+
+bool ShaderCache::readSources(string & vert, string & frag) {
+    std::error_code ec;
+    vertStamp = std::filesystem::last_write_time(vertFile, ec);
+    fragStamp = std::filesystem::last_write_time(fragFile, ec);
+
+    ofBuffer vertBuffer = ofBufferFromFile(vertPath);
+    ofBuffer fragBuffer = ofBufferFromFile(fragPath);
+    if (vertBuffer.size() == 0 || fragBuffer.size() == 0) {
+        ofLogError() << "SHADER: could not read " << vertPath << " / " << fragPath;
+        return false;
+    }
+    vert = vertBuffer.getText();
+    frag = fragBuffer.getText();
+    return true;
+}
+
+unique_ptr<ofShader> ShaderCache::build(int styleA, int styleB) const {
+    string defines = "#define STYLE_A " + ofToString(styleA) + "\n";
+    if (styleB >= 0) defines += "#define STYLE_B " + ofToString(styleB) + "\n";
+
+    auto shader = make_unique<ofShader>();
+    if (!shader->setupShaderFromSource(GL_VERTEX_SHADER, vertSource) ||
+        !shader->setupShaderFromSource(GL_FRAGMENT_SHADER, withDefines(fragSource, defines)) ||
+        !shader->bindDefaults() ||
+        !shader->linkProgram()) {
+        ofLogError() << "SHADER: variant " << styleA << (styleB >= 0 ? "->" + ofToString(styleB) : "") << " failed to build";
+        return nullptr;
+    }
+    if (onLink) onLink(*shader);
+    return shader;
+}
+
+bool ShaderCache::reload() {
+    uint64_t start = ofGetElapsedTimeMicros();
+
+    string vert, frag;
+    if (!readSources(vert, frag)) return false;
+    std::swap(vert, vertSource);
+    std::swap(frag, fragSource);
+
+    // Every style and the step to the following one, which is the order the show walks through
+    ProgramMap built;
+    bool ok = true;
+    for (int i = 0; i < NUM_STYLES && ok; i++) {
+        auto single = build(i, -1);
+        auto next = build(i, (i + 1) % NUM_STYLES);
+        ok = single && next;
+        built[key(i, i)] = std::move(single);
+        built[key(i, (i + 1) % NUM_STYLES)] = std::move(next);
+    }
+
+    if (!ok) {
+        // Keep running on the last good build; sources stay as they were for lazy variants
+        std::swap(vert, vertSource);
+        std::swap(frag, fragSource);
+        ofLogError() << "SHADER: build failed, keeping " << (programs.empty() ? "nothing" : "the previous programs");
+        return false;
+    }
+
+    programs = std::move(built);
+    buildMs = (ofGetElapsedTimeMicros() - start) / 1000.0f;
+    ofLogNotice() << "SHADER: " << programs.size() << " variants built in " << ofToString(buildMs, 1) << " ms";
+    return true;
+}
+
+void ShaderCache::checkReload(float dt) {
+    checkTimer += dt;
+    if (checkTimer < 0.5f) return;
+    checkTimer = 0.0f;
+
+    std::error_code ec;
+    auto vert = std::filesystem::last_write_time(vertFile, ec);
+    if (ec) return;
+    auto frag = std::filesystem::last_write_time(fragFile, ec);
+    if (ec) return;
+    if (vert != vertStamp || frag != fragStamp) reload();
+}
+
+ofShader & ShaderCache::get(int style) {
+    return getTransition(style, style);
+}
+
+ofShader & ShaderCache::getTransition(int fromStyle, int toStyle) {
+    fromStyle = (int)ofClamp(fromStyle, 0, NUM_STYLES - 1);
+    toStyle = (int)ofClamp(toStyle, 0, NUM_STYLES - 1);
+
+    auto found = programs.find(key(fromStyle, toStyle));
+    if (found != programs.end()) return *found->second;
+
+    // Jumps between styles that are not neighbours are rare, build them when first asked
+    auto shader = build(fromStyle, toStyle);
+    if (!shader) return *programs.at(key(toStyle, toStyle));
+    ofShader & result = *shader;
+    programs[key(fromStyle, toStyle)] = std::move(shader);
+    return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "ofMain.h"
+#include <filesystem>
+#include <map>
+
+// The mosh shader built once per style instead of one uber-shader branching on the mode.
+// shader.frag picks its pattern from STYLE_A, and a transition variant also gets STYLE_B
+// and blends the two by the styleMix uniform, so a style change costs two patterns rather
+// than eight. Single styles and the transitions to the next style are linked up front,
+// other pairs on first use. Source files are polled so edits show up while rehearsing;
+// a broken edit is logged and the last good programs stay in use.
+class ShaderCache {
+public:
+	static const int NUM_STYLES = 8;
+
+	bool setup(const string & vertPath, const string & fragPath);
+	bool reload(); // Rebuild everything from disk, keeps the old programs on failure
+	void checkReload(float dt); // Poll the source files, reload when they change
+
+	ofShader & get(int style);
+	ofShader & getTransition(int fromStyle, int toStyle);
+	bool isLoaded() const { return !programs.empty(); }
+	float getBuildMs() const { return buildMs; } // Last full build
+
+	// Called on every program once it links, e.g. to bind the uniform block
+	void setOnLink(std::function<void(ofShader &)> callback) { onLink = callback; }
+
+	static const char * getStyleName(int style);
+
+private:
+	typedef std::map<int, unique_ptr<ofShader>> ProgramMap;
+
+	static int key(int styleA, int styleB) { return styleA * NUM_STYLES + styleB; }
+	unique_ptr<ofShader> build(int styleA, int styleB) const; // styleB < 0 = single style
+	bool readSources(string & vert, string & frag);
+
+	string vertPath;
+	string fragPath;
+	std::filesystem::path vertFile; // Resolved once, polled without building paths
+	std::filesystem::path fragFile;
+	string vertSource;
+	string fragSource;
+	ProgramMap programs;
+	std::function<void(ofShader &)> onLink;
+	float buildMs = 0.0f;
+
+	std::filesystem::file_time_type vertStamp;
+	std::filesystem::file_time_type fragStamp;
+	float checkTimer = 0.0f;
+};
@@ -0,0 +1,211 @@
+#include "SharedFrameRing.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(SharedFrameHeader) <= SharedFrameRing::ALIGN, "header must fit its 64 byte block");
+static_assert(sizeof(SharedFrameSlot) <= SharedFrameRing::ALIGN, "slot header must fit its 64 byte block");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock free across processes");
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + SharedFrameRing::ALIGN - 1) / SharedFrameRing::ALIGN * SharedFrameRing::ALIGN;
+}
+
+uint64_t SharedFrameRing::nowMicros() {
+    // steady_clock is CLOCK_MONOTONIC on Linux and macOS, so both processes agree on it
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- WRITER ---
+
+bool SharedFrameWriter::open(const std::string & segmentName, int numSlots, size_t frameBytes) {
+    close();
+#ifdef _WIN32
+    error = "shared memory output needs POSIX shm";
+    return false;
+#else
+    name = segmentName;
+    numSlots = std::max(numSlots, 2);
+    maxFrameBytes = alignUp(frameBytes);
+    size_t slotBytes = SharedFrameRing::ALIGN + maxFrameBytes;
+    size_t total = SharedFrameRing::ALIGN + slotBytes * numSlots;
+
+    // A stale segment from a crashed run is replaced, readers still mapping it see it closed
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, (off_t)total) != 0) {
+        error = "ftruncate " + name + ": " + strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void * mapping = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "mmap " + name + ": " + strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    base = (uint8_t *)mapping;
+    mappedBytes = total;
+    header = new (base) SharedFrameHeader();
+    header->version = SharedFrameRing::VERSION;
+    header->numSlots = (uint32_t)numSlots;
+    header->writerPid = (uint32_t)getpid();
+    header->slotBytes = slotBytes;
+    header->latest.store(0, std::memory_order_relaxed);
+    header->closed.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < numSlots; i++) new (slot(i)) SharedFrameSlot();
+    sequence = 0;
+    writing = -1;
+
+    // Magic last: a reader that opens the segment mid-setup rejects it
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, "CGNF", 4);
+    error.clear();
+    return true;
+#endif
+}
+
+void SharedFrameWriter::close() {
+#ifndef _WIN32
+    if (!header) return;
+    header->closed.store(1, std::memory_order_release);
+    munmap(base, mappedBytes);
+    shm_unlink(name.c_str());
+#endif
+    base = nullptr;
+    header = nullptr;
+    mappedBytes = 0;
+    writing = -1;
+}
+
+SharedFrameSlot * SharedFrameWriter::slot(int index) const {
+    return (SharedFrameSlot *)(base + SharedFrameRing::ALIGN + header->slotBytes * index);
+}
+
+uint8_t * SharedFrameWriter::beginFrame() {
+    if (!header) return nullptr;
+    writing = (int)(sequence % header->numSlots); // Oldest frame in the ring
+    SharedFrameSlot * target = slot(writing);
+    target->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // Readers see 0 before any new pixels
+    return (uint8_t *)target + SharedFrameRing::ALIGN;
+}
+
+void SharedFrameWriter::publish(const SharedFrameRing::Frame & frame) {
+    if (!header || writing < 0) return;
+    SharedFrameSlot * target = slot(writing);
+    target->renderMicros = frame.renderMicros;
+    target->publishMicros = SharedFrameRing::nowMicros();
+    target->width = (uint32_t)frame.width;
+    target->height = (uint32_t)frame.height;
+    target->stride = (uint32_t)frame.stride;
+    target->format = (uint32_t)frame.format;
+    target->flags = (uint32_t)frame.flags;
+
+    sequence++;
+    target->sequence.store(sequence, std::memory_order_release);
+    header->latest.store(sequence, std::memory_order_release);
+    writing = -1;
+}
+
+// --- READER ---
+
+bool SharedFrameReader::open(const std::string & name) {
+    close();
+#ifdef _WIN32
+    error = "shared memory output needs POSIX shm";
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        error = "shm_open " + name + ": " + strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < SharedFrameRing::ALIGN) {
+        error = name + " is not a frame ring";
+        ::close(fd);
+        return false;
+    }
+    void * mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "mmap " + name + ": " + strerror(errno);
+        return false;
+    }
+
+    base = (uint8_t *)mapping;
+    mappedBytes = (size_t)info.st_size;
+    header = (const SharedFrameHeader *)base;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    bool valid = memcmp(header->magic, "CGNF", 4) == 0 && header->version == SharedFrameRing::VERSION && header->numSlots > 0 &&
+                 SharedFrameRing::ALIGN + header->slotBytes * header->numSlots <= mappedBytes;
+    if (!valid) {
+        error = name + " is not a version " + std::to_string(SharedFrameRing::VERSION) + " frame ring";
+        close();
+        return false;
+    }
+    error.clear();
+    return true;
+#endif
+}
+
+void SharedFrameReader::close() {
+#ifndef _WIN32
+    if (base) munmap(base, mappedBytes);
+#endif
+    base = nullptr;
+    header = nullptr;
+    mappedBytes = 0;
+}
+
+bool SharedFrameReader::isWriterClosed() const {
+    return !header || header->closed.load(std::memory_order_acquire) != 0;
+}
+
+uint64_t SharedFrameReader::getLatest() const {
+    return header ? header->latest.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedFrameReader::get(uint64_t sequence, SharedFrameRing::Frame & frame) const {
+    if (!header || sequence == 0) return false;
+    const SharedFrameSlot * slot = (const SharedFrameSlot *)(base + SharedFrameRing::ALIGN + header->slotBytes * ((sequence - 1) % header->numSlots));
+    if (slot->sequence.load(std::memory_order_acquire) != sequence) return false;
+
+    frame.sequence = sequence;
+    frame.renderMicros = slot->renderMicros;
+    frame.publishMicros = slot->publishMicros;
+    frame.width = (int)slot->width;
+    frame.height = (int)slot->height;
+    frame.stride = (int)slot->stride;
+    frame.format = (int)slot->format;
+    frame.flags = (int)slot->flags;
+    frame.pixels = (const uint8_t *)slot + SharedFrameRing::ALIGN;
+
+    // The fields above are only trusted if the slot was not rewritten while they were read
+    if (!isValid(frame)) return false;
+    return (size_t)frame.stride * frame.height <= header->slotBytes - SharedFrameRing::ALIGN;
+}
+
+bool SharedFrameReader::isValid(const SharedFrameRing::Frame & frame) const {
+    if (!header || frame.sequence == 0) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const SharedFrameSlot * slot = (const SharedFrameSlot *)(base + SharedFrameRing::ALIGN + header->slotBytes * ((frame.sequence - 1) % header->numSlots));
+    return slot->sequence.load(std::memory_order_relaxed) == frame.sequence;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Finished frames in a POSIX shared memory ring, for an encoder or any other process on the
+// same machine. One writer (the app) and any number of readers. Readers use the pixels where
+// they lie in the mapping; each slot is a seqlock, so a reader checks after using a frame
+// that the writer did not start overwriting it meanwhile.
+//
+// Layout (version 1), all fields native endian:
+//   SharedFrameHeader, padded to 64 bytes
+//   numSlots x [SharedFrameSlot, padded to 64 bytes][pixels, slotBytes - 64]
+// Timestamps are CLOCK_MONOTONIC microseconds, comparable between processes.
+struct SharedFrameHeader {
+	char magic[4]; // "CGNF"
+	uint32_t version;
+	uint32_t numSlots;
+	uint32_t writerPid;
+	uint64_t slotBytes; // Slot header + largest frame the segment was created for
+	std::atomic<uint64_t> latest; // Sequence of the newest complete frame, 0 = none yet
+	std::atomic<uint32_t> closed; // Set when the writer goes away or recreates the segment
+};
+
+struct SharedFrameSlot {
+	std::atomic<uint64_t> sequence; // 0 while being written, then the frame's sequence (from 1)
+	uint64_t renderMicros; // The frame was finished on the GPU side
+	uint64_t publishMicros; // ... and copied into this slot
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride; // Bytes per row
+	uint32_t format; // SharedFrameRing::Format
+	uint32_t flags; // SharedFrameRing::Flags
+};
+
+class SharedFrameRing {
+public:
+	static const uint32_t VERSION = 1;
+	static const size_t ALIGN = 64;
+
+	enum Format { FORMAT_RGBA8 = 1, FORMAT_BGRA8 = 2 };
+	enum Flags { FLAG_BOTTOM_UP = 1 }; // Rows as GL reads them, bottom row first
+
+	// A frame as readers see it, pixels point into the shared mapping
+	struct Frame {
+		uint64_t sequence = 0;
+		uint64_t renderMicros = 0;
+		uint64_t publishMicros = 0;
+		int width = 0;
+		int height = 0;
+		int stride = 0;
+		int format = 0;
+		int flags = 0;
+		const uint8_t * pixels = nullptr;
+	};
+
+	static uint64_t nowMicros(); // CLOCK_MONOTONIC
+};
+
+class SharedFrameWriter {
+public:
+	~SharedFrameWriter() { close(); }
+
+	// Creates (or replaces) the segment, name like "/cognitoni-frames"
+	bool open(const std::string & name, int numSlots, size_t maxFrameBytes);
+	void close(); // Marks the segment closed for readers and unlinks it
+	bool isOpen() const { return header != nullptr; }
+	size_t getMaxFrameBytes() const { return maxFrameBytes; }
+	const std::string & getError() const { return error; }
+
+	// Pixels of the slot the next frame goes to, invalidated for readers until publish()
+	uint8_t * beginFrame();
+	void publish(const SharedFrameRing::Frame & frame); // Everything but pixels is used
+	uint64_t getSequence() const { return sequence; } // Frames published so far
+
+private:
+	SharedFrameSlot * slot(int index) const;
+
+	std::string name;
+	std::string error;
+	uint8_t * base = nullptr;
+	size_t mappedBytes = 0;
+	SharedFrameHeader * header = nullptr;
+	size_t maxFrameBytes = 0;
+	uint64_t sequence = 0;
+	int writing = -1; // Slot between beginFrame() and publish()
+};
+
+class SharedFrameReader {
+public:
+	~SharedFrameReader() { close(); }
+
+	bool open(const std::string & name);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+	bool isWriterClosed() const; // Reopen to follow a writer that restarted or resized
+	const std::string & getError() const { return error; }
+
+	uint64_t getLatest() const;
+	// A frame by sequence, false when it is not in the ring (not written yet or overwritten)
+	bool get(uint64_t sequence, SharedFrameRing::Frame & frame) const;
+	// True when the frame's slot still holds it, check after reading the pixels
+	bool isValid(const SharedFrameRing::Frame & frame) const;
+
+private:
+	std::string error;
+	uint8_t * base = nullptr;
+	size_t mappedBytes = 0;
+	const SharedFrameHeader * header = nullptr;
+};
@@ -0,0 +1,444 @@
+#include "SoftwareMosh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const int L = SoftwareMosh::LANES;
+static const int TILE_ROWS = 16;
+
+// --- LANE MATH ---
+// Branch-free float approximations (selects instead of ifs, no libm calls), so every
+// for (i < L) loop over them vectorizes. Accuracy is well below one 8 bit step.
+
+static inline float floorLane(float x) {
+    float t = (float)(int)x;
+    return t - (t > x ? 1.0f : 0.0f);
+}
+
+static inline float fractLane(float x) { return x - floorLane(x); }
+static inline float clampLane(float x, float lo, float hi) { return std::min(std::max(x, lo), hi); }
+static inline float mixLane(float a, float b, float t) { return a + (b - a) * t; }
+
+static inline float smoothstepLane(float e0, float e1, float x) {
+    float t = clampLane((x - e0) / (e1 - e0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static inline float sqrtLane(float x) {
+    // Bit estimate of 1/sqrt and three Newton steps; std::sqrt keeps an errno branch that blocks vectorizing
+    x = std::max(x, 1e-30f);
+    uint32_t bits;
+    std::memcpy(&bits, &x, 4);
+    bits = 0x5F375A86u - (bits >> 1);
+    float y;
+    std::memcpy(&y, &bits, 4);
+    for (int i = 0; i < 3; i++) y = y * (1.5f - 0.5f * x * y * y);
+    return x * y;
+}
+
+static inline float sinLane(float x) {
+    // Reduce by 2pi in two parts (the first is exact for |k| < 2^15), fold into [-pi/2, pi/2]
+    const float PI = 3.14159265358979f;
+    float k = floorLane(x * 0.159154943091895f + 0.5f);
+    x = x - k * 6.28125f;
+    x = x - k * 1.93530717958647692e-3f;
+    x = x > PI * 0.5f ? PI - x : x;
+    x = x < -PI * 0.5f ? -PI - x : x;
+    float x2 = x * x;
+    return x * (1.0f + x2 * (-1.66666667e-1f + x2 * (8.33333333e-3f + x2 * (-1.98412698e-4f + x2 * (2.75573192e-6f + x2 * -2.50521084e-8f)))));
+}
+
+static inline float cosLane(float x) { return sinLane(x + 1.57079632679490f); }
+
+static inline float atan2Lane(float y, float x) {
+    const float PI = 3.14159265358979f;
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float hi = std::max(ax, ay);
+    float a = std::min(ax, ay) / (hi > 0.0f ? hi : 1.0f);
+    float s = a * a;
+    float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+    r = ay > ax ? PI * 0.5f - r : r;
+    r = x < 0.0f ? PI - r : r;
+    return y < 0.0f ? -r : r;
+}
+
+static inline float logLane(float x) {
+    // x = m * 2^e with m in [sqrt(0.5), sqrt(2)), then an atanh series for log(m)
+    uint32_t bits;
+    std::memcpy(&bits, &x, 4);
+    int e = (int)((bits >> 23) & 255) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    std::memcpy(&m, &bits, 4);
+    bool high = m > 1.41421356f;
+    m = high ? m * 0.5f : m;
+    float f = (m - 1.0f) / (m + 1.0f);
+    float f2 = f * f;
+    float series = 2.0f * f * (1.0f + f2 * (0.333333333f + f2 * (0.2f + f2 * (0.142857143f + f2 * 0.111111111f))));
+    return ((float)e + (high ? 1.0f : 0.0f)) * 0.693147181f + series;
+}
+
+// shader.frag's random(): fract(sin(dot(st, vec2(12.9898, 78.233))) * 43758.5453123)
+static inline float hashLane(float x, float y) {
+    return fractLane(sinLane(x * 12.9898f + y * 78.233f) * 43758.5453123f);
+}
+
+// --- STYLES ---
+// One lane loop per style, so the branch is per block of pixels, not per pixel
+
+static void stylePattern(int style, const float * px, const float * py, const float * r, const float * a, float freq, float time, float * d) {
+    switch (style) {
+        case 0: // LIQUID SILK
+            for (int i = 0; i < L; i++) d[i] = std::fabs(sinLane(py[i] * freq + time) * sinLane(px[i] * freq - time));
+            break;
+        case 1: // THE VORTEX
+            for (int i = 0; i < L; i++) d[i] = std::fabs(sinLane(a[i] * 6.0f + r[i] * 12.0f - time * 2.5f));
+            break;
+        case 2: // PLASMA BLOBS
+            for (int i = 0; i < L; i++) d[i] = std::fabs(sinLane(px[i] * freq + time) + sinLane(py[i] * freq + time) + sinLane((px[i] + py[i]) * freq));
+            break;
+        case 3: // KALEIDOSCOPE
+            for (int i = 0; i < L; i++) d[i] = std::fabs(cosLane(a[i] * 12.0f) * sinLane(r[i] * 15.0f - time));
+            break;
+        case 4: // THE TUNNEL
+            for (int i = 0; i < L; i++) d[i] = std::fabs(sinLane(logLane(std::max(r[i], 0.001f)) * 8.0f - time * 3.0f));
+            break;
+        case 5: // WAVES OF GRAIN
+            for (int i = 0; i < L; i++) d[i] = fractLane(sinLane(px[i] * freq + py[i] * freq) * 10.0f + time);
+            break;
+        case 6: // RINGS OF SATURN
+            for (int i = 0; i < L; i++) d[i] = std::fabs(sinLane(r[i] * 25.0f - time * 4.0f));
+            break;
+        default: // GEOMETRIC FRACTAL
+            for (int i = 0; i < L; i++) {
+                float qx = std::fabs(px[i]) - 0.2f;
+                float qy = std::fabs(py[i]) - 0.2f;
+                d[i] = std::fabs(sinLane(std::max(qx, qy) * 20.0f + time));
+            }
+            break;
+    }
+}
+
+// --- TEXTURE FETCH ---
+// Scalar gathers, bilinear with texel centres at +0.5 and clamp to edge
+
+static inline float fetchBilinear(const SoftwareMosh::Plane & plane, float u, float v, int channel) {
+    if (channel >= plane.channels) return 0.0f; // A red or red-green texture samples 0 there, as in GL
+    int stride = plane.stride ? plane.stride : plane.width * plane.channels;
+    float tx = u - 0.5f;
+    float ty = v - 0.5f;
+    float fx0 = std::floor(tx);
+    float fy0 = std::floor(ty);
+    float fx = tx - fx0;
+    float fy = ty - fy0;
+    int x0 = std::min(std::max((int)fx0, 0), plane.width - 1) * plane.channels + channel;
+    int x1 = std::min(std::max((int)fx0 + 1, 0), plane.width - 1) * plane.channels + channel;
+    int y0 = std::min(std::max((int)fy0, 0), plane.height - 1);
+    int y1 = std::min(std::max((int)fy0 + 1, 0), plane.height - 1);
+    const uint8_t * r0 = plane.data + (size_t)y0 * stride;
+    const uint8_t * r1 = plane.data + (size_t)y1 * stride;
+    float top = r0[x0] + (r0[x1] - r0[x0]) * fx;
+    float bottom = r1[x0] + (r1[x1] - r1[x0]) * fx;
+    return (top + (bottom - top) * fy) * (1.0f / 255.0f);
+}
+
+// fetchClip(): one RGB channel from a packed plane or NV12 (BT.709, video range)
+static inline float fetchClip(const SoftwareMosh::Source & source, float u, float v, int channel) {
+    if (!source.yuv) return fetchBilinear(source.image, u, v, channel);
+    float luma = (fetchBilinear(source.image, u, v, 0) - 16.0f / 255.0f) * (255.0f / 219.0f);
+    float cb = channel == 0 ? 0.0f : (fetchBilinear(source.chroma, u * 0.5f, v * 0.5f, 0) - 128.0f / 255.0f) * (255.0f / 224.0f);
+    float cr = channel == 2 ? 0.0f : (fetchBilinear(source.chroma, u * 0.5f, v * 0.5f, 1) - 128.0f / 255.0f) * (255.0f / 224.0f);
+    switch (channel) {
+        case 0: return luma + 1.5748f * cr;
+        case 1: return luma - 0.1873f * cb - 0.4681f * cr;
+        default: return luma + 1.8556f * cb;
+    }
+}
+
+// sampleClip(): one channel of the current clip, crossfaded with the incoming one
+static inline float sampleClip(const SoftwareMosh::Frame & frame, float u, float v, int channel) {
+    float value = fetchClip(frame.tex0, u, v, channel);
+    const ReactiveUniforms & p = frame.uniforms;
+    if (p.crossfade <= 0.0f) return value;
+    float scaleU = p.res1[0] / std::max(p.res[0], 1.0f);
+    float scaleV = p.res1[1] / std::max(p.res[1], 1.0f);
+    return mixLane(value, fetchClip(frame.tex1, u * scaleU, v * scaleV, channel), p.crossfade);
+}
+
+// sampleLayer() + blendLayer(): overlay i through its share of the displacement, blended
+// over the base pixel. uv is the texcoord before the mosh, final after it.
+static inline void blendLayer(const SoftwareMosh::Frame & frame, int i, float uvX, float uvY, float finalX, float finalY, float shift, float * rgb) {
+    const ReactiveUniforms & p = frame.uniforms;
+    const SoftwareMosh::Source & source = frame.layers[i];
+    float scaleU = p.layerRes[i][0] / std::max(p.res[0], 1.0f);
+    float scaleV = p.layerRes[i][1] / std::max(p.res[1], 1.0f);
+    float mosh = p.layerMosh[i];
+    float u = mixLane(uvX, finalX, mosh) * scaleU;
+    float v = mixLane(uvY, finalY, mosh) * scaleV;
+    float s = shift * mosh * scaleU;
+    float layer[3] = { fetchClip(source, u + s, v, 0), fetchClip(source, u, v, 1), fetchClip(source, u - s, v, 2) };
+
+    float opacity = p.layerOpacity[i];
+    if (p.layerBlend[i] == ReactiveUniforms::BLEND_DIFFERENCE) {
+        for (int c = 0; c < 3; c++) rgb[c] = mixLane(rgb[c], std::fabs(rgb[c] - layer[c]), opacity);
+    } else if (p.layerBlend[i] == ReactiveUniforms::BLEND_ADD) {
+        for (int c = 0; c < 3; c++) rgb[c] = std::min(rgb[c] + layer[c] * opacity, 1.0f);
+    } else { // Luma key
+        float key = smoothstepLane(0.25f, 0.6f, layer[0] * 0.2126f + layer[1] * 0.7152f + layer[2] * 0.0722f) * opacity;
+        for (int c = 0; c < 3; c++) rgb[c] = mixLane(rgb[c], layer[c], key);
+    }
+}
+
+// --- RENDER ---
+
+SoftwareMosh::SoftwareMosh() {
+    setNumThreads(0);
+}
+
+SoftwareMosh::~SoftwareMosh() {
+    stopWorkers();
+}
+
+void SoftwareMosh::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto & worker : workers) worker.join();
+    workers.clear();
+    quit = false;
+}
+
+void SoftwareMosh::setNumThreads(int count) {
+    if (count <= 0) count = std::max(1, (int)std::thread::hardware_concurrency());
+    if (count == getNumThreads()) return;
+    stopWorkers();
+    // The calling thread renders tiles as well
+    for (int i = 1; i < count; i++) workers.emplace_back(&SoftwareMosh::workerLoop, this);
+}
+
+void SoftwareMosh::workerLoop() {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        runTiles();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        done.notify_one();
+    }
+}
+
+void SoftwareMosh::runTiles() {
+    int tile;
+    while ((tile = nextTile.fetch_add(1, std::memory_order_relaxed)) < numTiles) {
+        int y0 = tile * TILE_ROWS;
+        renderRows(y0, std::min(y0 + TILE_ROWS, targetHeight));
+    }
+}
+
+void SoftwareMosh::render(const Frame & frame, uint8_t * out, int width, int height, int stride) {
+    if (!out || width <= 0 || height <= 0 || !frame.tex0.image.data) return;
+    job = &frame;
+    target = out;
+    targetWidth = width;
+    targetHeight = height;
+    targetStride = stride ? stride : width * 4;
+    numTiles = (height + TILE_ROWS - 1) / TILE_ROWS;
+    nextTile = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busyWorkers = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    runTiles();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busyWorkers == 0; });
+}
+
+void SoftwareMosh::renderRows(int rowBegin, int rowEnd) {
+    const Frame & frame = *job;
+    const ReactiveUniforms & p = frame.uniforms;
+    const float time = p.time;
+    const float resX = std::max(p.res[0], 1.0f);
+    const float resY = std::max(p.res[1], 1.0f);
+    const float w = (float)targetWidth;
+    const float h = (float)targetHeight;
+
+    // Everything that only depends on uniforms
+    const float shiverFactor = smoothstepLane(p.lowThresh, p.lowThresh + 0.1f, p.mids);
+    const float shiftFactor = smoothstepLane(p.highThresh, p.highThresh + 0.1f, p.mids);
+    const float burst = smoothstepLane(0.05f, 0.4f, p.impactDelta);
+    const float midActive = shiverFactor * (0.5f + burst * 0.5f);
+    const float warpIntensity = 0.05f + p.subBass * 0.15f;
+    const float rotAmt = time * 0.1f + p.mids * 2.2f + p.impactDelta * 5.0f;
+    const float rotCos = std::cos(rotAmt);
+    const float rotSin = std::sin(rotAmt);
+    const float moshTime = std::floor(time * 8.0f) / 8.0f;
+    const float freq = 3.0f + p.mids * 7.0f;
+    const float intensity = smoothstepLane(p.lowThresh, p.highThresh, p.mids);
+    const float lineThickness = mixLane(0.12f, 0.5f, intensity * (0.5f + burst * 0.5f)) + p.subBass * 0.1f;
+    const float moshDist = (100.0f + burst * 150.0f) * intensity;
+    const float blockSize = mixLane(1.0f, 20.0f, intensity * (1.1f - p.treble));
+    const float totalShift = p.rgbShift + p.impactDelta * 80.0f + p.subBass * 4.0f;
+    const float jitterTime = std::floor(time * 20.0f);
+    const float shiftTime = std::floor(time * 15.0f);
+
+    // Render target pixel -> quad texcoord (the quad is drawn centred at w x h, scaled, jittered)
+    const float scale = std::max(std::fabs(frame.view.scale), 1e-6f);
+    const float texPerPixelX = resX / (w * scale);
+
+    float srcX[L], uvX[L], px[L], py[L], r[L], a[L], d[L], d2[L], keep[L];
+    float finalX[L], finalY[L], shape[L];
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        uint8_t * row = target + (size_t)y * targetStride;
+
+        // --- PER ROW ---
+        // The view has no rotation, so texcoord y, the slice and both row hashes are per row
+        float srcY = ((y + 0.5f - h * 0.5f - frame.view.offsetY) / scale + h * 0.5f) * resY / h;
+        bool rowInside = srcY >= 0.0f && srcY <= resY;
+        float sliceOffset = 0.0f;
+        if (p.numSlices > 0) {
+            int slice = std::min(std::max((int)(srcY / resY * (float)p.numSlices), 0), p.numSlices - 1);
+            sliceOffset = p.sliceOffsets[slice];
+        }
+        float rowShift = (hashLane(std::floor(srcY / (resY / 12.0f)), jitterTime) - 0.5f) * p.mids * 2.8f * shiverFactor;
+        float shiftSeed = hashLane(std::floor(srcY / (resY / 6.0f)), shiftTime);
+        if (shiftSeed > 0.7f) rowShift += (shiftSeed - 0.5f) * p.mids * 15.0f * shiftFactor;
+        float wave = std::sin(srcY * 0.005f + time) * p.subBass * 4.0f; // Only moves uv.x, after the mosh
+        float scanline = std::sin(srcY * 2.0f) * 0.05f;
+        float quadX0 = (0.0f - w * 0.5f) * scale + w * 0.5f + frame.view.offsetX;
+
+        for (int x0 = 0; x0 < targetWidth; x0 += L) {
+            // --- SLICING, SHIVER, BLOCK SHIFT ---
+            for (int i = 0; i < L; i++) {
+                float quadX = (x0 + i + 0.5f - quadX0) * texPerPixelX;
+                float sx = quadX - sliceOffset;
+                keep[i] = (rowInside && quadX >= 0.0f && quadX <= resX && sx >= 0.0f && sx <= resX) ? 1.0f : 0.0f;
+                srcX[i] = sx;
+                uvX[i] = sx + rowShift;
+            }
+
+            // --- DOMAIN WARP & ROTATION ---
+            for (int i = 0; i < L; i++) {
+                float qx = (srcX[i] - resX * 0.5f) / resY;
+                float qy = (srcY - resY * 0.5f) / resY;
+                qx += sinLane(qy * 2.2f + time * 0.3f) * warpIntensity;
+                qy += cosLane(qx * 2.8f + time * 0.3f) * warpIntensity;
+                px[i] = rotCos * qx + rotSin * qy;
+                py[i] = -rotSin * qx + rotCos * qy;
+                r[i] = sqrtLane(px[i] * px[i] + py[i] * py[i]);
+                a[i] = atan2Lane(py[i], px[i]);
+            }
+
+            // --- STYLE ---
+            stylePattern(frame.styleA, px, py, r, a, freq, time, d);
+            if (frame.styleB >= 0) {
+                stylePattern(frame.styleB, px, py, r, a, freq, time, d2);
+                for (int i = 0; i < L; i++) d[i] = mixLane(d[i], d2[i], frame.styleMix);
+            }
+
+            // --- MOSH DISPLACEMENT ---
+            for (int i = 0; i < L; i++) {
+                float dd = d[i] + hashLane(px[i] * moshTime, py[i] * moshTime) * p.treble * 0.2f;
+                float mask = smoothstepLane(2.2f, 0.3f, r[i]);
+                float s = smoothstepLane(lineThickness, lineThickness - 0.08f, dd) * mask * midActive;
+                float angle = a[i] + dd;
+                float tx = floorLane((uvX[i] + cosLane(angle) * moshDist) / blockSize) * blockSize;
+                float ty = floorLane((srcY + sinLane(angle) * moshDist) / blockSize) * blockSize;
+                float moshX = clampLane(mixLane(uvX[i], tx, s), 0.1f, resX - 0.1f);
+                float moshY = clampLane(mixLane(srcY, ty, s), 0.1f, resY - 0.1f);
+                finalX[i] = mixLane(uvX[i] + wave, moshX, s);
+                finalY[i] = mixLane(srcY, moshY, s);
+                shape[i] = s;
+            }
+
+            // --- RGB SEPARATION, INVERT, SCANLINES ---
+            int count = std::min(L, targetWidth - x0);
+            uint8_t * pixel = row + x0 * 4;
+            for (int i = 0; i < count; i++, pixel += 4) {
+                if (keep[i] == 0.0f) {
+                    pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+                    continue;
+                }
+                float rgb[3] = {
+                    sampleClip(frame, finalX[i] + totalShift, finalY[i], 0),
+                    sampleClip(frame, finalX[i], finalY[i], 1),
+                    sampleClip(frame, finalX[i] - totalShift, finalY[i], 2)
+                };
+                for (int l = 0; l < ReactiveUniforms::MAX_OVERLAYS; l++) {
+                    if (p.layerOpacity[l] > 0.0f && frame.layers[l].image.data)
+                        blendLayer(frame, l, uvX[i] + wave, srcY, finalX[i], finalY[i], totalShift, rgb);
+                }
+                for (int c = 0; c < 3; c++) {
+                    float v = rgb[c];
+                    if (p.invertToggle != 0) {
+                        v = 1.0f - v;
+                        v = mixLane(v, std::fabs(0.2f - v), shape[i] * 0.4f);
+                    }
+                    v -= scanline;
+                    pixel[c] = (uint8_t)(clampLane(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+                pixel[3] = 255;
+            }
+        }
+    }
+}
+
+// --- COMPARISON ---
+
+SoftwareMosh::Diff SoftwareMosh::compare(const uint8_t * a, const uint8_t * b, int width, int height, int tolerance, int strideA, int strideB) {
+    Diff diff;
+    if (!a || !b || width <= 0 || height <= 0) return diff;
+    if (!strideA) strideA = width * 4;
+    if (!strideB) strideB = width * 4;
+
+    uint64_t total = 0;
+    uint64_t over = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t * rowA = a + (size_t)y * strideA;
+        const uint8_t * rowB = b + (size_t)y * strideB;
+        for (int x = 0; x < width; x++) {
+            int worst = 0;
+            for (int c = 0; c < 3; c++) {
+                int e = std::abs((int)rowA[x * 4 + c] - (int)rowB[x * 4 + c]);
+                total += e;
+                worst = std::max(worst, e);
+            }
+            diff.maxError = std::max(diff.maxError, worst);
+            if (worst > tolerance) over++;
+        }
+    }
+    double pixels = (double)width * height;
+    diff.meanError = total / (pixels * 3.0);
+    diff.overTolerance = over / pixels;
+    return diff;
+}
+
+const char * SoftwareMosh::getKernelName() {
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#elif defined(__AVX__)
+    return "AVX";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "SSE2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
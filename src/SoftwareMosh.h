@@ -0,0 +1,100 @@
+#pragma once
+#include "ReactiveUniforms.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CPU port of shader.frag: slice shiver, block shift, domain warp, the eight mosh styles,
+// block-quantized displacement, RGB separation, the overlay layer blends, invert and the
+// internal scanlines, plus the scene quad transform (zoom / jitter) ofApp applies around it.
+// Pixels are processed LANES at a time with branch-free polynomial math, written so the
+// compiler turns every lane loop into SIMD; texture fetches are bilinear with clamp to edge
+// like the GL_LINEAR rectangle textures. Rows are tiled across a persistent thread pool.
+// The reference for image-diff tests against the GPU (--verify-cpu, softwareMoshBench); not
+// a render path of its own, the app always draws with GL.
+// No openFrameworks dependency.
+class SoftwareMosh {
+public:
+	static const int LANES = 8;
+
+	// 8 bit image plane, rows top first
+	struct Plane {
+		const uint8_t * data = nullptr;
+		int width = 0;
+		int height = 0;
+		int channels = 4;
+		int stride = 0; // Bytes per row, 0 = width * channels
+	};
+
+	// A clip frame: packed RGB(A), or NV12 with Y in image and interleaved UV at half size
+	struct Source {
+		Plane image;
+		Plane chroma;
+		bool yuv = false;
+	};
+
+	// Where the video quad lands on the render target, as ofApp draws it:
+	// centred, scaled by zoom * bounce and translated by the jitter
+	struct View {
+		float scale = 1.0f;
+		float offsetX = 0.0f;
+		float offsetY = 0.0f;
+	};
+
+	struct Frame {
+		ReactiveUniforms uniforms;
+		int styleA = 0;
+		int styleB = -1; // >= 0 blends styleA -> styleB by styleMix (ShaderCache transition programs)
+		float styleMix = 0.0f;
+		Source tex0;
+		Source tex1; // Incoming clip, used while uniforms.crossfade > 0
+		Source layers[ReactiveUniforms::MAX_OVERLAYS]; // Overlay clips, used where uniforms.layerOpacity > 0
+		View view;
+	};
+
+	// Per-image comparison, RGB only (alpha is 0 or 255 on both sides)
+	struct Diff {
+		double meanError = 0.0; // Mean absolute channel difference, 0..255
+		int maxError = 0;
+		double overTolerance = 0.0; // Fraction of pixels with any channel above the tolerance
+	};
+
+	SoftwareMosh();
+	~SoftwareMosh();
+
+	void setNumThreads(int count); // 0 = one per hardware thread
+	int getNumThreads() const { return (int)workers.size() + 1; }
+
+	// Renders into RGBA8, top row first. Pixels outside the quad or discarded by the slicing
+	// are transparent black, like the cleared scene buffer.
+	void render(const Frame & frame, uint8_t * out, int width, int height, int stride = 0);
+
+	static Diff compare(const uint8_t * a, const uint8_t * b, int width, int height, int tolerance, int strideA = 0, int strideB = 0);
+	static const char * getKernelName(); // Vector ISA the lane loops were compiled for
+
+private:
+	void renderRows(int y0, int y1);
+	void runTiles();
+	void workerLoop();
+	void stopWorkers();
+
+	// Current job, written by render() before the workers are woken
+	const Frame * job = nullptr;
+	uint8_t * target = nullptr;
+	int targetWidth = 0;
+	int targetHeight = 0;
+	int targetStride = 0;
+	std::atomic<int> nextTile { 0 };
+	int numTiles = 0;
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation = 0;
+	int busyWorkers = 0;
+	bool quit = false;
+};
@@ -0,0 +1,50 @@
+#include "SpectrogramTexture.h"
+#include <chrono>
+
+void SpectrogramTexture::setup(int numBins, int numRows) {
+    bins = std::max(0, numBins);
+    rows = std::max(1, numRows);
+    head = -1;
+    staging.assign((size_t)bins * rows, 0.0f);
+    latest.assign(bins, 0.0f);
+    if (bins == 0) {
+        texture.clear();
+        return;
+    }
+
+    // Not a rectangle texture: normalized coordinates are what GL_REPEAT wraps the ring with
+    texture.allocate(bins, rows, GL_R32F, false);
+    texture.setTextureMinMagFilter(GL_LINEAR, GL_LINEAR);
+    texture.setTextureWrap(GL_CLAMP_TO_EDGE, GL_REPEAT);
+    texture.loadData(staging.data(), bins, rows, GL_RED); // Silence until the first rows arrive
+}
+
+int SpectrogramTexture::update(AudioAnalyzer & analyzer) {
+    if (bins == 0 || analyzer.getSpectrumRowSize() != bins) return 0;
+    auto start = std::chrono::steady_clock::now();
+
+    int total = 0;
+    size_t count;
+    while ((count = analyzer.popSpectrumRows(staging.data(), rows)) > 0) {
+        // Contiguous rows in one call, split where the ring wraps
+        int first = (head + 1) % rows;
+        int run = std::min((int)count, rows - first);
+        upload(staging.data(), first, run);
+        if (run < (int)count) upload(staging.data() + (size_t)run * bins, 0, (int)count - run);
+        head = (head + (int)count) % rows;
+        total += (int)count;
+
+        const float * newest = staging.data() + (count - 1) * bins;
+        std::copy(newest, newest + bins, latest.begin());
+    }
+
+    uploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+void SpectrogramTexture::upload(const float * data, int firstRow, int count) {
+    const ofTextureData & texData = texture.getTextureData();
+    glBindTexture(texData.textureTarget, texData.textureID);
+    glTexSubImage2D(texData.textureTarget, 0, 0, firstRow, bins, count, GL_RED, GL_FLOAT, data);
+    glBindTexture(texData.textureTarget, 0);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "ofMain.h"
+#include "AudioAnalyzer.h"
+
+// Spectrum history on the GPU: a float texture, one column per spectrum bin and one row per
+// analysis hop, used as a ring. update() drains the analyzer's new rows and writes them
+// below the previous ones with glTexSubImage2D (at most two calls, when the rows wrap), so a
+// frame costs the few hops since the last one, never a full upload. getHead() is the row
+// written last; shaders read age a at row head - a and let GL_REPEAT do the wrap.
+// Render thread only, allocates in setup() and never after.
+class SpectrogramTexture {
+public:
+	void setup(int bins, int rows = 256);
+	// Upload the rows published since the last call. Returns the number of new rows.
+	int update(AudioAnalyzer & analyzer);
+
+	bool isAllocated() const { return bins > 0; }
+	ofTexture & getTexture() { return texture; } // GL_TEXTURE_2D, GL_R32F, normalized coordinates
+	int getBins() const { return bins; }
+	int getRows() const { return rows; }
+	int getHead() const { return head; }
+	const float * getLatestRow() const { return latest.data(); } // bins values, zeros until the first row
+	float getUploadMs() const { return uploadMs; }
+
+private:
+	void upload(const float * data, int firstRow, int count);
+
+	ofTexture texture;
+	int bins = 0;
+	int rows = 0;
+	int head = -1; // Row written last, -1 before any
+	vector<float> staging; // Rows drained in one go
+	vector<float> latest;
+	float uploadMs = 0.0f;
+};
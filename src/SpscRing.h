@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Wait-free single-producer / single-consumer ring buffer.
+// Exactly one thread may push and exactly one other thread may pop. The storage is
+// allocated up front (allocate() is not thread-safe), so push/pop never touch the heap
+// and are safe to call from the realtime audio callback.
+template <typename T>
+class SpscRing {
+public:
+	SpscRing() = default;
+	explicit SpscRing(size_t minCapacity) { allocate(minCapacity); }
+
+	// Capacity is rounded up to a power of two. Call before either thread starts.
+	void allocate(size_t minCapacity) {
+		size_t cap = 1;
+		while (cap < minCapacity) cap <<= 1;
+		buffer.assign(cap, T());
+		mask = cap - 1;
+		head.store(0, std::memory_order_relaxed);
+		tail.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const { return buffer.size(); }
+
+	// Producer side
+	size_t writeAvailable() const {
+		return buffer.size() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+	}
+
+	bool push(const T & value) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) >= buffer.size()) return false;
+		buffer[h & mask] = value;
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Writes as many items as fit and returns how many were written.
+	size_t push(const T * src, size_t count) {
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t space = buffer.size() - (h - tail.load(std::memory_order_acquire));
+		if (count > space) count = space;
+		for (size_t i = 0; i < count; i++) {
+			buffer[(h + i) & mask] = src[i];
+		}
+		head.store(h + count, std::memory_order_release);
+		return count;
+	}
+
+	// Consumer side
+	size_t readAvailable() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+	}
+
+	bool pop(T & out) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (head.load(std::memory_order_acquire) == t) return false;
+		out = buffer[t & mask];
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Oldest item without consuming it
+	bool peek(T & out) const {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (head.load(std::memory_order_acquire) == t) return false;
+		out = buffer[t & mask];
+		return true;
+	}
+
+	// Reads up to count items and returns how many were read.
+	size_t pop(T * dst, size_t count) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t avail = head.load(std::memory_order_acquire) - t;
+		if (count > avail) count = avail;
+		for (size_t i = 0; i < count; i++) {
+			dst[i] = buffer[(t + i) & mask];
+		}
+		tail.store(t + count, std::memory_order_release);
+		return count;
+	}
+
+private:
+	std::vector<T> buffer;
+	size_t mask = 0;
+	// Keep the two indices on separate cache lines so producer and consumer don't false-share
+	alignas(64) std::atomic<size_t> head{0}; // next write position (producer)
+	alignas(64) std::atomic<size_t> tail{0}; // next read position (consumer)
+};
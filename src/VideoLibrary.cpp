@@ -0,0 +1,434 @@
+#include "VideoLibrary.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+static bool isUnder(const string & path, const string & root) {
+    if (path.size() <= root.size() || path.compare(0, root.size(), root) != 0) return false;
+    char last = root.empty() ? '/' : root.back();
+    char next = path[root.size()];
+    return last == '/' || last == '\\' || next == '/' || next == '\\';
+}
+
+VideoLibrary::~VideoLibrary() {
+    stop();
+}
+
+void VideoLibrary::setup(const string & path) {
+    indexPath = path;
+}
+
+bool VideoLibrary::isVideoFile(const string & path) {
+    string ext = ofToLower(std::filesystem::path(path).extension().string());
+    return ext == ".mp4" || ext == ".mov" || ext == ".m4v";
+}
+
+void VideoLibrary::scan(const string & root) {
+    stop();
+    cancel = false;
+    scanning = true;
+    worker = std::thread(&VideoLibrary::scanThread, this, root);
+}
+
+void VideoLibrary::stop() {
+    cancel = true;
+    if (worker.joinable()) worker.join();
+    scanning = false;
+}
+
+int VideoLibrary::getNumClips() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)available.size();
+}
+
+int VideoLibrary::getNumAnalysed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = 0;
+    for (auto & path : available) {
+        auto it = index.find(path);
+        if (it != index.end() && it->second.analysed) count++;
+    }
+    return count;
+}
+
+bool VideoLibrary::getMovieInfo(const string & path, MovieInfo & out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(path);
+    if (found == index.end() || !found->second.keyframesIndexed) return false;
+    out = found->second.movie;
+    return true;
+}
+
+vector<ClipInfo> VideoLibrary::query(const ClipQuery & q) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    vector<ClipInfo> result;
+    for (auto & path : available) {
+        auto it = index.find(path);
+        if (it == index.end()) continue;
+        const ClipInfo & info = it->second;
+        if (info.movie.duration < q.minDuration) continue;
+        if (info.analysed) {
+            if (info.motion < q.minMotion || info.motion > q.maxMotion) continue;
+            if (info.luminance < q.minLuminance || info.luminance > q.maxLuminance) continue;
+        } else if (q.analysedOnly) {
+            continue;
+        }
+        result.push_back(info);
+    }
+    return result;
+}
+
+string VideoLibrary::pick(float targetMotion, const string & avoid, int maxHeight) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (available.empty()) return "";
+
+    // Under load only clips indexed at up to that height count, an unprobed clip could be any
+    // size. None of them = no clip, the caller decides what to play instead.
+    auto fits = [&](const string & path) {
+        if (maxHeight <= 0) return true;
+        auto it = index.find(path);
+        return it != index.end() && it->second.movie.height > 0 && it->second.movie.height <= maxHeight;
+    };
+
+    vector<const string *> fitting;
+    vector<std::pair<float, const string *>> ranked;
+    for (auto & path : available) {
+        if (!fits(path)) continue;
+        fitting.push_back(&path);
+        if (path == avoid) continue;
+        auto it = index.find(path);
+        if (it != index.end() && it->second.analysed) ranked.push_back({ it->second.motion, &path });
+    }
+    if (fitting.empty()) return "";
+
+    // Not enough features yet, any clip will do
+    if (ranked.size() < 8) {
+        const string * path = nullptr;
+        for (int tries = 0; tries < 8; tries++) {
+            path = fitting[(size_t)ofClamp(floor(ofRandom(fitting.size())), 0, fitting.size() - 1)];
+            if (*path != avoid) break;
+        }
+        return *path;
+    }
+
+    // Choose among the clips ranked around the target, by rank so it adapts to any library
+    std::sort(ranked.begin(), ranked.end());
+    int n = (int)ranked.size();
+    int centre = (int)roundf(ofClamp(targetMotion, 0.0f, 1.0f) * (n - 1));
+    int half = std::max(2, n / 10);
+    int lo = std::max(0, centre - half);
+    int hi = std::min(n - 1, centre + half);
+    int idx = (int)ofClamp(lo + floor(ofRandom(hi - lo + 1)), lo, hi);
+    return *ranked[idx].second;
+}
+
+void VideoLibrary::scanThread(string root) {
+    if (!indexLoaded) {
+        loadIndex();
+        indexLoaded = true;
+    }
+
+    // Publish what the index already knows so playback can start right away
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        available.clear();
+        for (auto & entry : index) {
+            if (isUnder(entry.first, root)) available.push_back(entry.first);
+        }
+    }
+
+    // --- WALK ---
+    // Only new or changed files (path + mtime + size) get probed
+    vector<string> found;
+    int probed = 0;
+    std::error_code ec;
+    auto options = std::filesystem::directory_options::skip_permission_denied;
+    std::filesystem::recursive_directory_iterator it(root, options, ec), end;
+    for (; !ec && it != end && !cancel; it.increment(ec)) {
+        std::error_code fileEc;
+        if (!it->is_regular_file(fileEc)) continue;
+        string path = it->path().string();
+        if (!isVideoFile(path)) continue;
+
+        uint64_t size = it->file_size(fileEc);
+        int64_t mtime = (int64_t)it->last_write_time(fileEc).time_since_epoch().count();
+        if (fileEc) continue;
+        found.push_back(path);
+
+        ClipInfo info;
+        bool known = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = index.find(path);
+            if (entry != index.end() && entry->second.size == size && entry->second.mtime == mtime) {
+                if (entry->second.keyframesIndexed) continue;
+                info = entry->second; // Indexed before keyframes were, keep the content features
+                known = true;
+            }
+        }
+
+        if (known) {
+            MovieInfo movie;
+            if (MovieProbe::probe(path, movie)) info.movie = movie;
+        } else {
+            info.path = path;
+            info.size = size;
+            info.mtime = mtime;
+            MovieProbe::probe(path, info.movie); // Unknown containers keep zeros
+        }
+        info.keyframesIndexed = true;
+
+        // Playable as soon as it is indexed, a first scan does not wait for the whole walk.
+        // Everything the index held is already published, only new clips are added.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!index.count(path)) available.push_back(path);
+        index[path] = info;
+        probed++;
+    }
+    if (cancel) return;
+
+    // Forget clips that vanished from this root, the walk's list replaces the published one
+    {
+        std::unordered_set<string> present(found.begin(), found.end());
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto entry = index.begin(); entry != index.end();) {
+            if (isUnder(entry->first, root) && !present.count(entry->first)) entry = index.erase(entry);
+            else ++entry;
+        }
+        available = found;
+    }
+    saveIndex();
+    ofLogNotice() << "LIBRARY: " << found.size() << " clips, " << probed << " new or changed";
+
+    // --- CONTENT FEATURES ---
+    int sinceSave = 0;
+    for (auto & path : found) {
+        if (cancel) break;
+
+        ClipInfo info;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = index.find(path);
+            if (entry == index.end() || entry->second.analysed) continue;
+            info = entry->second;
+        }
+        if (!analyse(info)) continue; // Retried on the next scan
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            index[path] = info;
+        }
+        if (++sinceSave >= 25) {
+            saveIndex();
+            sinceSave = 0;
+        }
+    }
+    if (sinceSave > 0) saveIndex();
+    scanning = false;
+}
+
+bool VideoLibrary::analyse(ClipInfo & info) {
+    ofVideoPlayer player;
+    player.setUseTexture(false); // Pixels only, no GL on this thread
+    if (!player.load(info.path)) return false;
+    player.setVolume(0);
+    player.play();
+    player.setPaused(true);
+
+    auto grabFrame = [&](float position) {
+        player.setPosition(position);
+        for (int tries = 0; tries < 50 && !cancel; tries++) {
+            player.update();
+            if (player.isFrameNew()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+        return false;
+    };
+
+    // A coarse grid is plenty for averages
+    const int gridW = 32;
+    const int gridH = 18;
+    const int numSamples = 6;
+    vector<float> first(gridW * gridH), second(gridW * gridH);
+    float hueBins[12] = {};
+    double lumSum = 0.0;
+    double motionSum = 0.0;
+    int frames = 0;
+    int pairs = 0;
+
+    auto sampleFrame = [&](vector<float> & luma, bool collectHue) {
+        const ofPixels & pixels = player.getPixels();
+        int w = (int)pixels.getWidth();
+        int h = (int)pixels.getHeight();
+        int channels = (int)pixels.getNumChannels();
+        const unsigned char * data = pixels.getData();
+        if (!data || w <= 0 || h <= 0) return false;
+
+        for (int gy = 0; gy < gridH; gy++) {
+            for (int gx = 0; gx < gridW; gx++) {
+                int x = (gx * 2 + 1) * w / (gridW * 2);
+                int y = (gy * 2 + 1) * h / (gridH * 2);
+                const unsigned char * p = data + ((size_t)y * w + x) * channels;
+                float r = p[0] / 255.0f;
+                float g = channels >= 3 ? p[1] / 255.0f : r;
+                float b = channels >= 3 ? p[2] / 255.0f : r;
+                float l = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+                luma[gy * gridW + gx] = l;
+                lumSum += l;
+
+                if (collectHue) {
+                    float maxC = std::max(r, std::max(g, b));
+                    float minC = std::min(r, std::min(g, b));
+                    float chroma = maxC - minC;
+                    if (chroma > 0.05f) {
+                        float hue;
+                        if (maxC == r) hue = fmodf((g - b) / chroma + 6.0f, 6.0f);
+                        else if (maxC == g) hue = (b - r) / chroma + 2.0f;
+                        else hue = (r - g) / chroma + 4.0f;
+                        hueBins[(int)(hue * 2.0f) % 12] += chroma; // Saturated pixels count more
+                    }
+                }
+            }
+        }
+        frames++;
+        return true;
+    };
+
+    // Pairs of frames ~0.2s apart at evenly spread positions
+    float step = info.movie.duration > 0.0f ? 0.2f / info.movie.duration : 0.01f;
+    for (int s = 0; s < numSamples && !cancel; s++) {
+        float position = (s + 0.5f) / numSamples;
+        if (!grabFrame(position) || !sampleFrame(first, true)) continue;
+        if (!grabFrame(std::min(position + step, 0.999f)) || !sampleFrame(second, false)) continue;
+
+        double diff = 0.0;
+        for (size_t i = 0; i < first.size(); i++) diff += fabsf(first[i] - second[i]);
+        motionSum += diff / first.size();
+        pairs++;
+    }
+
+    // Fill in what the container probe missed (non-ISO files)
+    if (info.movie.duration <= 0.0f) info.movie.duration = player.getDuration();
+    if (info.movie.width <= 0) {
+        info.movie.width = (int)player.getWidth();
+        info.movie.height = (int)player.getHeight();
+    }
+    if (info.movie.fps <= 0.0f && info.movie.duration > 0.0f) {
+        info.movie.fps = player.getTotalNumFrames() / info.movie.duration;
+    }
+    player.close();
+
+    if (frames == 0 || cancel) return false;
+
+    int dominant = 0;
+    for (int i = 1; i < 12; i++) {
+        if (hueBins[i] > hueBins[dominant]) dominant = i;
+    }
+
+    info.luminance = (float)(lumSum / ((double)frames * gridW * gridH));
+    info.motion = pairs > 0 ? (float)(motionSum / pairs) : 0.0f;
+    info.hue = (dominant + 0.5f) / 12.0f;
+    info.analysed = true;
+    return true;
+}
+
+// --- INDEX FILE ---
+// One tab separated line per clip:
+// path size mtime duration width height fps codec analysed luminance motion hue keyframes
+// keyframes is "frameCount:k0,k1,...", "frameCount:*" when every frame is one (v2, absent in v1)
+
+static string formatKeyframes(const MovieInfo & movie) {
+    string out = ofToString(movie.frameCount) + ":";
+    if (movie.keyframes.empty()) return out + "*";
+    for (size_t i = 0; i < movie.keyframes.size(); i++) {
+        if (i > 0) out += ',';
+        out += ofToString(movie.keyframes[i]);
+    }
+    return out;
+}
+
+static void parseKeyframes(const string & field, MovieInfo & movie) {
+    size_t colon = field.find(':');
+    if (colon == string::npos) return;
+    movie.frameCount = atoi(field.c_str());
+    movie.keyframes.clear();
+    const char * p = field.c_str() + colon + 1;
+    if (*p == '*') return;
+    while (*p) {
+        char * end = nullptr;
+        unsigned long frame = strtoul(p, &end, 10);
+        if (end == p) break;
+        movie.keyframes.push_back((uint32_t)frame);
+        p = (*end == ',') ? end + 1 : end;
+    }
+}
+
+bool VideoLibrary::loadIndex() {
+    std::ifstream in(indexPath);
+    if (!in) return false;
+
+    std::unordered_map<string, ClipInfo> loaded;
+    string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        vector<string> fields;
+        std::stringstream stream(line);
+        string field;
+        while (std::getline(stream, field, '\t')) fields.push_back(field);
+        if (fields.size() != 12 && fields.size() != 13) continue;
+
+        ClipInfo info;
+        info.path = fields[0];
+        info.size = strtoull(fields[1].c_str(), nullptr, 10);
+        info.mtime = strtoll(fields[2].c_str(), nullptr, 10);
+        info.movie.duration = strtof(fields[3].c_str(), nullptr);
+        info.movie.width = atoi(fields[4].c_str());
+        info.movie.height = atoi(fields[5].c_str());
+        info.movie.fps = strtof(fields[6].c_str(), nullptr);
+        info.movie.codec = fields[7];
+        info.analysed = fields[8] == "1";
+        info.luminance = strtof(fields[9].c_str(), nullptr);
+        info.motion = strtof(fields[10].c_str(), nullptr);
+        info.hue = strtof(fields[11].c_str(), nullptr);
+        if (fields.size() == 13) {
+            parseKeyframes(fields[12], info.movie);
+            info.keyframesIndexed = true;
+        }
+        loaded[info.path] = info;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    index.swap(loaded);
+    return true;
+}
+
+bool VideoLibrary::saveIndex() {
+    std::ostringstream out;
+    out << "# cognitoni video index v2\n";
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto & entry : index) {
+            const ClipInfo & info = entry.second;
+            if (info.path.find_first_of("\t\n") != string::npos) continue;
+            out << info.path << '\t' << info.size << '\t' << info.mtime << '\t'
+                << info.movie.duration << '\t' << info.movie.width << '\t' << info.movie.height << '\t'
+                << info.movie.fps << '\t' << (info.movie.codec.empty() ? "-" : info.movie.codec) << '\t'
+                << (info.analysed ? 1 : 0) << '\t' << info.luminance << '\t' << info.motion << '\t' << info.hue << '\t'
+                << formatKeyframes(info.movie) << '\n';
+        }
+    }
+
+    // Write aside and swap in, so a crash never leaves half an index
+    string tempPath = indexPath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::trunc);
+        if (!file) return false;
+        file << out.str();
+        if (!file) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, indexPath, ec);
+    return !ec;
+}
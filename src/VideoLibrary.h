@@ -0,0 +1,75 @@
+#pragma once
+#include "ofMain.h"
+#include "MovieProbe.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// One indexed clip
+struct ClipInfo {
+	string path;
+	uint64_t size = 0;
+	int64_t mtime = 0;
+	MovieInfo movie;
+	bool keyframesIndexed = false; // movie.frameCount / keyframes come from a probe that reads stss
+	bool analysed = false; // Content features below are valid
+	float luminance = 0.0f; // Mean 0..1
+	float motion = 0.0f; // Mean absolute frame difference 0..1
+	float hue = 0.0f; // Dominant hue 0..1, saturation weighted
+};
+
+// Optional filters for query(), unset bounds are ignored
+struct ClipQuery {
+	float minMotion = 0.0f;
+	float maxMotion = 1.0f;
+	float minLuminance = 0.0f;
+	float maxLuminance = 1.0f;
+	float minDuration = 0.0f;
+	bool analysedOnly = false;
+};
+
+// Background video library indexer.
+// A worker thread walks the folder recursively, probes new or changed files (keyed by
+// path + mtime + size) from their container header, then samples a few frames of each clip
+// for luminance, motion and hue. Everything is persisted to an index file, so a rescan of a
+// known library only touches what changed and clips are available as soon as it starts.
+// New clips become available one by one as they are probed, even on the very first scan.
+class VideoLibrary {
+public:
+	~VideoLibrary();
+
+	void setup(const string & indexPath);
+	void scan(const string & root); // Restarts any running scan
+	void stop();
+
+	bool isScanning() const { return scanning; }
+	int getNumClips() const;
+	int getNumAnalysed() const;
+
+	vector<ClipInfo> query(const ClipQuery & q) const;
+	bool getMovieInfo(const string & path, MovieInfo & out) const; // Indexed header facts incl. keyframes
+	// Random clip whose motion rank is close to targetMotion (0 calm .. 1 busy), never avoid
+	// unless it is the only one. Falls back to uniform choice until enough clips are analysed.
+	// maxHeight > 0 only picks indexed clips up to that height, empty when there are none.
+	string pick(float targetMotion, const string & avoid, int maxHeight = 0) const;
+
+	static bool isVideoFile(const string & path);
+
+private:
+	void scanThread(string root);
+	bool loadIndex();
+	bool saveIndex();
+	bool analyse(ClipInfo & info);
+
+	string indexPath;
+	bool indexLoaded = false;
+
+	mutable std::mutex mutex; // Guards index and available
+	std::unordered_map<string, ClipInfo> index; // Every clip ever seen, all roots
+	vector<string> available; // Clips under the current root
+
+	std::thread worker;
+	std::atomic<bool> scanning { false };
+	std::atomic<bool> cancel { false };
+};
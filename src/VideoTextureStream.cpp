@@ -0,0 +1,174 @@
+#include "VideoTextureStream.h"
+#include <chrono>
+
+// --- TEXTURE POOL ---
+
+ofTexture * TexturePool::acquire(int width, int height, int glInternalFormat) {
+    for (auto & entry : entries) {
+        if (!entry.inUse && entry.width == width && entry.height == height && entry.glInternalFormat == glInternalFormat) {
+            entry.inUse = true;
+            return entry.texture.get();
+        }
+    }
+
+    Entry entry;
+    entry.texture = make_unique<ofTexture>();
+    entry.texture->allocate(width, height, glInternalFormat);
+    entry.width = width;
+    entry.height = height;
+    entry.glInternalFormat = glInternalFormat;
+    entry.inUse = true;
+    entries.push_back(std::move(entry));
+    ofLogNotice() << "TEXTURE POOL: allocated " << width << "x" << height << " (" << entries.size() << " textures)";
+    return entries.back().texture.get();
+}
+
+void TexturePool::release(ofTexture * texture) {
+    for (auto & entry : entries) {
+        if (entry.texture.get() != texture) continue;
+        entry.inUse = false;
+        entry.released = ++releases;
+        evict(entry.glInternalFormat);
+        return;
+    }
+}
+
+size_t TexturePool::getBytes() const {
+    size_t bytes = 0;
+    for (auto & entry : entries) {
+        size_t channels = entry.glInternalFormat == GL_R8 ? 1 : entry.glInternalFormat == GL_RG8 ? 2 : entry.glInternalFormat == GL_RGB8 ? 3 : 4;
+        bytes += (size_t)entry.width * entry.height * channels;
+    }
+    return bytes;
+}
+
+void TexturePool::evict(int glInternalFormat) {
+    // Free the unused textures of this format past the most recent few
+    while (true) {
+        int unused = 0;
+        int oldest = -1;
+        for (int i = 0; i < (int)entries.size(); i++) {
+            const Entry & entry = entries[i];
+            if (entry.inUse || entry.glInternalFormat != glInternalFormat) continue;
+            unused++;
+            if (oldest < 0 || entry.released < entries[oldest].released) oldest = i;
+        }
+        if (unused <= KEEP_PER_FORMAT) return;
+        ofLogNotice() << "TEXTURE POOL: freed " << entries[oldest].width << "x" << entries[oldest].height << " (" << entries.size() - 1 << " textures)";
+        entries.erase(entries.begin() + oldest);
+    }
+}
+
+// --- STREAM ---
+
+void VideoTextureStream::setup(TexturePool * texturePool, int numBuffers) {
+    pool = texturePool;
+    pbos.resize(std::max(1, numBuffers));
+    pboSize = 0;
+    writeIndex = 0;
+}
+
+int VideoTextureStream::getInternalFormat(int channels) {
+    switch (channels) {
+        case 1: return GL_R8;
+        case 2: return GL_RG8;
+        case 3: return GL_RGB8;
+        default: return GL_RGBA8;
+    }
+}
+
+void VideoTextureStream::release() {
+    for (auto & plane : planes) {
+        if (plane && pool) pool->release(plane);
+        plane = nullptr;
+    }
+}
+
+bool VideoTextureStream::update(ofVideoPlayer & player) {
+    if (!player.isFrameNew()) return false;
+    return update(player.getPixels());
+}
+
+bool VideoTextureStream::update(const ofPixels & pixels) {
+    if (!pool) return false;
+
+    const unsigned char * data = pixels.getData();
+    int width = (int)pixels.getWidth();
+    int height = (int)pixels.getHeight();
+    if (!data || width <= 0 || height <= 0) return false;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Describe the planes as they sit in the pixel buffer
+    Plane layout[2];
+    int numPlanes = 1;
+    ofPixelFormat format = pixels.getPixelFormat();
+    yuv = (format == OF_PIXELS_NV12);
+    if (yuv) {
+        layout[0] = { data, width, height, 1, 0 };
+        layout[1] = { data + (size_t)width * height, width / 2, height / 2, 2, (size_t)width * height };
+        numPlanes = 2;
+    } else {
+        layout[0] = { data, width, height, (int)pixels.getNumChannels(), 0 };
+    }
+    size_t total = 0;
+    for (int i = 0; i < numPlanes; i++) total += (size_t)layout[i].width * layout[i].height * layout[i].channels;
+
+    // Textures come from the pool and are only swapped when the clip's size or format changes
+    for (int i = 0; i < 2; i++) {
+        int internalFormat = i < numPlanes ? getInternalFormat(layout[i].channels) : 0;
+        bool matches = i < numPlanes
+            ? (planes[i] && planeWidth[i] == layout[i].width && planeHeight[i] == layout[i].height && planeFormat[i] == internalFormat)
+            : planes[i] == nullptr;
+        if (matches) continue;
+
+        if (planes[i]) pool->release(planes[i]);
+        planes[i] = (i < numPlanes) ? pool->acquire(layout[i].width, layout[i].height, internalFormat) : nullptr;
+        planeWidth[i] = i < numPlanes ? layout[i].width : 0;
+        planeHeight[i] = i < numPlanes ? layout[i].height : 0;
+        planeFormat[i] = internalFormat;
+    }
+
+    // PBOs only grow, a smaller clip reuses the larger allocation
+    if (total > pboSize) {
+        for (auto & pbo : pbos) pbo.allocate(total, GL_STREAM_DRAW);
+        pboSize = total;
+    }
+
+    // Fill the next buffer in the ring. Invalidating lets the driver hand out fresh storage
+    // instead of waiting for a transfer that still reads the old contents.
+    ofBufferObject & pbo = pbos[writeIndex];
+    writeIndex = (writeIndex + 1) % (int)pbos.size();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo.getId());
+    void * dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, total, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!dst) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    for (int i = 0; i < numPlanes; i++) {
+        memcpy((unsigned char *)dst + layout[i].offset, layout[i].data, (size_t)layout[i].width * layout[i].height * layout[i].channels);
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // With a PBO bound the data pointer is an offset, the call returns before the copy is done
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < numPlanes; i++) {
+        const ofTextureData & texData = planes[i]->getTextureData();
+        GLenum glFormat = GL_RGBA;
+        switch (layout[i].channels) {
+            case 1: glFormat = GL_RED; break;
+            case 2: glFormat = GL_RG; break;
+            case 3: glFormat = GL_RGB; break;
+            default: glFormat = (format == OF_PIXELS_BGRA) ? GL_BGRA : GL_RGBA; break;
+        }
+        glBindTexture(texData.textureTarget, texData.textureID);
+        glTexSubImage2D(texData.textureTarget, 0, 0, 0, layout[i].width, layout[i].height, glFormat, GL_UNSIGNED_BYTE, (const void *)layout[i].offset);
+        glBindTexture(texData.textureTarget, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    bytesPerFrame = total;
+    lastUploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
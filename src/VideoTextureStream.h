@@ -0,0 +1,81 @@
+#pragma once
+#include "ofMain.h"
+
+// Persistent video textures, shared by size and format.
+// Clip switches hand textures back here instead of deleting them, so the next clip with
+// the same resolution reuses the allocation. Only the KEEP_PER_FORMAT most recently released
+// textures of each format stay around unused, older sizes are freed, so a library with many
+// resolutions does not pile up VRAM.
+class TexturePool {
+public:
+	static const int KEEP_PER_FORMAT = 2; // Both slots of a deck
+
+	ofTexture * acquire(int width, int height, int glInternalFormat);
+	void release(ofTexture * texture);
+	int getNumTextures() const { return (int)entries.size(); }
+	size_t getBytes() const; // All textures, in use or not
+
+private:
+	struct Entry {
+		unique_ptr<ofTexture> texture;
+		int width = 0;
+		int height = 0;
+		int glInternalFormat = 0;
+		bool inUse = false;
+		uint64_t released = 0; // Release order, higher = more recent
+	};
+	void evict(int glInternalFormat);
+
+	vector<Entry> entries;
+	uint64_t releases = 0;
+};
+
+// Streams a player's CPU frames to the GPU through a ring of pixel buffer objects.
+// The frame is copied into the next PBO and glTexSubImage2D reads from it, so the driver
+// performs the transfer asynchronously while rendering continues; with three buffers the
+// copy never waits on a transfer still in flight. NV12 players upload a Y and an interleaved
+// UV plane (1.5 bytes per pixel instead of 3) which shader.frag converts to RGB.
+// Render thread only.
+class VideoTextureStream {
+public:
+	void setup(TexturePool * pool, int numBuffers = 3);
+
+	// Upload the player's frame if it has a new one, returns true when it did
+	bool update(ofVideoPlayer & player);
+	bool update(const ofPixels & pixels); // A frame decoded elsewhere (DecodeAhead)
+	void release(); // Return the textures to the pool, keeps the PBOs
+
+	bool isAllocated() const { return planes[0] != nullptr; }
+	bool isYuv() const { return yuv; }
+	ofTexture & getTexture() { return *planes[0]; } // RGB(A), or Y when isYuv()
+	ofTexture & getChromaTexture() { return yuv ? *planes[1] : *planes[0]; } // UV plane at half size
+
+	float getLastUploadMs() const { return lastUploadMs; } // CPU time of the last upload incl. stalls
+	size_t getBytesPerFrame() const { return bytesPerFrame; }
+	size_t getBufferBytes() const { return pboSize * pbos.size(); } // PBOs, kept across release()
+
+private:
+	struct Plane {
+		const unsigned char * data;
+		int width;
+		int height;
+		int channels;
+		size_t offset;
+	};
+
+	static int getInternalFormat(int channels);
+
+	TexturePool * pool = nullptr;
+	ofTexture * planes[2] = {};
+	int planeWidth[2] = {};
+	int planeHeight[2] = {};
+	int planeFormat[2] = {};
+	bool yuv = false;
+
+	vector<ofBufferObject> pbos;
+	size_t pboSize = 0;
+	int writeIndex = 0;
+
+	float lastUploadMs = 0.0f;
+	size_t bytesPerFrame = 0;
+};
@@ -0,0 +1,199 @@
+#include "VirtualAudioInput.h"
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+
+const char * VirtualAudioInput::DEVICE_NAME = "Virtual input (WAV / PCM pipe)";
+
+static uint32_t readLe32(const unsigned char * p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t readLe16(const unsigned char * p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+VirtualAudioInput::~VirtualAudioInput() {
+    close();
+}
+
+bool VirtualAudioInput::open(const string & path, int newBufferSize, int rawSampleRate, int rawChannels) {
+    close();
+    if (!readHeader(path, rawSampleRate, rawChannels)) {
+        close();
+        return false;
+    }
+
+    bufferSize = std::max(newBufferSize, 16);
+    raw.resize((size_t)bufferSize * numChannels * bytesPerSample);
+    buffer.allocate(bufferSize, numChannels);
+    buffer.setSampleRate(sampleRate);
+    framesDelivered = 0;
+
+    ofLogNotice() << "AUDIO: virtual input " << path << ", " << sampleRate << "Hz, " << numChannels
+                  << " ch, " << bytesPerSample * 8 << " bit" << (seekable ? ", looped" : ", streamed");
+    return true;
+}
+
+void VirtualAudioInput::start(ofBaseSoundInput * newListener) {
+    if (!file || running) return;
+    listener = newListener;
+    running = true;
+    thread = std::thread(&VirtualAudioInput::threadedFunction, this);
+}
+
+void VirtualAudioInput::close() {
+    running = false;
+    if (thread.joinable()) thread.join();
+    if (file && file != stdin) fclose(file);
+    file = nullptr;
+}
+
+bool VirtualAudioInput::readHeader(const string & path, int rawSampleRate, int rawChannels) {
+    if (path == "-") {
+        file = stdin;
+        seekable = false;
+    } else {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            ofLogError() << "AUDIO: virtual input " << path << " does not exist";
+            return false;
+        }
+        seekable = S_ISREG(info.st_mode);
+        file = fopen(path.c_str(), "rb");
+    }
+    if (!file) {
+        ofLogError() << "AUDIO: could not open " << path;
+        return false;
+    }
+
+    // Raw PCM unless the name says WAV
+    format = ofIsStringInString(ofToLower(path), ".f32") ? FORMAT_F32 : FORMAT_S16;
+    bytesPerSample = (format == FORMAT_F32) ? 4 : 2;
+    sampleRate = rawSampleRate;
+    numChannels = rawChannels;
+    dataStart = 0;
+    dataSize = 0;
+    dataRead = 0;
+    if (ofToLower(ofFilePath::getFileExt(path)) != "wav") return true;
+
+    unsigned char header[12];
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        ofLogError() << "AUDIO: " << path << " is not a RIFF/WAVE file";
+        return false;
+    }
+
+    // Walk the chunks up to "data" (reading, not seeking, so a WAV stream through a pipe works)
+    bool haveFormat = false;
+    long offset = 12;
+    unsigned char chunk[8];
+    while (fread(chunk, 1, 8, file) == 8) {
+        uint32_t size = readLe32(chunk + 4);
+        offset += 8;
+        if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) break;
+            dataStart = offset;
+            // Streamed WAVs are written before their length is known and say 0 or 0xFFFFFFFF
+            dataSize = (size == 0 || size == 0xFFFFFFFFu) ? 0 : size;
+            return true;
+        }
+
+        // Only fmt is kept, and only its first 40 bytes (WAVE_FORMAT_EXTENSIBLE included).
+        // Everything else is read past, whatever size the chunk claims.
+        uint64_t padded = (uint64_t)size + (size & 1); // Chunks are padded to even sizes
+        unsigned char body[40] = {};
+        uint64_t kept = memcmp(chunk, "fmt ", 4) == 0 ? std::min<uint64_t>(padded, sizeof(body)) : 0;
+        if (fread(body, 1, (size_t)kept, file) != kept || !skip(padded - kept)) break;
+        offset += (long)padded;
+        if (kept == 0 || size < 16) continue;
+
+        int tag = readLe16(&body[0]);
+        if (tag == 0xFFFE && size >= 26) tag = readLe16(&body[24]); // WAVE_FORMAT_EXTENSIBLE subformat
+        numChannels = readLe16(&body[2]);
+        sampleRate = (int)readLe32(&body[4]);
+        int bits = readLe16(&body[14]);
+        if (tag == 3 && bits == 32) format = FORMAT_F32;
+        else if (tag == 1 && bits == 16) format = FORMAT_S16;
+        else if (tag == 1 && bits == 24) format = FORMAT_S24;
+        else if (tag == 1 && bits == 32) format = FORMAT_S32;
+        else {
+            ofLogError() << "AUDIO: " << path << " uses an unsupported sample format (" << tag << ", " << bits << " bit)";
+            return false;
+        }
+        bytesPerSample = bits / 8;
+        haveFormat = numChannels > 0 && sampleRate > 0;
+    }
+
+    ofLogError() << "AUDIO: " << path << " has no usable fmt/data chunks";
+    return false;
+}
+
+bool VirtualAudioInput::skip(uint64_t bytes) {
+    unsigned char scratch[4096];
+    while (bytes > 0) {
+        size_t chunk = (size_t)std::min<uint64_t>(bytes, sizeof(scratch));
+        if (fread(scratch, 1, chunk, file) != chunk) return false;
+        bytes -= chunk;
+    }
+    return true;
+}
+
+size_t VirtualAudioInput::read(float * out, size_t numFrames) {
+    if (!file) return 0;
+    numFrames = std::min(numFrames, (size_t)bufferSize);
+    size_t frameBytes = (size_t)numChannels * bytesPerSample;
+
+    // A WAV ends with its data chunk, trailing LIST / id3 chunks are not samples
+    auto available = [&]() { return dataSize > 0 ? std::min<uint64_t>(numFrames, (dataSize - dataRead) / frameBytes) : (uint64_t)numFrames; };
+    size_t wanted = (size_t)available();
+    if (wanted == 0 && dataSize > 0 && seekable && looping) {
+        fseek(file, dataStart, SEEK_SET);
+        dataRead = 0;
+        wanted = (size_t)available();
+    }
+    size_t got = wanted > 0 ? fread(raw.data(), frameBytes, wanted, file) : 0;
+    if (got == 0 && dataSize == 0 && seekable && looping) {
+        // End of a regular file without a data length: loop
+        fseek(file, dataStart, SEEK_SET);
+        got = fread(raw.data(), frameBytes, numFrames, file);
+    }
+    dataRead += (uint64_t)got * frameBytes;
+
+    size_t count = got * numChannels;
+    const unsigned char * p = raw.data();
+    for (size_t i = 0; i < count; i++, p += bytesPerSample) {
+        switch (format) {
+            case FORMAT_S16: out[i] = (int16_t)readLe16(p) / 32768.0f; break;
+            case FORMAT_S24: out[i] = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) / 2147483648.0f; break;
+            case FORMAT_S32: out[i] = (int32_t)readLe32(p) / 2147483648.0f; break;
+            case FORMAT_F32: {
+                uint32_t bits = readLe32(p);
+                memcpy(&out[i], &bits, 4);
+                break;
+            }
+        }
+    }
+    std::fill(out + count, out + numFrames * numChannels, 0.0f);
+    return got;
+}
+
+void VirtualAudioInput::threadedFunction() {
+    using namespace std::chrono;
+    const auto period = duration_cast<steady_clock::duration>(duration<double>((double)bufferSize / sampleRate));
+    auto next = steady_clock::now();
+
+    while (running) {
+        size_t got = read(buffer.getBuffer().data(), bufferSize);
+        if (got == 0) {
+            ofLogNotice() << "AUDIO: virtual input ended after " << getFramesDelivered() << " frames";
+            break;
+        }
+
+        // Deliver on the device schedule. A slow pipe makes us late, then restart the clock
+        // instead of firing a burst of callbacks to catch up.
+        next += period;
+        auto now = steady_clock::now();
+        if (now > next + period * 4) next = now;
+        std::this_thread::sleep_until(next);
+
+        buffer.setTickCount(framesDelivered / bufferSize);
+        if (listener) listener->audioIn(buffer);
+        framesDelivered += got;
+    }
+    running = false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+// Stand-in for an input device on machines without audio hardware.
+// Streams a WAV file (looped) or raw PCM from a file or FIFO to the listener's audioIn() at
+// real-time pace, in device-sized buffers from its own thread, so the analysis and visuals
+// run exactly as they would on a sound card. Paths ending in .wav are parsed as WAV (16/24/32
+// bit PCM or float, also through a FIFO), anything else is raw interleaved little endian:
+// 16 bit by default, 32 bit float when the path ends in .f32. "-" reads standard input.
+// For example
+//   mkfifo /tmp/vj.fifo; ffmpeg -i mix.flac -f s16le -ar 48000 -ac 2 - > /tmp/vj.fifo
+// The offline analysis skips start() and pulls with read() as fast as it can instead.
+class VirtualAudioInput {
+public:
+	static const char * DEVICE_NAME; // Shown next to the hardware devices
+
+	~VirtualAudioInput();
+
+	// Reads the format; opening a FIFO blocks until a writer has it open as well
+	bool open(const string & path, int bufferSize, int rawSampleRate = 48000, int rawChannels = 2);
+	void start(ofBaseSoundInput * listener); // Begin delivering buffers
+	void close();
+
+	// Pull interface for offline use: converts up to numFrames interleaved frames (at most the
+	// buffer size given to open()), zero-fills the rest and returns how many were read.
+	// Loops a regular file unless looping is off.
+	size_t read(float * out, size_t numFrames);
+	void setLooping(bool enabled) { looping = enabled; }
+
+	bool isOpen() const { return running.load(); }
+	int getSampleRate() const { return sampleRate; }
+	int getNumChannels() const { return numChannels; }
+	int getBufferSize() const { return bufferSize; }
+	uint64_t getFramesDelivered() const { return framesDelivered.load(std::memory_order_relaxed); }
+
+private:
+	enum SampleFormat { FORMAT_S16, FORMAT_S24, FORMAT_S32, FORMAT_F32 };
+
+	bool readHeader(const string & path, int rawSampleRate, int rawChannels);
+	bool skip(uint64_t bytes); // Reads past them, works on pipes
+	void threadedFunction();
+
+	FILE * file = nullptr;
+	bool seekable = false; // Regular files loop, pipes end when the writer closes
+	bool looping = true;
+	long dataStart = 0;
+	uint64_t dataSize = 0; // Bytes in the WAV data chunk, 0 = up to the end of the file
+	uint64_t dataRead = 0; // ... of those read since dataStart
+	SampleFormat format = FORMAT_S16;
+	int bytesPerSample = 2;
+	int sampleRate = 48000;
+	int numChannels = 2;
+	int bufferSize = 256;
+	vector<unsigned char> raw;
+	ofSoundBuffer buffer;
+
+	ofBaseSoundInput * listener = nullptr;
+	std::thread thread;
+	std::atomic<bool> running { false };
+	std::atomic<uint64_t> framesDelivered { 0 };
+};
@@ -1,8 +1,31 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "OfflineAnalysis.h"
 
 //========================================================================
-int main( ){
+int main(int argc, char * argv[]){
+
+	// Headless: analyze a file to CSV/binary without opening a window
+	if (argc > 1 && string(argv[1]) == "--analyze") {
+		return OfflineAnalysis::run(vector<string>(argv + 2, argv + argc));
+	}
+
+	// Deterministic render to images or an encoder, in a hidden window for the GL context
+	if (argc > 1 && string(argv[1]) == "--render") {
+		OfflineRenderSettings render;
+		if (!render.parse(vector<string>(argv + 2, argv + argc))) return 1;
+
+		ofGLFWWindowSettings settings;
+		settings.setGLVersion(3, 2);
+		settings.setSize(render.width, render.height);
+		settings.visible = false;
+
+		auto window = ofCreateWindow(settings);
+		auto app = std::make_shared<ofApp>();
+		app->setOfflineRender(render);
+		ofRunApp(window, app);
+		return ofRunMainLoop();
+	}
 
 	ofGLWindowSettings settings;
 	settings.setGLVersion(3, 2);
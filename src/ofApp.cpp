@@ -1,4 +1,10 @@
 #include "ofApp.h"
+#include <cstdarg>
+
+// Overlay samplers in shader.frag, image and chroma plane
+static const char * layerSamplers[ReactiveUniforms::MAX_OVERLAYS][2] = {
+    { "layer1", "layer1uv" }, { "layer2", "layer2uv" }, { "layer3", "layer3uv" }
+};
 
 ofApp::~ofApp() {
     // Force a full hardware release on exit
@@ -6,12 +12,13 @@ ofApp::~ofApp() {
         soundStream.stop();
         soundStream.close();
     }
+    virtualInput.close();
+    if (RealtimeAudit::isEnabled()) writeAuditReport();
     
+    analyzer.stop();
+    clips.stop();
+    library.stop();
     cleanupDeviceToggles();
-    if (fft != nullptr) {
-        delete fft;
-        fft = nullptr;
-    }
 }
 
 void ofApp::cleanupDeviceToggles() {
@@ -24,13 +31,6 @@ void ofApp::cleanupDeviceToggles() {
     deviceToggleStates.clear();
 }
 
-void ofApp::updateStartButtonLabel() {
-    btnStart.setName("START VJ");
-    btnStart.getParameter().setName("START VJ");
-    btnStop.setName("STOP VJ");
-    btnStop.getParameter().setName("STOP VJ");
-}
-
 void ofApp::buildSettingsGui() {
     isUpdatingGui = true; 
     bIsTransitioning = true; // Block all inputs
@@ -43,6 +43,9 @@ void ofApp::buildSettingsGui() {
     gui.add(lblFolderPath.setup("Selected path:", folderPath));
     gui.add(lblSpacer.setup("", ""));
     gui.add(lblDeviceHeader.setup("2. Select Input Device", ""));
+    if (getAvailableApis().size() > 1) {
+        gui.add(btnAudioBackend.setup("Audio backend: " + getApiName(currentApi)));
+    }
 
     vector<ofSoundDevice> devices;
     {
@@ -60,59 +63,227 @@ void ofApp::buildSettingsGui() {
         }
     }
 
+    // Always available, for machines without audio hardware and for repeatable benchmarks
+    ofxToggle * virtualToggle = new ofxToggle();
+    gui.add(virtualToggle->setup(VirtualAudioInput::DEVICE_NAME, false));
+    virtualToggle->addListener(this, &ofApp::deviceButtonPressed);
+    deviceToggles.push_back(virtualToggle);
+    deviceToggleStates.push_back(false);
+
+    // Which device channels feed the analysis (8+ channel interfaces can pick any pair)
+    gui.add(sldInputLeft.setup("Input channel L", 1, 1, 32));
+    gui.add(sldInputRight.setup("Input channel R (0 = mono)", 2, 0, 32));
+    gui.add(sldChannelMode.setup("Mono / L+R / Mid+Side", CHANNEL_MODE_MONO, 0, NUM_CHANNEL_MODES - 1));
+
+    // Render height independent of the output, e.g. 720 for a 4K projector on a weak GPU
+    gui.add(sldRenderHeight.setup("Render height (0 = window)", 0, 0, 2160));
+
+    // Decode-ahead queue per clip: deeper rides out slow drives and 4K spikes, costs a frame of memory each
+    gui.add(sldDecodeAhead.setup("Decode-ahead frames (0 = off)", 8, 0, 32));
+
+    // Clips on screen at once, composited in the scene shader; the memory budget and the quality governor may run fewer
+    gui.add(sldLayers.setup("Clip layers", 2, 1, ClipLayers::MAX_LAYERS));
+
     gui.add(lblSpacer.setup("", ""));
     gui.add(btnStart.setup("START VJ"));
 
     btnSelectFolder.addListener(this, &ofApp::selectFolderPressed);
     btnStart.addListener(this, &ofApp::startPressed);
+    btnAudioBackend.addListener(this, &ofApp::audioBackendPressed);
 
     selectedDeviceIndex = -1; 
     isUpdatingGui = false;    
 }
 
 bool ofApp::startLiveSession(bool allowVideoLoad) {
-    if (videoFiles.empty() || selectedDeviceIndex < 0) return false;
+    if (library.getNumClips() == 0 || selectedDeviceIndex < 0) return false;
 
     string targetName = deviceToggles[selectedDeviceIndex]->getName();
-    auto devices = soundStream.getDeviceList(currentApi);
-    ofSoundDevice selectedDevice;
-    bool found = false;
-    for (auto& d : devices) {
-        if (d.inputChannels > 0 && d.name == targetName) {
-            selectedDevice = d;
-            found = true;
-            break;
+    bVirtualInput = (targetName == VirtualAudioInput::DEVICE_NAME);
+
+    bool opened = false;
+    if (bVirtualInput) {
+        // The file dictates rate and channels, so the analyzer is configured once it is open
+        opened = virtualInput.open(virtualInputPath, 256);
+        if (opened) {
+            configureAnalyzer(256, virtualInput.getSampleRate(), virtualInput.getNumChannels());
+            virtualInput.start(this);
+        }
+    } else {
+        auto devices = soundStream.getDeviceList(currentApi);
+        bool found = false;
+        for (auto& d : devices) {
+            if (d.inputChannels > 0 && d.name == targetName) {
+                selectedAudioDevice = d;
+                found = true;
+                break;
+            }
         }
+        if (!found) return false;
+
+        // Start small, checkAudioStability() backs off while the input drops buffers
+        opened = openAudioStream(128);
+    }
+
+    if (opened) {
+        isLive = true;
+        clips.getBase().decodeAheadFrames = sldDecodeAhead;
+        clips.getBase().transportSeed = ofGetSystemTimeMicros(); // Different jumps every set
+        clips.maxLayers = sldLayers;
+        if (allowVideoLoad) clips.start();
+        return true;
+    }
+    return false;
+}
+
+void ofApp::stopLiveSession() {
+    // Back to the settings screen with the input released, a new start sets everything up again
+    if (!isLive) return;
+    isLive = false;
+
+    // Usually called mid-frame: leave the frame section, then finish the audit with the
+    // session so the settings screen is not counted as frames
+    RealtimeAudit::end();
+    if (RealtimeAudit::isEnabled()) writeAuditReport();
+    tglAudit = false;
+    auditArmTimer = -1.0f;
+
+    if (bVirtualInput) virtualInput.close();
+    else if (soundStream.getSoundStream()) {
+        soundStream.stop();
+        soundStream.close();
+    }
+    audioProbeTimer = -1.0f;
+    analyzer.stop();
+    clips.stop();
+    ofLogNotice() << "AUDIO: live session stopped";
+}
+
+vector<ofSoundDevice::Api> ofApp::getAvailableApis() {
+    #if defined(TARGET_OSX)
+        return { ofSoundDevice::Api::OSX_CORE };
+    #elif defined(TARGET_LINUX)
+        // Pulse first: PipeWire serves it as well and it shares the device with other apps
+        return { ofSoundDevice::Api::PULSE, ofSoundDevice::Api::ALSA, ofSoundDevice::Api::JACK };
+    #else
+        return { ofSoundDevice::Api::MS_WASAPI };
+    #endif
+}
+
+string ofApp::getApiName(ofSoundDevice::Api api) {
+    switch (api) {
+        case ofSoundDevice::Api::ALSA: return "ALSA";
+        case ofSoundDevice::Api::PULSE: return "PulseAudio";
+        case ofSoundDevice::Api::JACK: return "JACK";
+        case ofSoundDevice::Api::OSX_CORE: return "CoreAudio";
+        case ofSoundDevice::Api::MS_WASAPI: return "WASAPI";
+        case ofSoundDevice::Api::MS_ASIO: return "ASIO";
+        case ofSoundDevice::Api::MS_DS: return "DirectSound";
+        default: return "default";
+    }
+}
+
+void ofApp::audioBackendPressed() {
+    if (bIsTransitioning || isLive) return;
+
+    vector<ofSoundDevice::Api> apis = getAvailableApis();
+    auto it = std::find(apis.begin(), apis.end(), currentApi);
+    currentApi = (it == apis.end() || it + 1 == apis.end()) ? apis.front() : *(it + 1);
+    ofLogNotice() << "AUDIO: backend " << getApiName(currentApi);
+    bRebuildGui = true; // New device list
+}
+
+void ofApp::configureAnalyzer(int bufferSize, int sampleRate, int numChannels) {
+    AnalyzerSettings analyzerSettings = analyzer.getSettings();
+    analyzerSettings.channelMode = (ChannelMode)(int)sldChannelMode;
+    analyzerSettings.leftChannel = std::min((int)sldInputLeft - 1, numChannels - 1);
+    analyzerSettings.rightChannel = std::min((int)sldInputRight - 1, numChannels - 1);
+    analyzerSettings.inputLatency = (double)bufferSize / (double)sampleRate;
+    analyzerSettings.sampleRate = sampleRate;
+    analyzer.setup(analyzerSettings);
+    analyzer.start();
+
+    audioMonitor.reset(bufferSize, sampleRate);
+    profiler.setAudioPeriod(analyzerSettings.inputLatency); // One device buffer
+}
+
+void ofApp::setAudioBufferSize(int bufferSize, int sampleRate) {
+    double latency = (double)bufferSize / (double)sampleRate;
+    analyzer.setInputLatency(latency);
+    audioMonitor.reset(bufferSize, sampleRate);
+    profiler.setAudioPeriod(latency);
+}
+
+bool ofApp::openAudioStream(int bufferSize, bool reopen) {
+    if (soundStream.getSoundStream()) {
+        soundStream.stop();
+        soundStream.close();
     }
 
-    if (!found) return false;
+    // Open enough channels to reach the selected pair, the analyzer falls back to what it gets
+    int leftChannel = (int)sldInputLeft - 1;
+    int rightChannel = (int)sldInputRight - 1;
+    int channelsNeeded = std::max(leftChannel, rightChannel) + 1;
+    int numInputs = std::min(channelsNeeded, (int)selectedAudioDevice.inputChannels);
 
     ofSoundStreamSettings settings;
     settings.setApi(currentApi);
-    settings.setInDevice(selectedDevice);
+    settings.setInDevice(selectedAudioDevice);
     settings.setInListener(this);
-    settings.numInputChannels = (selectedDevice.inputChannels > 2) ? 2 : selectedDevice.inputChannels;
+    settings.numInputChannels = std::max(1, numInputs);
     settings.numOutputChannels = 0;
 	#ifdef TARGET_WIN32
 		// Windows: Force 48000 to avoid the WASAPI Resampler lag (~150ms)
 		settings.sampleRate = 48000;
+	#elif defined(TARGET_LINUX)
+		// Linux: 48k when the device has it (JACK only lists the server rate), avoids resampling in Pulse/PipeWire
+		const vector<unsigned int> & rates = selectedAudioDevice.sampleRates;
+		if (rates.empty() || std::find(rates.begin(), rates.end(), 48000u) != rates.end()) settings.sampleRate = 48000;
+		else settings.sampleRate = rates[0];
 	#else
 		// macOS/Other: Use the device's preferred rate or fallback to 44100
-		settings.sampleRate = selectedDevice.sampleRates.empty() ? 44100 : selectedDevice.sampleRates[0];
+		settings.sampleRate = selectedAudioDevice.sampleRates.empty() ? 44100 : selectedAudioDevice.sampleRates[0];
 	#endif
-	settings.bufferSize = 1024;
 
-    if (soundStream.setup(settings)) {
-        isLive = true;
-        if (video.isLoaded()) video.play();
-        else if (allowVideoLoad) loadRandomVideo();
-        return true;
+    // The callback only copies into the analyzer ring, so small buffers are safe and cut input
+    // latency. Take the smallest size the device accepts. The channels and rate are the same
+    // for every size, so the analyzer is set up once and only follows the buffer latency.
+    if (!reopen) configureAnalyzer(bufferSize, settings.sampleRate, settings.numInputChannels);
+    for (int size = bufferSize; size <= 1024; size *= 2) {
+        settings.bufferSize = size;
+        setAudioBufferSize(size, settings.sampleRate);
+        if (soundStream.setup(settings)) {
+            audioBufferSize = size;
+            audioProbeTimer = 0.0f;
+            ofLogNotice() << "AUDIO: " << getApiName(currentApi) << " \"" << selectedAudioDevice.name << "\" "
+                          << settings.sampleRate << "Hz, buffer " << size << " (" << ofToString(audioMonitor.getBufferLatencyMs(), 1) << " ms)";
+            return true;
+        }
+        ofLogWarning() << "AUDIO: buffer " << size << " refused, trying " << size * 2;
     }
+    ofLogError() << "AUDIO: could not open " << selectedAudioDevice.name;
     return false;
 }
 
+void ofApp::checkAudioStability(float dt) {
+    // Watch each new buffer size for a few seconds, double it while the input drops audio
+    if (bVirtualInput || audioProbeTimer < 0.0f) return;
+    audioProbeTimer += dt;
+    if (audioProbeTimer < 5.0f) return;
+
+    if (audioMonitor.getXruns() > 0 && audioBufferSize < 1024) {
+        ofLogWarning() << "AUDIO: " << audioMonitor.getXruns() << " xruns at buffer " << audioBufferSize << ", backing off";
+        if (!openAudioStream(audioBufferSize * 2, true)) stopLiveSession();
+        return;
+    }
+    audioProbeTimer = -1.0f;
+    ofLogNotice() << "AUDIO: buffer " << audioBufferSize << " settled, period " << ofToString(audioMonitor.getPeriodMs(), 2)
+                  << " ms, " << audioMonitor.getXruns() << " xruns";
+}
+
 void ofApp::setup() {
-    ofSetBackgroundAuto(false);
+    // Trails live in the render graph's feedback buffers, the window is cleared every frame
+    ofSetBackgroundAuto(true);
 
 	// Set path for OSX release version
 	#ifdef TARGET_OSX
@@ -121,21 +292,64 @@ void ofApp::setup() {
 		#endif
 	#endif
 
-    shader.load("shader.vert", "shader.frag");
+    // Reactive parameters live in one std140 block (ReactiveUniforms.h), uploaded once per frame
+    uniformBuffer.allocate(sizeof(ReactiveUniforms), GL_DYNAMIC_DRAW);
+    moshShaders.setOnLink([](ofShader & shader) {
+        shader.bindUniformBlock(ReactiveUniforms::BINDING, "ReactiveParams");
+    });
+    moshShaders.setup("shader.vert", "shader.frag");
+    scanlineShader.load("shader.vert", "scanlines.frag");
+    loadModulation();
+
+    // Clip index persists between runs, the next clip is chosen to match the music's energy
+    library.setup(ofToDataPath("video_index.tsv", true));
+    clips.setPicker([this](const string & playing, int maxHeight) { return library.pick(energyLevel, playing, maxHeight); });
+    clips.setMovieInfo([this](const string & path, MovieInfo & info) { return library.getMovieInfo(path, info); });
     
     // Setup the "Live" GUI (the one seen while VJing)
     guiLive.setup("Cognitoni Auto VJ");
     guiLive.add(btnStop.setup("STOP VJ"));
+    guiLive.add(tglFeedback.setup("Feedback trail", true));
+    guiLive.add(tglFlash.setup("Strobe flash", true));
+    guiLive.add(tglScanlines.setup("Scanlines", true));
+    guiLive.add(tglProfiler.setup("Profiler", false));
+    guiLive.add(tglShareFrames.setup("Share frames (shm)", false));
+    guiLive.add(tglGovernor.setup("Adaptive quality", true));
+    governor.settings.targetFps = ofGetTargetFrameRate() > 0.0f ? ofGetTargetFrameRate() : 60.0f;
+    governor.reset();
+    guiLive.add(tglAudit.setup("Realtime audit", false));
+    hudText.reserve(256);
+    guiLive.add(btnExportProfile.setup("Export profile"));
     btnStop.addListener(this, &ofApp::stopPressed);
-
-    #ifdef TARGET_OSX
-        currentApi = ofSoundDevice::Api::OSX_CORE;
-    #else
-        currentApi = ofSoundDevice::Api::MS_WASAPI;
-    #endif
-
-    fft = ofxFft::create(1024, OF_FFT_WINDOW_HAMMING);
-    if (fft != nullptr) fftBins.resize(fft->getBinSize());
+    btnExportProfile.addListener(this, &ofApp::exportProfilePressed);
+
+    // Stages for the profiler HUD, render passes report the CPU and GPU time RenderGraph measures
+    profUpdate = profiler.addStage("update");
+    profAudioFrame = profiler.addStage("audio frame");
+    profModulation = profiler.addStage("modulation");
+    profClips = profiler.addStage("clips");
+    profDraw = profiler.addStage("draw");
+    profHud = profiler.addStage("hud");
+    profCpuPass = profiler.getNumStages();
+    for (int i = 0; i < RenderGraph::NUM_PASSES; i++) profiler.addStage(string("cpu ") + RenderGraph::getPassName((RenderGraph::Pass)i));
+    profGpuPass = profiler.getNumStages();
+    for (int i = 0; i < RenderGraph::NUM_PASSES; i++) profiler.addStage(string("gpu ") + RenderGraph::getPassName((RenderGraph::Pass)i));
+    profLatency = profiler.addStage("latency"); // Audio capture to frame shown
+
+    currentApi = getAvailableApis().front();
+    if (const char * inputPath = getenv("COGNITONI_AUDIO_INPUT")) virtualInputPath = inputPath;
+
+    // 1024-point window analysed every 256 samples, independent of the device buffer
+    AnalyzerSettings analyzerSettings;
+    analyzerSettings.windowSize = 1024;
+    analyzerSettings.hopSize = 256;
+    analyzer.setup(analyzerSettings);
+    analyzer.start();
+    fftBins.assign(analyzer.getSpectrumRowSize(), 0.0f);
+    spectrogram.setup(analyzer.getSpectrumRowSize());
+
+    rng.setSeed(ofGetSystemTimeMicros());
+    if (bOfflineRender) startOfflineRender();
     
     sldAudioGain = 1.0f;
 
@@ -143,45 +357,248 @@ void ofApp::setup() {
     buildSettingsGui(); 
 }
 
+bool ofApp::loadModulation() {
+    string path = ofToDataPath(modulationPath, true);
+    modulationFile = path;
+    std::error_code ec;
+    modulationStamp = std::filesystem::last_write_time(modulationFile, ec);
+
+    // Keep whatever mapping is active (the built-in one at startup) when the file is unusable
+    ModulationMatrix loaded;
+    if (ec || !ModulationFile::load(path, loaded)) return false;
+    reactive.modulation = loaded;
+    return true;
+}
+
+void ofApp::checkModulationReload(float dt) {
+    // Poll the mapping file once a second so routes can be tuned while running
+    modulationCheckTimer += dt;
+    if (modulationCheckTimer < 1.0f) return;
+    modulationCheckTimer = 0.0f;
+
+    std::error_code ec;
+    auto stamp = std::filesystem::last_write_time(modulationFile, ec);
+    if (!ec && stamp != modulationStamp) loadModulation();
+}
+
+void ofApp::exportProfilePressed() {
+    if (!profiler.isEnabled()) {
+        ofLogWarning() << "PROFILER: turn the profiler on before exporting";
+        return;
+    }
+    string name = "profile-" + ofGetTimestampString("%Y%m%d-%H%M%S");
+    profiler.exportCsv(name + ".csv");
+    profiler.exportTrace(name + ".json");
+}
+
+void ofApp::updateAudit(float dt) {
+    if (!tglAudit) {
+        auditArmTimer = -1.0f;
+        if (RealtimeAudit::isEnabled()) writeAuditReport();
+        return;
+    }
+    if (RealtimeAudit::isEnabled()) return;
+
+    // Let the frames right after the click (GUI redraw, log line) pass before counting
+    if (auditArmTimer < 0.0f) auditArmTimer = 2.0f;
+    auditArmTimer -= dt;
+    if (auditArmTimer > 0.0f) return;
+    RealtimeAudit::reset();
+    RealtimeAudit::setEnabled(true);
+    ofLogNotice() << "AUDIT: counting allocations and locks in the audio callback, analysis and frames";
+}
+
+void ofApp::writeAuditReport() {
+    RealtimeAudit::setEnabled(false);
+    RealtimeAudit::Totals totals = RealtimeAudit::getTotals();
+    string name = "audit-" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".txt";
+    bool written = RealtimeAudit::writeReport(ofToDataPath(name, true));
+
+    ofLogNotice() << "AUDIT: " << (RealtimeAudit::passed(totals) ? "passed" : "FAILED") << ", audio "
+                  << totals.events[RealtimeAudit::SECTION_AUDIO][RealtimeAudit::KIND_ALLOCATION] << " allocs "
+                  << totals.events[RealtimeAudit::SECTION_AUDIO][RealtimeAudit::KIND_LOCK] << " locks in "
+                  << totals.sections[RealtimeAudit::SECTION_AUDIO] << " callbacks, analysis "
+                  << totals.events[RealtimeAudit::SECTION_ANALYSIS][RealtimeAudit::KIND_ALLOCATION] << " / "
+                  << totals.events[RealtimeAudit::SECTION_ANALYSIS][RealtimeAudit::KIND_LOCK] << ", "
+                  << totals.flagged[RealtimeAudit::SECTION_FRAME] << " of " << totals.sections[RealtimeAudit::SECTION_FRAME]
+                  << " frames allocated";
+    if (written) ofLogNotice() << "AUDIT: call sites in " << name;
+    else ofLogError() << "AUDIT: could not write " << name;
+}
+
+const string & ofApp::formatHud(const char * format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    hudText.assign(line); // Fits the capacity reserved in setup()
+    return hudText;
+}
+
+void ofApp::setOfflineRender(const OfflineRenderSettings & settings) {
+    offlineSettings = settings;
+    bOfflineRender = true;
+}
+
+void ofApp::startOfflineRender() {
+    rng.setSeed(offlineSettings.seed);
+    ofSetVerticalSync(false);
+    ofSetFrameRate(0); // As fast as frames render, the clock is fixed anyway
+
+    // The audio file is read per frame and analysed on this thread, no device and no latency
+    if (!virtualInput.open(offlineSettings.audioPath, 256)) {
+        ofExit(1);
+        return;
+    }
+    virtualInput.setLooping(false);
+    AnalyzerSettings analyzerSettings = analyzer.getSettings();
+    analyzerSettings.inputLatency = 0.0;
+    analyzerSettings.sampleRate = virtualInput.getSampleRate();
+    analyzer.setup(analyzerSettings); // Stops the analysis thread, processPending() drives it
+    offlineAudio.assign((size_t)256 * virtualInput.getNumChannels(), 0.0f);
+    offlineSamples = 0;
+    offlineFrame = 0;
+
+    clips.getBase().frameStepped = true;
+    clips.getBase().transportSeed = offlineSettings.seed;
+    clips.maxLayers = offlineSettings.layers;
+    clips.setPicker([this](const string & playing, int) { return pickOfflineClip(playing); });
+    if (!frameWriter.open(offlineSettings)) {
+        ofExit(1);
+        return;
+    }
+
+    if (offlineSettings.verifyCpu) {
+        softwareMosh = make_unique<SoftwareMosh>();
+        ofLogNotice() << "RENDER: verifying scenes against the CPU port (" << SoftwareMosh::getKernelName() << ", "
+                      << softwareMosh->getNumThreads() << " threads, tolerance " << offlineSettings.tolerance << ")";
+    }
+
+    isLive = true;
+    clips.start();
+    offlineStartMicros = ofGetElapsedTimeMicros();
+    ofLogNotice() << "RENDER: " << offlineSettings.clips.size() << " clips, seed " << offlineSettings.seed << ", "
+                  << offlineSettings.width << "x" << offlineSettings.height << " at " << offlineSettings.fps << " fps";
+}
+
+bool ofApp::feedOfflineAudio() {
+    // Everything up to the end of this frame, in 256-frame blocks stamped on the file timeline
+    double frameEnd = (double)(offlineFrame + 1) / offlineSettings.fps;
+    if (offlineSettings.duration > 0.0 && frameEnd > offlineSettings.duration) return false;
+
+    int rate = virtualInput.getSampleRate();
+    int channels = virtualInput.getNumChannels();
+    uint64_t target = (uint64_t)llround(frameEnd * rate);
+    while (offlineSamples < target) {
+        size_t got = virtualInput.read(offlineAudio.data(), (size_t)std::min<uint64_t>(target - offlineSamples, 256));
+        if (got == 0) return false;
+        offlineSamples += got;
+        analyzer.pushSamples(offlineAudio.data(), got, channels, rate, (double)offlineSamples / rate);
+    }
+    analyzer.processPending();
+    return true;
+}
+
+void ofApp::captureOfflineFrame() {
+    // A frame the deck has no clip for is written black, so frame n always sits at n / fps
+    if (clips.isReady()) {
+        renderGraph.getOutput().readToPixels(capturePixels);
+        capturePixels.setNumChannels(3);
+    } else {
+        capturePixels.allocate(offlineSettings.width, offlineSettings.height, OF_PIXELS_RGB);
+        capturePixels.set(0);
+    }
+    if (!frameWriter.write(capturePixels)) {
+        finishOfflineRender();
+        return;
+    }
+    offlineFrame++;
+}
+
+void ofApp::finishOfflineRender() {
+    if (!isLive) return;
+    isLive = false;
+    frameWriter.close();
+
+    double wall = (ofGetElapsedTimeMicros() - offlineStartMicros) / 1000000.0;
+    double rendered = (double)offlineFrame / offlineSettings.fps;
+    ofLogNotice() << "RENDER: " << offlineFrame << " frames (" << ofToString(rendered, 2) << "s) in " << ofToString(wall, 2)
+                  << "s, " << ofToString(rendered / std::max(wall, 1e-6), 2) << "x real time";
+    if (verifyFrames > 0) {
+        ofLogNotice() << "RENDER: CPU vs GPU over " << verifyFrames << " scenes: mean error " << ofToString(verifyMeanSum / verifyFrames, 3)
+                      << " (worst " << ofToString(verifyWorstMean, 3) << "), " << verifyFramesOver << " scenes with over 1% of pixels off by more than "
+                      << offlineSettings.tolerance;
+    }
+    ofExit(verifyFramesOver > 0 ? 2 : 0);
+}
+
+void ofApp::verifySceneOnCpu(int styleA, int styleB, float styleMix) {
+    auto toSource = [](ofPixels & pixels) {
+        SoftwareMosh::Source source;
+        int width = (int)pixels.getWidth();
+        int height = (int)pixels.getHeight();
+        source.yuv = pixels.getPixelFormat() == OF_PIXELS_NV12;
+        source.image = { pixels.getData(), width, height, source.yuv ? 1 : (int)pixels.getNumChannels(), 0 };
+        if (source.yuv) source.chroma = { pixels.getData() + (size_t)width * height, width / 2, height / 2, 2, 0 };
+        return source;
+    };
+
+    // Same uniforms, styles, clip frames and quad transform the GPU just used
+    SoftwareMosh::Frame frame;
+    frame.uniforms = uniforms;
+    frame.styleA = styleA;
+    frame.styleB = styleB;
+    frame.styleMix = styleMix;
+    frame.tex0 = toSource(clips.getBase().getCurrent().getPixels());
+    frame.tex1 = toSource(clips.getBase().getIncoming().getPixels());
+    for (int i = 0; i < ReactiveUniforms::MAX_OVERLAYS; i++) {
+        if (uniforms.layerOpacity[i] > 0.0f) frame.layers[i] = toSource(clips.getPlayer(i + 1).getPixels());
+    }
+    frame.view = sceneView;
+
+    int w = renderGraph.getWidth();
+    int h = renderGraph.getHeight();
+    cpuScene.resize((size_t)w * h * 4);
+    softwareMosh->render(frame, cpuScene.data(), w, h);
+    renderGraph.getScene().readToPixels(gpuScenePixels);
+    if ((int)gpuScenePixels.getWidth() != w || (int)gpuScenePixels.getHeight() != h || gpuScenePixels.getNumChannels() != 4) return;
+
+    SoftwareMosh::Diff diff = SoftwareMosh::compare(gpuScenePixels.getData(), cpuScene.data(), w, h, offlineSettings.tolerance);
+    verifyFrames++;
+    verifyMeanSum += diff.meanError;
+    verifyWorstMean = std::max(verifyWorstMean, diff.meanError);
+    if (diff.overTolerance > 0.01) {
+        verifyFramesOver++;
+        ofLogWarning() << "RENDER: frame " << offlineFrame << " CPU vs GPU mean " << ofToString(diff.meanError, 3) << ", max "
+                       << diff.maxError << ", " << ofToString(diff.overTolerance * 100.0, 2) << "% over tolerance";
+    }
+}
+
+string ofApp::pickOfflineClip(const string & playing) {
+    // Seeded choice from the list, never the clip that is playing unless it is the only one
+    vector<const string *> candidates;
+    for (auto & path : offlineSettings.clips) {
+        if (path != playing) candidates.push_back(&path);
+    }
+    if (candidates.empty()) return offlineSettings.clips.empty() ? "" : offlineSettings.clips[0];
+    return *candidates[rng.index((int)candidates.size())];
+}
+
 void ofApp::selectFolderPressed() {
     if (bIsTransitioning || isLive) return; // Hard block during transition or live session
 
     ofFileDialogResult res = ofSystemLoadDialog("Select Video Folder", true);
 
     if (res.bSuccess) {
-        string newFolderPath = res.getPath();
-        ofDirectory dir(newFolderPath);
-        dir.allowExt("mp4");
-        dir.allowExt("mov");
-        dir.listDir();
-
-        vector<string> newVideoFiles;
-        for (int i = 0; i < dir.size(); i++) {
-            newVideoFiles.push_back(dir.getPath(i));
-        }
-
-        ofLogNotice() << "Videos found: " << newVideoFiles.size();
-
-        if (newVideoFiles.empty()) {
-            ofSystemAlertDialog("Error: No videos found in that folder.");
-            return;
-        }
-
-        folderPath = newFolderPath;
+        folderPath = res.getPath();
         lblFolderPath = folderPath;
-        videoFiles = newVideoFiles;
-
-        bPendingLoad = false;
-        bIsLoading = false;
-        
-        // Use the reinforced texture cleanup
-        video.stop();
-        video.setUseTexture(false); 
-        if (video.isLoaded()) {
-            video.closeMovie();
-        }
 
-        loadRandomVideo();
+        // Index the folder (recursively) in the background, known clips are usable at once
+        clips.stop();
+        library.scan(folderPath);
+        bScanPending = true;
+        clips.start();
     }
 }
 
@@ -227,15 +644,19 @@ void ofApp::deviceButtonPressed(bool & val) {
     isUpdatingGui = false;
 
     ofLogNotice() << ">>> NEW SELECTION: " << deviceToggles[changedIndex]->getName();
+
+    if (deviceToggles[changedIndex]->getName() == VirtualAudioInput::DEVICE_NAME) {
+        ofFileDialogResult result = ofSystemLoadDialog("Select a WAV file or raw PCM pipe");
+        if (result.bSuccess) virtualInputPath = result.getPath();
+        ofLogNotice() << "AUDIO: virtual input " << (virtualInputPath.empty() ? "not set" : virtualInputPath);
+    }
 }
 
 void ofApp::startPressed() {
     if (bIsTransitioning || isLive) return;
 
     // Load video first to manage thread priorities
-    if (!video.isLoaded()) {
-        loadRandomVideo();
-    }
+    clips.start();
 
     // Start audio after video initialization
     startLiveSession(false); 
@@ -247,239 +668,452 @@ void ofApp::stopPressed() {
 }
 
 void ofApp::audioIn(ofSoundBuffer & input) {
-    if (!isLive || fft == nullptr) return;
-    
-    fft->setSignal(input.getBuffer());
-    float* analyzerBuffer = fft->getAmplitude();
-    int numBins = fft->getBinSize();
-    
-    float s = 0, lm = 0, m = 0, hm = 0, t = 0;
+    if (!isLive) return;
 
-    // Use the actual buffer rate to keep math accurate
-    int sampleRate = input.getSampleRate();
-    
-    // Frequency per bin = SampleRate / (N_FFT)
-    float binSize = (float)sampleRate / (float)(numBins * 2);
-
-    // Calculate indices dynamically to match frequency targets
-    int subCutoff = 150 / binSize;
-    int lowMidCut = 350 / binSize;
-    int midCut = 1000 / binSize;
-    int highMidCut = 4000 / binSize;
-
-    int counts[5] = { 0, 0, 0, 0, 0 };
-
-    for (int i = 0; i < numBins; i++) {
-        // Apply frequency tilt to counter natural energy drop-off in higher frequencies
-        float tilt = 1.0f + ((float)i / (float)numBins) * 10.0f;
-        float sample = analyzerBuffer[i] * (float)sldAudioGain * 25.0f * tilt;
-
-        if (i <= subCutoff) {
-            s += sample;
-            counts[0]++;
-        } else if (i <= lowMidCut) {
-            lm += sample;
-            counts[1]++;
-        } else if (i <= midCut) {
-            m += sample;
-            counts[2]++;
-        } else if (i <= highMidCut) {
-            hm += sample;
-            counts[3]++;
-        } else {
-            t += sample;
-            counts[4]++;
-        }
-    }
-    // Note: Atomicity is handled automatically during assignment
-    subBass = ofLerp(subBass, (s / max(1, counts[0])) * 1.0f, 0.1f);
-    lowMids = ofLerp(lowMids, (lm / max(1, counts[1])) * 1.8f, 0.1f);
-    mids = ofLerp(mids, (m / max(1, counts[2])) * 2.5f, 0.1f);
-    highMids = ofLerp(highMids, (hm / max(1, counts[3])) * 4.0f, 0.1f);
-    treble = ofLerp(treble, (t / max(1, counts[4])) * 6.0f, 0.1f);
+    // Realtime thread: split channels and hand the samples over, the FFT runs on the analyzer thread
+    RealtimeSection auditSection(RealtimeAudit::SECTION_AUDIO);
+    profiler.audioCallbackBegin();
+    audioMonitor.onCallback(input.getNumFrames(), AudioAnalyzer::now());
+    analyzer.pushSamples(input.getBuffer().data(), input.getNumFrames(), input.getNumChannels(), input.getSampleRate());
+    profiler.audioCallbackEnd();
 }
 
 void ofApp::update() {
+    if (bRebuildGui) {
+        bRebuildGui = false;
+        buildSettingsGui();
+    }
+
     // If we just rebuilt the GUI, wait one frame, then enable buttons
     if (bIsTransitioning) {
         bIsTransitioning = false; 
         return; 
     }
 
-    if (!isLive) return;
-
-    video.update();
-
-    // --- IMPACT & STROBE LOGIC ---
-    if (strobeTimer > 0) strobeTimer -= 0.1f;
-    
-    // Calculate how much the current bass hit exceeds the average
-    float impactDelta = std::max(0.0f, (float)lowMids - (smoothedLowMids + 0.12f));
-    
-    // Trigger flash on significant peaks
-    if (impactDelta > 0.45f) strobeTimer = 1.0f;
-
-    // --- ENVELOPE ZOOM & RGB LOGIC ---
-    // Ignore tiny volume fluctuations to prevent constant shivering
-    float cleanImpact = 0.0f;
-    if (impactDelta > 0.05f) {
-        // Map the impact to a usable range (0.0 to 1.0)
-        cleanImpact = ofMap(impactDelta, 0.05, 0.5, 0.0, 1.0, true);
+    // Folder scan finished without a single clip
+    if (bScanPending && !library.isScanning()) {
+        bScanPending = false;
+        ofLogNotice() << "Videos found: " << library.getNumClips();
+        if (library.getNumClips() == 0) ofSystemAlertDialog("Error: No videos found in that folder.");
     }
 
-    // Define target values for Zoom and RGB Shift
-    float targetZoom = 1.0f + (cleanImpact * 0.35f);
-    float targetRGB = cleanImpact * 120.0f; // Maximum bloom for RGB shift
+    if (!isLive) return;
 
-    // Asymmetric Smoothing for Zoom
-    if (targetZoom > zoomValue) {
-        zoomValue = ofLerp(zoomValue, targetZoom, 0.4f); // Fast Attack
-    } else {
-        zoomValue = ofLerp(zoomValue, 1.0f, 0.08f);    // Slow Release
+    // --- FRAME SHARING ---
+    // Readbacks queued by earlier frames go out as soon as the GPU has finished them
+    if (tglShareFrames && !frameShare.isRunning()) frameShare.start();
+    else if (!tglShareFrames && frameShare.isRunning()) frameShare.stop();
+    frameShare.publish();
+
+    // --- CLOCK ---
+    // Live frames take as long as they take. Offline every frame is exactly 1/fps and the audio
+    // up to its end is analysed before anything reads it.
+    float dt = bOfflineRender ? 1.0f / offlineSettings.fps : (float)ofGetLastFrameTime();
+    if (bOfflineRender && !feedOfflineAudio()) {
+        finishOfflineRender();
+        return;
+    }
+    sceneTime = bOfflineRender ? (double)offlineFrame / offlineSettings.fps : ofGetElapsedTimef();
+    bOfflineStepped = bOfflineRender;
+
+    // --- REALTIME AUDIT ---
+    // Live frames are one section each, from here to the end of draw()
+    if (!bOfflineRender) {
+        updateAudit(dt);
+        RealtimeAudit::begin(RealtimeAudit::SECTION_FRAME);
     }
 
-	// Create a trigger for the invert that decays over time
-	//if (subBass > smoothedLowMids + 0.4f && strobeTimer <= 0.0f) {
-	//	invertActive = true; 
-	//} else {
-	//	invertActive = false;
-	//}
+    // --- PROFILING ---
+    // The previous frame has been swapped by now, which closes its audio-to-screen latency
+    profiler.setEnabled(tglProfiler);
+    profiler.beginFrame();
+    if (profiler.isEnabled() && renderedAudioTime > 0.0) {
+        profiler.addSample(profLatency, (float)((AudioAnalyzer::now() - renderedAudioTime) * 1000.0));
+    }
+    ProfileScope updateScope(profiler, profUpdate);
+
+    // --- QUALITY ---
+    // Last frame's interval and work against the budget: one level cheaper when it runs over,
+    // one back once the headroom lasts. Renders keep full quality, time is not an issue there.
+    workStartMicros = ofGetElapsedTimeMicros();
+    if (!bOfflineRender && tglGovernor) {
+        float gpuMs = 0.0f;
+        for (int i = 0; i < RenderGraph::NUM_PASSES; i++) gpuMs += renderGraph.getGpuMs((RenderGraph::Pass)i);
+        if (governor.update(dt * 1000.0f, cpuWorkMs, gpuMs)) {
+            ofLogNotice() << "QUALITY: level " << governor.getLevelIndex() << " (" << governor.getLevel().name << "), " << governor.getReason();
+        }
+    } else if (governor.getLevelIndex() != 0) {
+        governor.reset();
+        ofLogNotice() << "QUALITY: governor off, full quality";
+    }
 
-    // Asymmetric Smoothing for RGB Shift (The RGB Fix)
-    // This prevents the color channels from flickering too aggressively
-    if (targetRGB > smoothedRGBShift) {
-        smoothedRGBShift = ofLerp(smoothedRGBShift, targetRGB, 0.5f); // Instant snap
-    } else {
-        smoothedRGBShift = ofLerp(smoothedRGBShift, 0.0f, 0.1f);      // Smooth fade
+    // --- AUDIO FRAME ---
+    // Read one complete band frame, interpolated for when this frame hits the screen. The
+    // sample time trails the present by the analysis-to-render delay: live that is the render
+    // lead plus how old the newest analysis frame gets (it arrives with its device buffer) and
+    // a hop, offline the frames run up to the present time and one hop back is between two.
+    ProfileScope audioScope(profiler, profAudioFrame);
+    analyzer.setGain(sldAudioGain);
+    analyzer.pollFrames();
+    // New spectrum rows into the history texture, a few rows per frame
+    spectrogram.update(analyzer);
+    std::copy(spectrogram.getLatestRow(), spectrogram.getLatestRow() + spectrogram.getBins(), fftBins.begin()); // Both sized in setup()
+    double presentTime = bOfflineRender ? (double)(offlineFrame + 1) / offlineSettings.fps : AudioAnalyzer::now() + dt;
+    double renderDelay = bOfflineRender ? analyzer.getFrameInterval() : dt + analyzer.getFrameDelay();
+    BandFrame frame = analyzer.sampleAt(presentTime - renderDelay);
+    renderedAudioTime = frame.time - analyzer.getSettings().inputLatency;
+    subBass = frame.bands[BAND_SUB_BASS];
+    lowMids = frame.bands[BAND_LOW_MIDS];
+    mids = frame.bands[BAND_MIDS];
+    highMids = frame.bands[BAND_HIGH_MIDS];
+    treble = frame.bands[BAND_TREBLE];
+    stereoWidth = frame.stereoWidth;
+
+    audioScope.stop();
+
+    // --- REACTIVE ENVELOPES ---
+    // Beat clock, kick impact / strobe and the modulation matrix (ReactiveState, shared with
+    // the offline analysis). Integrates the real frame time, so it looks the same at any frame rate.
+    float onsetStrength[NUM_BANDS];
+    unsigned int onsets = analyzer.consumeOnsets(onsetStrength);
+    ProfileScope modulationScope(profiler, profModulation);
+    reactive.update(frame, presentTime, onsets, onsetStrength, dt);
+    if (!bOfflineRender) checkModulationReload(dt); // A render uses the mapping it started with
+    modulationScope.stop();
+    checkAudioStability(dt); // May reopen the stream, not part of the modulation cost
+    if (!isLive) { // The input could not be reopened
+        RealtimeAudit::end();
+        return;
     }
 
+    // --- SECTION ENERGY ---
+    // Recent loudness against the long-term average: busy sections get high-motion clips
+    float energy = (subBass + lowMids + mids + highMids + treble) / NUM_BANDS;
+    sectionEnergy = ModulationMatrix::smoothTowards(sectionEnergy, energy, 8.0f, dt);
+    averageEnergy = ModulationMatrix::smoothTowards(averageEnergy, energy, 60.0f, dt);
+    energyLevel = ofClamp(0.5f * sectionEnergy / std::max(averageEnergy, 1e-4f), 0.0f, 1.0f);
+
     // --- GENERAL SMOOTHING ---
     // Gradually update the baseline to follow long-term volume changes
-    smoothedLowMids = ofLerp(smoothedLowMids, (float)lowMids, 0.05f);
-    smoothedHue = ofLerp(smoothedHue, hueValue, 0.05f);
-
-    // End-of-video check and random reload
-    if (video.isLoaded() && video.getIsMovieDone()) {
-        ofLogNotice() << "MOVIE DONE TRIGGER";
-        loadRandomVideo();
+    smoothedHue = ModulationMatrix::smoothTowards(smoothedHue, hueValue, 0.33f, dt);
+
+    // --- MOSH STYLE ---
+    // Next style every 32 beats once the tempo is locked, otherwise drift with time
+    int style = (reactive.beatConfidence > 0.5f) ? (int)fmod(floor(reactive.beatClock / 32.0), (double)ShaderCache::NUM_STYLES)
+                                        : (int)fmod(sceneTime * 0.06, (double)ShaderCache::NUM_STYLES);
+    if (style != moshStyle) {
+        previousStyle = moshStyle;
+        moshStyle = style;
+        styleBlend = 0.0f;
     }
+    styleBlend = std::min(1.0f, styleBlend + dt / std::max(styleFadeTime, 0.001f));
+    if (!bOfflineRender) moshShaders.checkReload(dt);
+
+    // --- CLIPS ---
+    // Advances playback, prefetches the next clip and crossfades when the current one runs out
+    // Playback rate, reverse and stutter follow the music (clipRate, clipReverse, clipStutter)
+    // Every layer does the same, as many as the memory budget and the quality level allow
+    ProfileScope clipsScope(profiler, profClips);
+    ClipDeck & base = clips.getBase();
+    base.transportControls.rate = reactive.modulation.get(MOD_DST_CLIP_RATE);
+    base.transportControls.reverse = reactive.modulation.get(MOD_DST_CLIP_REVERSE) > 0.5f;
+    base.transportControls.stutter = reactive.modulation.get(MOD_DST_CLIP_STUTTER) > 0.5f;
+    clips.maxLayers = bOfflineRender ? offlineSettings.layers : std::min((int)sldLayers, governor.getLevel().maxLayers);
+    clips.maxClipHeight = governor.getLevel().maxClipHeight;
+    clips.update(dt, frame, presentTime);
 }
 
 void ofApp::draw() {
-    updateStartButtonLabel();
-
     // If not live, clear the screen and show settings
     if (!isLive) {
         ofSetBackgroundAuto(true);
         ofBackground(40); // Dark grey settings background
         gui.draw();
+        RealtimeAudit::end(); // No frame section outside a session, in case one is open
         return;
     }
     
+    ProfileScope drawScope(profiler, profDraw);
+
     // Check if we are ready. If not, draw black and stop.
-    if (!video.isLoaded() || !video.getTexture().isAllocated()) {
+    if (!clips.isReady()) {
+        if (bOfflineStepped) {
+            bOfflineStepped = false;
+            captureOfflineFrame();
+        }
         ofSetBackgroundAuto(true);
         ofBackground(0);
         guiLive.draw();
+        RealtimeAudit::end();
         return;
     }
 
-    // DYNAMIC MOTION BLUR (Reactive Alpha)
-    float blurAmount = ofMap(mids, 0.2, 0.8, 80, 15, true);
-    ofSetBackgroundAuto(false);
-    ofSetColor(0, 0, 0, blurAmount);
-    ofDrawRectangle(0, 0, ofGetWidth(), ofGetHeight());
-
-    if (!video.isLoaded() || !video.getTexture().isAllocated()) return;
+    // Internal resolution follows the window unless a fixed render height is set
+    if (bOfflineRender) renderGraph.allocate(offlineSettings.width, offlineSettings.height, 0);
+    else {
+        // The governor scales the configured height (the window's when 0)
+        const QualityGovernor::Level & quality = governor.getLevel();
+        int renderHeight = quality.renderScale < 1.0f ? (int)((sldRenderHeight > 0 ? sldRenderHeight : ofGetHeight()) * quality.renderScale) : (int)sldRenderHeight;
+        renderGraph.allocate(ofGetWidth(), ofGetHeight(), renderHeight);
+    }
+    renderGraph.setEnabled(RenderGraph::PASS_FEEDBACK, tglFeedback && governor.getLevel().feedback);
+    renderGraph.setEnabled(RenderGraph::PASS_FLASH, tglFlash);
+    renderGraph.setEnabled(RenderGraph::PASS_SCANLINES, tglScanlines && governor.getLevel().scanlines);
+    float w = renderGraph.getWidth();
+    float h = renderGraph.getHeight();
+
+    // Frames arrive through the deck's PBO streams, Y + UV planes when the player gives NV12
+    VideoTextureStream & video = clips.getBase().getCurrentStream();
+    VideoTextureStream & incoming = clips.getBase().getIncomingStream();
+    ofTexture & videoTexture = video.getTexture();
+
+    // --- SCENE PASS (video + mosh shader) ---
+    if (moshShaders.isLoaded() && renderGraph.begin(RenderGraph::PASS_SCENE)) {
+        ofPushMatrix();
+        ofTranslate(w / 2, h / 2);
+
+        // JITTER
+        float jitter = reactive.modulation.get(MOD_DST_JITTER);
+        sceneView.offsetX = sceneView.offsetY = 0.0f;
+        if (jitter > 0.01) {
+            sceneView.offsetX = rng.uniform(-jitter, jitter);
+            sceneView.offsetY = rng.uniform(-jitter, jitter);
+            ofTranslate(sceneView.offsetX, sceneView.offsetY);
+        }
 
-    // IMPACT LOGIC
-    float impactDelta = std::max(0.0f, (float)lowMids - (smoothedLowMids + 0.1f));
+        // BOUNCE (Unified Scale Fixes Y-Bounce)
+        float bounceScale = reactive.modulation.get(MOD_DST_BOUNCE);
+        float zoom = reactive.modulation.get(MOD_DST_ZOOM);
+        sceneView.scale = zoom * bounceScale;
+        ofScale(zoom * bounceScale, zoom * bounceScale);
+
+        // Fill the reactive block and upload it in one go instead of a lookup per uniform
+        uniforms.time = (float)sceneTime;
+        uniforms.beatClock = (float)fmod(reactive.beatClock, 4096.0);
+        uniforms.beatConfidence = reactive.beatConfidence;
+        uniforms.subBass = subBass;
+        uniforms.lowMids = lowMids;
+        uniforms.mids = mids;
+        uniforms.highMids = highMids;
+        uniforms.treble = treble;
+        uniforms.pixelSize = reactive.modulation.get(MOD_DST_PIXEL_SIZE);
+        uniforms.rgbShift = reactive.modulation.get(MOD_DST_RGB_SHIFT);
+        uniforms.impactDelta = reactive.impactDelta;
+        uniforms.lowThresh = reactive.modulation.get(MOD_DST_LOW_THRESH);
+        uniforms.highThresh = reactive.modulation.get(MOD_DST_HIGH_THRESH);
+        uniforms.invertToggle = reactive.modulation.get(MOD_DST_INVERT) > 0.5f ? 1 : 0;
+        uniforms.res[0] = videoTexture.getWidth();
+        uniforms.res[1] = videoTexture.getHeight();
+        uniforms.res1[0] = incoming.getTexture().getWidth();
+        uniforms.res1[1] = incoming.getTexture().getHeight();
+        uniforms.yuv0 = video.isYuv() ? 1 : 0;
+        uniforms.yuv1 = incoming.isYuv() ? 1 : 0;
+        uniforms.crossfade = clips.getBase().getCrossfade();
+        uniforms.spectrumBins = spectrogram.getBins();
+        uniforms.spectrogramRows = spectrogram.getRows();
+        uniforms.spectrogramHead = spectrogram.getHead();
+
+        // LAYERS
+        // Overlays the music has faded in, each through the same pass. Hidden ones are skipped
+        // in the shader and bound to the base clip so no sampler points at a stale texture.
+        VideoTextureStream * layerStreams[ReactiveUniforms::MAX_OVERLAYS];
+        for (int i = 0; i < ReactiveUniforms::MAX_OVERLAYS; i++) {
+            int layer = i + 1;
+            float opacity = clips.getVisibility(layer) * ofClamp(reactive.modulation.get((ModTarget)(MOD_DST_LAYER1 + i)), 0.0f, 1.0f);
+            VideoTextureStream & stream = clips.getStream(layer);
+            bool visible = opacity > 0.001f && stream.isAllocated();
+            uniforms.layerOpacity[i] = visible ? opacity : 0.0f;
+            uniforms.layerMosh[i] = clips.layers[layer].mosh;
+            uniforms.layerBlend[i] = clips.layers[layer].blend;
+            uniforms.layerYuv[i] = visible && stream.isYuv() ? 1 : 0;
+            uniforms.layerRes[i][0] = visible ? stream.getTexture().getWidth() : uniforms.res[0];
+            uniforms.layerRes[i][1] = visible ? stream.getTexture().getHeight() : uniforms.res[1];
+            layerStreams[i] = visible ? &stream : &video;
+        }
 
-    ofPushMatrix();
-    ofTranslate(ofGetWidth() / 2, ofGetHeight() / 2);
-
-    // JITTER
-    float jitter = ofMap(highMids, 0.3, 1.0, 0.0, 0.3, true);
-    if (jitter > 0.01) ofTranslate(ofRandom(-jitter, jitter), ofRandom(-jitter, jitter));
-
-    // BOUNCE (Unified Scale Fixes Y-Bounce)
-    float bounceScale = 1.0 + (impactDelta * 18.0);
-    ofScale(zoomValue * bounceScale, zoomValue * bounceScale);
-
-    shader.begin();
-    // Bind video texture and elapsed time to shader
-    shader.setUniformTexture("tex0", video.getTexture(), 0);
-    shader.setUniform1f("time", ofGetElapsedTimef());
-
-    // Map audio frequencies to shader parameters
-    shader.setUniform1f("pixelSize", ofMap(treble, 0.1, 1.2, 1.0, 14.0, true));
-    shader.setUniform1f("rgbShift", subBass * 8.0 + (impactDelta * 120.0));
-    shader.setUniform1f("impactDelta", impactDelta);
-    shader.setUniform1f("subBass", subBass);
-    shader.setUniform1f("lowMids", lowMids);
-    shader.setUniform1f("mids", mids);
-    shader.setUniform1f("highMids", highMids);
-    shader.setUniform1f("treble", treble);
-    shader.setUniform1f("lowThresh", 0.10f); // Patterns trigger earlier
-    shader.setUniform1f("highThresh", 0.80f); // Blocks trigger earlier
-    shader.setUniform2f("res", (float)video.getWidth(), (float)video.getHeight());
-
-    // INVERT (High-bass trigger)
-    bool subInvert = (subBass > 0.8f);
-    shader.setUniform1i("invertToggle", subInvert ? 1 : 0);
-
-    // HSB COLOR PULSE
-    float br = ofMap(highMids, 0.2, 0.8, 150, 190, true);
-    ofSetColor(ofColor::fromHsb(fmod(smoothedHue, 255.0), 160, br));
-
-    // SLICING
-    if (mids > 0.25) {
-        int numSlices = (int)ofMap(mids, 0.25, 1.0, 16, 64, true);
-        float maxShift = ofMap(mids, 0.25, 1.0, 0.5, 4.0, true);
-        
-        // Use video dimensions for math to prevent scaling drift
-        float sliceHeightDest = (float)ofGetHeight() / numSlices;
-        float sliceHeightSrc = (float)video.getHeight() / numSlices;
-        float halfW = (float)ofGetWidth() / 2.0;
-        float halfH = (float)ofGetHeight() / 2.0;
-
-        for (int i = 0; i < numSlices; i++) {
-            float xOffset = ofRandom(-maxShift, maxShift);
-            
-            video.getTexture().drawSubsection(
-                -halfW + xOffset,          // Destination X (Centered)
-                -halfH + (i * sliceHeightDest), // Destination Y (Centered)
-                ofGetWidth(),              // Destination Width
-                sliceHeightDest,           // Destination Height
-                0,                         // Source X
-                i * sliceHeightSrc,        // Source Y
-                video.getWidth(),          // Source Width
-                sliceHeightSrc             // Source Height
-            );
+        // SLICING
+        // Per-slice horizontal offsets go into the block and the shader shifts each band,
+        // so the whole frame is still one quad. Offsets are converted to source texels.
+        float slice = reactive.modulation.get(MOD_DST_SLICE);
+        uniforms.numSlices = 0;
+        if (slice > 0.25) {
+            uniforms.numSlices = std::min((int)ofMap(slice, 0.25, 1.0, 16, ReactiveUniforms::MAX_SLICES, true), governor.getLevel().maxSlices);
+            float maxShift = ofMap(slice, 0.25, 1.0, 0.5, 4.0, true);
+            float texelsPerUnit = videoTexture.getWidth() / w;
+            for (int i = 0; i < uniforms.numSlices; i++)
+                uniforms.sliceOffsets[i] = rng.uniform(-maxShift, maxShift) * texelsPerUnit;
         }
-    } else {
-        ofSetColor(255);
-        video.getTexture().draw(-ofGetWidth()/2, -ofGetHeight()/2, ofGetWidth(), ofGetHeight());
+        uniformBuffer.updateData(0, sizeof(uniforms), &uniforms);
+        uniformBuffer.bindBase(GL_UNIFORM_BUFFER, ReactiveUniforms::BINDING);
+
+        // One specialised program per style, or the pair being blended during a style change
+        bool styleFading = styleBlend < 1.0f;
+        ofShader & shader = styleFading ? moshShaders.getTransition(previousStyle, moshStyle) : moshShaders.get(moshStyle);
+        shader.begin();
+        if (styleFading) shader.setUniform1f("styleMix", styleBlend);
+        // Bind video textures to shader, tex1 is the incoming clip during a crossfade
+        shader.setUniformTexture("tex0", videoTexture, 0);
+        shader.setUniformTexture("tex1", incoming.getTexture(), 1);
+        shader.setUniformTexture("tex0uv", video.getChromaTexture(), 2);
+        shader.setUniformTexture("tex1uv", incoming.getChromaTexture(), 3);
+        if (spectrogram.isAllocated()) shader.setUniformTexture("spectrogram", spectrogram.getTexture(), 4);
+        for (int i = 0; i < ReactiveUniforms::MAX_OVERLAYS; i++) {
+            shader.setUniformTexture(layerSamplers[i][0], layerStreams[i]->getTexture(), 5 + i * 2);
+            shader.setUniformTexture(layerSamplers[i][1], layerStreams[i]->getChromaTexture(), 6 + i * 2);
+        }
+
+        // HSB COLOR PULSE
+        float br = reactive.modulation.get(MOD_DST_BRIGHTNESS);
+        ofSetColor(ofColor::fromHsb(fmod(smoothedHue, 255.0), 160, br));
+
+        // The HSB tint only applies while slicing, as it always has
+        if (uniforms.numSlices == 0) ofSetColor(255);
+        videoTexture.draw(-w / 2, -h / 2, w, h);
+        shader.end();
+        renderGraph.addDrawCalls(1);
+
+        ofPopMatrix();
+        renderGraph.end();
+        if (softwareMosh && bOfflineStepped) verifySceneOnCpu(styleFading ? previousStyle : moshStyle, styleFading ? moshStyle : -1, styleBlend);
     }
-    shader.end();
 
-    // IMPACT OVERLAY
-    if (strobeTimer > 0.0f) {
-        ofSetColor(255, 255, 255, strobeTimer * 40.0f);
-        ofDrawRectangle(-ofGetWidth() / 2, -ofGetHeight() / 2, ofGetWidth(), ofGetHeight());
+    // --- FEEDBACK PASS (Reactive motion blur) ---
+    // The previous output fades by the blur alpha, the old black-rectangle-over-backbuffer trick
+    renderGraph.feedback(reactive.modulation.get(MOD_DST_BLUR_ALPHA) / 255.0f);
+
+    // --- IMPACT OVERLAY ---
+    if (reactive.strobeTimer > 0.0f && renderGraph.begin(RenderGraph::PASS_FLASH)) {
+        ofPushStyle();
+        ofEnableAlphaBlending();
+        ofSetColor(255, 255, 255, reactive.strobeTimer * 40.0f);
+        ofDrawRectangle(0, 0, w, h);
+        ofPopStyle();
+        renderGraph.addDrawCalls(1);
+        renderGraph.end();
     }
 
-    ofPopMatrix();
+    // --- CRT SCANLINES ---
+    // Procedural: one full-screen quad, the shader darkens every fourth row
+    if (renderGraph.begin(RenderGraph::PASS_SCANLINES)) {
+        ofPushStyle();
+        ofEnableAlphaBlending();
+        scanlineShader.begin();
+        scanlineShader.setUniform1f("lineAlpha", 25.0f / 255.0f);
+        scanlineShader.setUniform1f("lineSpacing", 4.0f);
+        ofDrawRectangle(0, 0, w, h);
+        scanlineShader.end();
+        ofPopStyle();
+        renderGraph.addDrawCalls(1);
+        renderGraph.end();
+    }
 
-    // CRT SCANLINES
-    ofSetColor(0, 0, 0, 25);
-    for (int i = 0; i < ofGetHeight(); i += 4)
-        ofDrawLine(0, i, ofGetWidth(), i);
+    // --- OFFLINE CAPTURE ---
+    // Read back the finished frame at render resolution, the window and HUD are not part of it
+    if (bOfflineStepped) {
+        bOfflineStepped = false;
+        captureOfflineFrame();
+    }
+
+    // --- FRAME SHARING ---
+    if (frameShare.isRunning()) {
+        frameShare.capture(renderGraph.getOutput(), SharedFrameRing::nowMicros());
+        if (!frameShare.isRunning()) tglShareFrames = false; // Could not create the segment
+    }
+
+    // --- PRESENT ---
+    ofBackground(0);
+    renderGraph.present(0, 0, ofGetWidth(), ofGetHeight());
+    if (bOfflineRender) return;
+    if (profiler.isEnabled()) {
+        for (int i = 0; i < RenderGraph::NUM_PASSES; i++) {
+            profiler.addSample(profCpuPass + i, renderGraph.getCpuMs((RenderGraph::Pass)i));
+            profiler.addSample(profGpuPass + i, renderGraph.getGpuMs((RenderGraph::Pass)i));
+        }
+    }
 
     // HUD & GUI (Menu Logic)
+    ProfileScope hudScope(profiler, profHud);
     drawVisualizerHUD();
+    drawRenderStats();
     guiLive.draw();
     drawEventCredits(); // credits
+    cpuWorkMs = (ofGetElapsedTimeMicros() - workStartMicros) / 1000.0f;
+    RealtimeAudit::end();
+}
+
+void ofApp::drawRenderStats() {
+    ofPushStyle();
+
+    // Per-pass CPU / GPU milliseconds, the audio input, decode, quality and layers, bottom right
+    bool auditing = RealtimeAudit::isEnabled();
+    int rows = RenderGraph::NUM_PASSES + 4 + (frameShare.isRunning() ? 1 : 0) + (auditing ? 1 : 0);
+    float x = ofGetWidth() - 230;
+    float y = ofGetHeight() - 20 - rows * 14;
+    ofSetColor(0, 0, 0, 180);
+    ofDrawRectRounded(x - 10, y - 24, 220, rows * 14 + 34, 8);
+
+    ofSetColor(255);
+    ofDrawBitmapString(formatHud("%dx%d  %d draws cpu/gpu", renderGraph.getWidth(), renderGraph.getHeight(), renderGraph.getDrawCalls()), x, y - 6, 0.0f);
+    for (int i = 0; i < RenderGraph::NUM_PASSES; i++) {
+        RenderGraph::Pass pass = (RenderGraph::Pass)i;
+        ofSetColor(renderGraph.isEnabled(pass) ? 200 : 90);
+        ofDrawBitmapString(formatHud("%s %.2f / %.2f", RenderGraph::getPassName(pass), renderGraph.getCpuMs(pass), renderGraph.getGpuMs(pass)), x, y + 10 + i * 14, 0.0f);
+    }
+
+    // Buffer size and latency it adds, measured callback period, xruns since the stream opened,
+    // how far back the bands are sampled and the render frames that got no blend
+    uint64_t xruns = audioMonitor.getXruns();
+    ofSetColor(xruns > 0 ? ofColor(255, 120, 80) : ofColor(200));
+    ofDrawBitmapString(formatHud("audio %d %.1fms/%.1f xr %llu -%.0fms held %llu", audioMonitor.getBufferSize(), audioMonitor.getBufferLatencyMs(), audioMonitor.getPeriodMs(),
+                                 (unsigned long long)xruns, analyzer.getFrameDelay() * 1000.0, (unsigned long long)analyzer.getHeldSamples()),
+                       x, y + 10 + RenderGraph::NUM_PASSES * 14, 0.0f);
+
+    // Decode-ahead plan frames cached, worker decode time (peak over a second), due frames not
+    // decoded in time, seeks, and what the transport is doing
+    ClipDeck::DecodeStats decode = clips.getBase().getDecodeStats();
+    ofSetColor(decode.capacity > 0 && decode.queued == 0 ? ofColor(255, 120, 80) : ofColor(200));
+    ofDrawBitmapString(formatHud("decode %d/%d %.1fms un %llu sk %llu %lluMB j%d%s%s", decode.queued, decode.capacity, decode.decodePeakMs,
+                                 (unsigned long long)decode.underruns, (unsigned long long)decode.seeks, (unsigned long long)(decode.bytes >> 20),
+                                 decode.jumps, decode.reversed ? " rev" : "", decode.stuttering ? " stut" : ""),
+                       x, y + 10 + (RenderGraph::NUM_PASSES + 1) * 14, 0.0f);
+
+    // Quality level the governor holds, and the frame / work percentiles it decided on
+    int level = governor.getLevelIndex();
+    ofSetColor(level > 0 ? ofColor(255, 180, 80) : ofColor(200));
+    ofDrawBitmapString(formatHud("quality %d %s %.1f/%.1fms", level, governor.getLevel().name, governor.getFramePercentile(), governor.getWorkPercentile()),
+                       x, y + 10 + (RenderGraph::NUM_PASSES + 2) * 14, 0.0f);
+
+    // Clip layers running of those planned, the clip height they are held to, the estimate and
+    // what the decks actually hold
+    const LayerBudget::Plan & layerPlan = clips.getPlan();
+    ofSetColor(clips.getNumLayers() < (int)sldLayers ? ofColor(255, 180, 80) : ofColor(200));
+    ofDrawBitmapString(formatHud("layers %d/%d %dp est %lluMB held %lluMB", clips.getNumLayers(), (int)sldLayers, layerPlan.maxClipHeight,
+                                 (unsigned long long)(layerPlan.bytes >> 20), (unsigned long long)(clips.getMemoryBytes() >> 20)),
+                       x, y + 10 + (RenderGraph::NUM_PASSES + 3) * 14, 0.0f);
+    int row = RenderGraph::NUM_PASSES + 4;
+
+    // Frames handed to shared memory, dropped while the readbacks were still in flight
+    if (frameShare.isRunning()) {
+        ofSetColor(frameShare.getDropped() > 0 ? ofColor(255, 120, 80) : ofColor(200));
+        ofDrawBitmapString(formatHud("shm %llu drop %llu %.2fms +%.0ff", (unsigned long long)frameShare.getPublished(), (unsigned long long)frameShare.getDropped(),
+                                     frameShare.getCopyMs(), frameShare.getReadbackFrames()),
+                           x, y + 10 + row++ * 14, 0.0f);
+    }
+
+    // Allocations + locks in the audio callback and analysis hops, frames that allocated
+    if (auditing) {
+        RealtimeAudit::Totals audit = RealtimeAudit::getTotals();
+        ofSetColor(RealtimeAudit::passed(audit) ? ofColor(200) : ofColor(255, 120, 80));
+        ofDrawBitmapString(formatHud("audit au %llu an %llu fr %llu/%llu",
+                                     (unsigned long long)(audit.events[RealtimeAudit::SECTION_AUDIO][RealtimeAudit::KIND_ALLOCATION] +
+                                                          audit.events[RealtimeAudit::SECTION_AUDIO][RealtimeAudit::KIND_LOCK]),
+                                     (unsigned long long)(audit.events[RealtimeAudit::SECTION_ANALYSIS][RealtimeAudit::KIND_ALLOCATION] +
+                                                          audit.events[RealtimeAudit::SECTION_ANALYSIS][RealtimeAudit::KIND_LOCK]),
+                                     (unsigned long long)audit.flagged[RealtimeAudit::SECTION_FRAME], (unsigned long long)audit.sections[RealtimeAudit::SECTION_FRAME]),
+                           x, y + 10 + row++ * 14, 0.0f);
+    }
+
+    ofPopStyle();
 }
 
 void ofApp::drawEventCredits() {
@@ -490,7 +1124,11 @@ void ofApp::drawEventCredits() {
 
     ofScale(1.5, 1.5);
     
-    ofDrawBitmapStringHighlight("Visual tool by @cognitoni", 0, 0, ofColor(0, 200), ofColor(255));
+    // ofDrawBitmapStringHighlight's box (8px glyphs, 4px padding) without the copies it makes of the text
+    ofSetColor(0, 200);
+    ofDrawRectangle(-4, -14, creditsText.size() * 8 + 8, 20);
+    ofSetColor(255);
+    ofDrawBitmapString(creditsText, 0, 0, 0.0f);
     
     ofPopMatrix();
     ofPopStyle();
@@ -543,7 +1181,14 @@ void ofApp::drawVisualizerHUD() {
 
     // Label
     ofSetColor(255);
-    ofDrawBitmapString("GAIN: " + ofToString((float)sldAudioGain, 1), xBase, sliderY + 25);
+    ofDrawBitmapString(formatHud("GAIN: %.1f", (float)sldAudioGain), xBase, sliderY + 25, 0.0f);
+
+    // Video upload cost, peak over the last second (a stalling upload shows up here)
+    ofSetColor(clips.getUploadPeakMs() > 4.0f ? ofColor(255, 120, 80) : ofColor(160));
+    ofDrawBitmapString(formatHud("UP %.2fms", clips.getUploadPeakMs()), xBase + 95, sliderY + 25, 0.0f);
+
+    // Optional profiler graphs, stacked above the bands
+    profiler.draw(xBase, yBase - 24 - profiler.getNumStages() * 14);
 
     ofPopStyle();
 }
@@ -573,31 +1218,3 @@ void ofApp::mouseDragged(int x, int y, int button) {
         }
     }
 }
-
-void ofApp::loadRandomVideo() {
-    if (videoFiles.empty()) return;
-    
-    // Release hardware decoder and GPU texture resources
-    video.stop();
-    video.setUseTexture(false); // Force dump of the GPU texture handle
-    if (video.isLoaded()) {
-        video.closeMovie();
-    }
-
-    bIsLoading = false;
-    bPendingLoad = false;
-    int idx = floor(ofRandom(videoFiles.size()));
-
-    // Re-enable textures before loading new file
-    video.setUseTexture(true); 
-    bool loaded = video.load(videoFiles[idx]);
-    if (!loaded) {
-        ofLogError() << "FAILED TO LOAD VIDEO: " << videoFiles[idx];
-        return;
-    }
-
-    video.setLoopState(OF_LOOP_NONE);
-    video.play();
-	video.setVolume(0);
-    ofLogNotice() << "STARTING VIDEO: " << videoFiles[idx];
-}
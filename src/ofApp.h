@@ -1,8 +1,26 @@
 #pragma once
 #include "ofMain.h"
 #include "ofxGui.h"
-#include "ofxFft.h"
-#include <atomic>
+#include "ofxJSON.h"
+#include "AudioAnalyzer.h"
+#include "ModulationFile.h"
+#include "ReactiveState.h"
+#include "ClipLayers.h"
+#include "VideoLibrary.h"
+#include "RenderGraph.h"
+#include "ReactiveUniforms.h"
+#include "ShaderCache.h"
+#include "Profiler.h"
+#include "AudioInputMonitor.h"
+#include "VirtualAudioInput.h"
+#include "OfflineRender.h"
+#include "SeededRandom.h"
+#include "SoftwareMosh.h"
+#include "FrameShare.h"
+#include "SpectrogramTexture.h"
+#include "QualityGovernor.h"
+#include "RealtimeAudit.h"
+#include <filesystem>
 
 class ofApp : public ofBaseApp {
 public:
@@ -12,6 +30,7 @@ public:
 	~ofApp(); // Destructor for proper cleanup
 	void drawVisualizerHUD();
 	void drawEventCredits();
+	void drawRenderStats();
 	void mousePressed(int x, int y, int button);
 	void mouseDragged(int x, int y, int button);
 	void audioIn(ofSoundBuffer & input);
@@ -20,12 +39,27 @@ public:
 	ofxPanel gui;
 	ofxPanel guiLive;
 	ofxButton btnSelectFolder;
+	ofxButton btnAudioBackend; // Cycles the platform's audio APIs (Linux: Pulse/PipeWire, ALSA, JACK)
 	ofxLabel lblFolderPath;
 	ofxButton btnStart;
 	ofxButton btnStop;
 	ofxLabel lblDeviceHeader;
 	ofxLabel lblSpacer;
 	ofxFloatSlider sldAudioGain;
+	ofxIntSlider sldInputLeft; // 1-based device channels fed to the analyzer
+	ofxIntSlider sldInputRight; // 0 = mono source
+	ofxIntSlider sldChannelMode; // ChannelMode: 0 mono, 1 left/right, 2 mid/side
+	ofxIntSlider sldRenderHeight; // Internal render height, 0 = window
+	ofxIntSlider sldDecodeAhead; // Frames decoded ahead per clip, 0 = decode in update()
+	ofxIntSlider sldLayers; // Clips on screen at once (ClipLayers), 1 = the base clip only
+	ofxToggle tglFeedback;
+	ofxToggle tglFlash;
+	ofxToggle tglScanlines;
+	ofxToggle tglProfiler;
+	ofxToggle tglShareFrames; // Finished frames to shared memory for a local encoder (FrameShare)
+	ofxToggle tglGovernor; // Adaptive quality (QualityGovernor), live only
+	ofxToggle tglAudit; // Realtime audit (RealtimeAudit), report written when switched off
+	ofxButton btnExportProfile;
 
 	// GUI - Input Selection
 	vector<ofxToggle *> deviceToggles;
@@ -41,40 +75,130 @@ public:
 	// Audio & Analysis
 	ofSoundDevice::Api currentApi;
 	ofSoundStream soundStream;
-	ofShader shader;
-	ofxFft* fft; // You may need the ofxFft addon, or use ofSoundStream's internal if available
-	vector<float> fftBins;
-
-	// Frequencies (Used by Shader & Draw)
-	std::atomic<float> subBass{0.0f}; // Deep thumps
-	std::atomic<float> lowMids{0.0f}; // Kicks and bass guitar
-	std::atomic<float> mids{0.0f}; // Vocals and snare
-	std::atomic<float> highMids{0.0f}; // Lead instruments/shimmer
-	std::atomic<float> treble{0.0f}; // Cymbals/sharp noise
+	ofSoundDevice selectedAudioDevice; // Kept to reopen the stream with a larger buffer
+	AudioInputMonitor audioMonitor; // Callback period and xruns of the live input
+	VirtualAudioInput virtualInput; // WAV file or PCM pipe standing in for a sound card
+	string virtualInputPath;
+	bool bVirtualInput = false;
+	int audioBufferSize = 128; // Negotiated at start, doubled while the probe sees xruns
+	float audioProbeTimer = -1.0f; // Seconds the current buffer size has been watched, < 0 settled
+	// reopen: the analyzer keeps running through the new buffer size, only its latency changes
+	bool openAudioStream(int bufferSize, bool reopen = false);
+	void configureAnalyzer(int bufferSize, int sampleRate, int numChannels);
+	void setAudioBufferSize(int bufferSize, int sampleRate); // Latency, monitor and profiler period
+	void checkAudioStability(float dt);
+	static vector<ofSoundDevice::Api> getAvailableApis();
+	static string getApiName(ofSoundDevice::Api api);
+	ShaderCache moshShaders; // shader.frag specialised per style, hot-reloaded
+	ofShader scanlineShader; // scanlines.frag, procedural CRT lines
+	RenderGraph renderGraph; // scene -> feedback -> overlays -> present, offscreen
+	QualityGovernor governor; // Render scale, slices, passes and clip size under load
+	uint64_t workStartMicros = 0; // update() start
+	float cpuWorkMs = 0.0f; // update() start to the end of the last draw()
+	FrameShare frameShare; // Async readback of the output into a POSIX shm ring
+	ofBufferObject uniformBuffer; // ReactiveParams block, one upload per frame
+	ReactiveUniforms uniforms;
+	AudioAnalyzer analyzer; // FFT runs on its own thread, audioIn only feeds it
+	SpectrogramTexture spectrogram; // Spectrum rows per hop, ring texture for shader.frag
+	vector<float> fftBins; // Newest spectrum row (log-spaced columns), copied per update()
+
+	// Frequencies (Used by Shader & Draw), copied from one analyzer frame per update()
+	float subBass = 0.0f; // Deep thumps
+	float lowMids = 0.0f; // Kicks and bass guitar
+	float mids = 0.0f; // Vocals and snare
+	float highMids = 0.0f; // Lead instruments/shimmer
+	float treble = 0.0f; // Cymbals/sharp noise
+	float stereoWidth = 0.0f; // 0 mono .. 1 wide, only with a stereo input pair
 	float hueValue = 0;
 
-	float smoothedLowMids = 0.0f; // used to count headroom
-	float smoothedRGBShift = 0.0f; // Stores the decaying RGB bloom value
     bool invertActive = false;      // Tracks if the sub-bass inversion is triggered
 
 	// Video Handling
-	ofVideoPlayer video;
-	vector<string> videoFiles;
-	bool bNeedsNewVideo = false;
-	bool bIsLoading = false;
-	bool bPendingLoad = false;
-	void loadRandomVideo();
-	float zoomValue = 1.0f;
-	float strobeTimer = 0.0f;
+	ClipLayers clips; // Base clip and overlays, each playing one clip and prefetching the next off the render thread
+	VideoLibrary library; // Background index of the selected folder
+	bool bScanPending = false; // Report an empty folder once the scan finishes
+	float sectionEnergy = 0.0f; // Band energy over the last few seconds
+	float averageEnergy = 0.0f; // ... and over the last minute
+	float energyLevel = 0.5f; // 0 calm .. 1 busy, drives clip selection by motion
 
 	float smoothedHue = 0.0f;
 
+	// Everything random on screen (jitter, slicing, offline clip choice): time seeded live,
+	// fixed by --seed offline. sceneTime drives the shader clock and the style drift.
+	SeededRandom rng;
+	double sceneTime = 0.0;
+
+	// Offline render (--render): fixed timestep, audio read per frame from a file, clips decoded
+	// by timestamp, each frame read back and written as an image or to an encoder pipe
+	void setOfflineRender(const OfflineRenderSettings & settings); // Before ofRunApp()
+	bool bOfflineRender = false;
+	OfflineRenderSettings offlineSettings;
+	FrameWriter frameWriter;
+	ofPixels capturePixels;
+	vector<float> offlineAudio;
+	uint64_t offlineSamples = 0; // Audio frames fed to the analyzer
+	int offlineFrame = 0; // Frames written
+	bool bOfflineStepped = false; // update() advanced the clock, draw() owes a frame
+	uint64_t offlineStartMicros = 0;
+	void startOfflineRender();
+	bool feedOfflineAudio(); // False once the audio or --duration runs out
+	void captureOfflineFrame();
+	void finishOfflineRender();
+	string pickOfflineClip(const string & playing);
+
+	// --verify-cpu: every scene is rendered by the CPU port as well and diffed against the GPU
+	unique_ptr<SoftwareMosh> softwareMosh;
+	SoftwareMosh::View sceneView; // Zoom and jitter the scene quad was drawn with
+	ofPixels gpuScenePixels;
+	vector<uint8_t> cpuScene;
+	int verifyFrames = 0;
+	int verifyFramesOver = 0; // Frames with more than 1% of pixels over the tolerance
+	double verifyMeanSum = 0.0;
+	double verifyWorstMean = 0.0;
+	void verifySceneOnCpu(int styleA, int styleB, float styleMix);
+
+	// Mosh style: picked on the CPU, changes blend two style variants over styleFadeTime
+	int moshStyle = 0;
+	int previousStyle = 0;
+	float styleBlend = 1.0f; // 0..1 through a style change, 1 = settled
+	float styleFadeTime = 1.0f;
+
+	// Beat clock, impact/strobe and modulation (analysis features -> reactive parameters, see modulation.json)
+	ReactiveState reactive;
+	string modulationPath = "modulation.json";
+	std::filesystem::path modulationFile; // Resolved once, polled without building paths
+	std::filesystem::file_time_type modulationStamp;
+	float modulationCheckTimer = 0.0f;
+	bool loadModulation();
+	void checkModulationReload(float dt);
+
+	// Profiling (HUD graphs while tglProfiler is on, CSV + Chrome trace on export)
+	Profiler profiler;
+	int profUpdate, profAudioFrame, profModulation, profClips, profDraw, profHud, profLatency;
+	int profCpuPass; // First of RenderGraph::NUM_PASSES CPU stages
+	int profGpuPass; // ... and the GPU ones
+	double renderedAudioTime = 0.0; // Capture time of the audio behind the last drawn frame
+	void exportProfilePressed();
+
+	// Realtime audit: armed a moment after the toggle so the click itself is not counted,
+	// then every live frame is a section; the report goes to data/ when it is switched off
+	float auditArmTimer = -1.0f;
+	void updateAudit(float dt);
+	void writeAuditReport();
+
+	// HUD text is formatted into one reused string, drawing a line every frame allocates nothing.
+	// Draw it with ofDrawBitmapString(text, x, y, 0.0f): the 3-argument template copies it through ofToString.
+	string hudText;
+	const string & formatHud(const char * format, ...);
+	string creditsText = "Visual tool by @cognitoni";
+
 	// UI Event Handlers
 	void selectFolderPressed();
 	void startPressed();
 	void stopPressed();
 	void deviceButtonPressed(bool & val);
-	void updateStartButtonLabel();
+	void audioBackendPressed();
+	bool bRebuildGui = false; // Rebuild outside the button callback that asked for it
 	void buildSettingsGui();
 	bool startLiveSession(bool allowVideoLoad = true);
 	void stopLiveSession();